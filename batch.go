@@ -0,0 +1,82 @@
+package libsass
+
+import (
+	"io"
+
+	"github.com/wellington/go-libsass/libs"
+)
+
+// BatchEntry is a main file compiled by a Batch
+type BatchEntry struct {
+	// Path of the main Sass file
+	Path string
+	// Out receives the compiled CSS (again on every recompile)
+	Out io.Writer
+	// MapPath enables a source map written to this path
+	MapPath string
+
+	// ResolvedImports is the list of files used by this entry
+	ResolvedImports []string
+	// Err is set if the entry failed to compile
+	Err error
+}
+
+// Batch compiles many entries with the same options, functions and
+// importers. Partials are parsed once and shared between the entries.
+// The batch remembers the files each entry depends on, so a watcher
+// only needs to recompile the entries affected by a change.
+type Batch struct {
+	ctx     *compctx
+	batch   libs.SassBatch
+	entries []*BatchEntry
+}
+
+// NewBatch prepares the entries for compiling, call Close to free it
+func NewBatch(entries []*BatchEntry, opts ...FuncOpt) (*Batch, error) {
+	comp, err := New(nil, nil, opts...)
+	if err != nil {
+		return nil, err
+	}
+	c := comp.(*sass)
+	return &Batch{
+		ctx:     c.ctx,
+		batch:   c.ctx.batchInit(entries, c.sourceMapRoot),
+		entries: entries,
+	}, nil
+}
+
+// Compile compiles all entries, up to threads at the same time. The
+// error of the first failed entry is returned, every entry reports its
+// own in Err.
+func (b *Batch) Compile(threads int) error {
+	libs.SassCompileBatch(b.batch, threads)
+	_, err := b.ctx.batchResults(b.batch, b.entries)
+	return err
+}
+
+// Recompile compiles the entries that depend on any of the changed
+// files again, as well as the ones that failed before. Unchanged
+// partials are not parsed again. It returns the compiled entries.
+func (b *Batch) Recompile(changed []string, threads int) ([]*BatchEntry, error) {
+	libs.SassBatchRecompile(b.batch, changed, threads)
+	return b.ctx.batchResults(b.batch, b.entries)
+}
+
+// Close frees the batch
+func (b *Batch) Close() {
+	if b.batch == nil {
+		return
+	}
+	libs.SassDeleteBatch(b.batch)
+	b.batch = nil
+}
+
+// CompileMany compiles all entries with the same options, see Batch.
+func CompileMany(entries []*BatchEntry, threads int, opts ...FuncOpt) error {
+	b, err := NewBatch(entries, opts...)
+	if err != nil {
+		return err
+	}
+	defer b.Close()
+	return b.Compile(threads)
+}
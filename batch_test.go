@@ -0,0 +1,151 @@
+package libsass
+
+import (
+	"bytes"
+	"fmt"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"strings"
+	"testing"
+)
+
+func TestCompileMany(t *testing.T) {
+	dir, err := ioutil.TempDir("", "compilemany")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+
+	files := map[string]string{
+		"_base.scss": `$size: 1px !default;
+%base { margin: 0; }`,
+		"_mixins.scss": `@import "base";
+@mixin box($w) { .box { border: $w solid black; width: $size; } }`,
+		"broken.scss": `@import "base";
+div { width: }}`,
+	}
+	for i := 0; i < 6; i++ {
+		files[fmt.Sprintf("main%d.scss", i)] = fmt.Sprintf(`@import "mixins";
+.main%d { @extend %%base; width: $size * %d; }
+@include box(%dpx);`, i, i, i)
+	}
+	writeSheets(t, dir, files)
+
+	var entries []*BatchEntry
+	var wanted []string
+	for i := 0; i < 6; i++ {
+		path := filepath.Join(dir, fmt.Sprintf("main%d.scss", i))
+		var dst bytes.Buffer
+		comp, err := New(&dst, nil, Path(path))
+		if err != nil {
+			t.Fatal(err)
+		}
+		if err := comp.Run(); err != nil {
+			t.Fatal(err)
+		}
+		wanted = append(wanted, dst.String())
+		entries = append(entries, &BatchEntry{Path: path, Out: &bytes.Buffer{}})
+	}
+	mappath := filepath.Join(dir, "main2.css.map")
+	entries[2].MapPath = mappath
+	wanted[2] += "\n/*# sourceMappingURL=main2.css.map */"
+	entries = append(entries, &BatchEntry{
+		Path: filepath.Join(dir, "broken.scss"),
+		Out:  &bytes.Buffer{},
+	})
+
+	err = CompileMany(entries, 4)
+	if err == nil || !strings.Contains(err.Error(), "broken.scss") {
+		t.Errorf("got error: %v", err)
+	}
+	for i, want := range wanted {
+		if entries[i].Err != nil {
+			t.Errorf("entry %d failed: %s", i, entries[i].Err)
+		}
+		if got := entries[i].Out.(*bytes.Buffer).String(); got != want {
+			t.Errorf("entry %d got:\n%s\nwanted:\n%s", i, got, want)
+		}
+		if len(entries[i].ResolvedImports) != 3 {
+			t.Errorf("entry %d got imports: %v", i, entries[i].ResolvedImports)
+		}
+	}
+	if entries[6].Err == nil {
+		t.Error("broken entry did not fail")
+	}
+	smap, err := ioutil.ReadFile(mappath)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if !bytes.Contains(smap, []byte(`"_mixins.scss"`)) {
+		t.Errorf("got map:\n%s", smap)
+	}
+}
+
+func TestBatch_recompile(t *testing.T) {
+	dir, err := ioutil.TempDir("", "recompile")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+
+	writeSheets(t, dir, map[string]string{
+		"_a.scss":    `.a { color: red; }`,
+		"_b.scss":    `.b { color: red; }`,
+		"main0.scss": `@import "a";`,
+		"main1.scss": `@import "a"; .one { width: 1px; }`,
+		"main2.scss": `@import "b";`,
+		"main3.scss": `@import "missing";`,
+	})
+	var entries []*BatchEntry
+	for i := 0; i < 4; i++ {
+		entries = append(entries, &BatchEntry{
+			Path: filepath.Join(dir, fmt.Sprintf("main%d.scss", i)),
+			Out:  &bytes.Buffer{},
+		})
+	}
+	b, err := NewBatch(entries)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer b.Close()
+	if err := b.Compile(2); err == nil {
+		t.Error("missing import did not fail")
+	}
+
+	recompile := func(changed []string, want ...int) {
+		for _, entry := range entries {
+			entry.Out.(*bytes.Buffer).Reset()
+		}
+		done, err := b.Recompile(changed, 2)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if len(done) != len(want) {
+			t.Fatalf("got %d compiled entries wanted: %v", len(done), want)
+		}
+		for i, idx := range want {
+			if done[i] != entries[idx] {
+				t.Errorf("got %s compiled wanted: %s", done[i].Path, entries[idx].Path)
+			}
+		}
+	}
+
+	// changed on disk without changing size or (likely) mtime
+	writeSheets(t, dir, map[string]string{
+		"_a.scss":       `.a { color: tan; }`,
+		"_missing.scss": `.m { color: red; }`,
+	})
+	recompile([]string{filepath.Join(dir, "_a.scss")}, 0, 1, 3)
+	for _, i := range []int{0, 1} {
+		if out := entries[i].Out.(*bytes.Buffer).String(); !strings.Contains(out, "tan") {
+			t.Errorf("entry %d got:\n%s", i, out)
+		}
+	}
+	if out := entries[3].Out.(*bytes.Buffer).String(); !strings.Contains(out, ".m") {
+		t.Errorf("entry 3 got:\n%s", out)
+	}
+
+	recompile([]string{filepath.Join(dir, "_b.scss")}, 2)
+	recompile([]string{filepath.Join(dir, "unused.scss")})
+}
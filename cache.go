@@ -0,0 +1,47 @@
+package libsass
+
+import "github.com/wellington/go-libsass/libs"
+
+// SheetCache keeps parsed Sass files around between compiles. Files
+// are parsed again once they change on disk. A cache can be shared
+// by many compilers, as long as they resolve imports the same way
+// (the include paths are part of the cache key).
+type SheetCache struct {
+	cache libs.SassSheetCache
+}
+
+// NewSheetCache creates an empty cache, call Close to free it
+func NewSheetCache() *SheetCache {
+	return &SheetCache{cache: libs.SassMakeSheetCache()}
+}
+
+// Close frees the cache. It must not be used by a running compile.
+func (s *SheetCache) Close() {
+	if s.cache == nil {
+		return
+	}
+	libs.SassDeleteSheetCache(s.cache)
+	s.cache = nil
+}
+
+// Clear drops all cached sheets
+func (s *SheetCache) Clear() {
+	libs.SassSheetCacheClear(s.cache)
+}
+
+// Invalidate drops the sheets of a changed file from the cache
+func (s *SheetCache) Invalidate(path string) {
+	libs.SassSheetCacheInvalidate(s.cache, path)
+}
+
+// Stats reports cache hits, misses and the number of cached sheets
+func (s *SheetCache) Stats() (hits, misses, size int) {
+	return libs.SassSheetCacheStats(s.cache)
+}
+
+// ExtendStats reports hits, misses and the number of cached extended
+// selectors. Compiles sharing the same @extend rules reuse the
+// selectors extended by each other, unless they write a source map.
+func (s *SheetCache) ExtendStats() (hits, misses, size int) {
+	return libs.SassSheetCacheExtendStats(s.cache)
+}
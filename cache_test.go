@@ -0,0 +1,239 @@
+package libsass
+
+import (
+	"bytes"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"testing"
+	"time"
+)
+
+func writeSheets(t *testing.T, dir string, files map[string]string) {
+	for name, contents := range files {
+		err := ioutil.WriteFile(filepath.Join(dir, name), []byte(contents), 0666)
+		if err != nil {
+			t.Fatal(err)
+		}
+	}
+}
+
+func compileCached(t *testing.T, dir string, cache *SheetCache) (string, string) {
+	var dst bytes.Buffer
+	mappath := filepath.Join(dir, "main.css.map")
+	opts := []FuncOpt{
+		Path(filepath.Join(dir, "main.scss")),
+		SourceMap(true, mappath, ""),
+	}
+	if cache != nil {
+		opts = append(opts, WithSheetCache(cache))
+	}
+	comp, err := New(&dst, nil, opts...)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := comp.Run(); err != nil {
+		t.Fatal(err)
+	}
+	smap, err := ioutil.ReadFile(mappath)
+	if err != nil {
+		t.Fatal(err)
+	}
+	return dst.String(), string(smap)
+}
+
+func TestSheetCache(t *testing.T) {
+	dir, err := ioutil.TempDir("", "sheetcache")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	writeSheets(t, dir, map[string]string{
+		"main.scss": `@import "a";
+div { p { color: $color; } }
+@include box(2px);`,
+		"_a.scss": `@import "b";
+$color: red !default;
+.a { @extend %base; width: 10px; }`,
+		"_b.scss": `%base { margin: 0; }
+@mixin box($w) { .box { border: $w solid black; } }`,
+	})
+
+	cache := NewSheetCache()
+	defer cache.Close()
+
+	css, smap := compileCached(t, dir, nil)
+	for i := 0; i < 3; i++ {
+		ccss, csmap := compileCached(t, dir, cache)
+		if ccss != css {
+			t.Errorf("run %d got:\n%s\nwanted:\n%s", i, ccss, css)
+		}
+		if csmap != smap {
+			t.Errorf("run %d got map:\n%s\nwanted:\n%s", i, csmap, smap)
+		}
+	}
+	hits, misses, size := cache.Stats()
+	// only imported sheets are cached
+	if size != 2 {
+		t.Errorf("got: %d cached sheets wanted: 2", size)
+	}
+	if hits != 4 || misses != 2 {
+		t.Errorf("got: %d hits %d misses wanted: 4 hits 2 misses", hits, misses)
+	}
+
+	// make sure the modification time changes
+	time.Sleep(10 * time.Millisecond)
+	later := time.Now().Add(time.Second)
+	writeSheets(t, dir, map[string]string{
+		"_b.scss": `%base { margin: 1px; }
+@mixin box($w) { .box { border: $w dotted black; } }`,
+	})
+	os.Chtimes(filepath.Join(dir, "_b.scss"), later, later)
+
+	css, smap = compileCached(t, dir, nil)
+	ccss, csmap := compileCached(t, dir, cache)
+	if ccss != css {
+		t.Errorf("got:\n%s\nwanted:\n%s", ccss, css)
+	}
+	if csmap != smap {
+		t.Errorf("got map:\n%s\nwanted:\n%s", csmap, smap)
+	}
+
+	cache.Clear()
+	if _, _, size := cache.Stats(); size != 0 {
+		t.Errorf("got: %d cached sheets wanted: 0", size)
+	}
+}
+
+func compileEntry(t *testing.T, path string, cache *SheetCache) string {
+	var dst bytes.Buffer
+	opts := []FuncOpt{Path(path)}
+	if cache != nil {
+		opts = append(opts, WithSheetCache(cache))
+	}
+	comp, err := New(&dst, nil, opts...)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := comp.Run(); err != nil {
+		t.Fatal(err)
+	}
+	return dst.String()
+}
+
+// compiles with an embedded source map
+func compileEmbedded(t *testing.T, path string, cache *SheetCache) string {
+	var dst bytes.Buffer
+	ctx := newContext()
+	ctx.includeMap = true
+	ctx.SheetCache = cache
+	if err := ctx.fileCompile(path, &dst, "", ""); err != nil {
+		t.Fatal(err)
+	}
+	return dst.String()
+}
+
+func TestSheetCacheExtend(t *testing.T) {
+	dir, err := ioutil.TempDir("", "extendcache")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	writeSheets(t, dir, map[string]string{
+		"one.scss": `@import "design";
+.page { @extend %card; }`,
+		"two.scss": `@import "design";
+.page { @extend %card; }
+.only-two { color: blue; }`,
+		"_design.scss": `%card { padding: 1px; }
+%card:hover, .frame %card { border: 0; }
+.btn { @extend %card; color: red; }
+.btn-big { @extend .btn; }
+.nav :not(.btn) { margin: 0; }
+@media print { .tile { margin: 0; } .print { @extend .tile; } }`,
+	})
+
+	cache := NewSheetCache()
+	defer cache.Close()
+
+	for _, name := range []string{"one.scss", "two.scss", "one.scss"} {
+		path := filepath.Join(dir, name)
+		css := compileEntry(t, path, nil)
+		if ccss := compileEntry(t, path, cache); ccss != css {
+			t.Errorf("%s got:\n%s\nwanted:\n%s", name, ccss, css)
+		}
+	}
+	// extended selectors carry source positions for the map
+	path := filepath.Join(dir, "two.scss")
+	if css := compileEmbedded(t, path, cache); css != compileEmbedded(t, path, nil) {
+		t.Errorf("embedded source map differs with cached extends:\n%s", css)
+	}
+	hits, misses, size := cache.ExtendStats()
+	// both entries have the same extends, only the first
+	// compile has to extend the selectors of the rulesets
+	if hits == 0 || misses != size {
+		t.Errorf("got: %d hits %d misses %d cached", hits, misses, size)
+	}
+
+	cache.Clear()
+	if _, _, size := cache.ExtendStats(); size != 0 {
+		t.Errorf("got: %d cached selectors wanted: 0", size)
+	}
+}
+
+func TestSheetCacheImporter(t *testing.T) {
+	dir, err := ioutil.TempDir("", "importercache")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	writeSheets(t, dir, map[string]string{
+		"main.scss": `@import "a";`,
+		"_a.scss": `@import "b";
+.a { color: $color; }`,
+		"_b.scss": `$color: red;`,
+	})
+	path := filepath.Join(dir, "main.scss")
+
+	cache := NewSheetCache()
+	defer cache.Close()
+
+	compile := func(imports *Imports) string {
+		var dst bytes.Buffer
+		opts := []FuncOpt{Path(path), WithSheetCache(cache)}
+		if imports != nil {
+			opts = append(opts, ImportsOption(imports))
+		}
+		comp, err := New(&dst, nil, opts...)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if err := comp.Run(); err != nil {
+			t.Fatal(err)
+		}
+		return dst.String()
+	}
+	blue := NewImportsWithResolver(func(url string, prev string) (string, string, bool) {
+		if url == "b" {
+			return url, "$color: blue;", true
+		}
+		return "", "", false
+	})
+
+	red := compile(nil)
+	if e := ".a {\n  color: red; }\n"; red != e {
+		t.Fatalf("got:\n%s\nwanted:\n%s", red, e)
+	}
+	// the cached sheet must not hide the custom importer
+	if css := compile(blue); css != ".a {\n  color: blue; }\n" {
+		t.Errorf("got:\n%s\nwanted blue", css)
+	}
+	if css := compile(nil); css != red {
+		t.Errorf("got:\n%s\nwanted:\n%s", css, red)
+	}
+	hits, misses, _ := cache.Stats()
+	// the custom importer turned the hit on `a` into a miss
+	if hits != 2 || misses != 3 {
+		t.Errorf("got: %d hits %d misses wanted: 2 hits 3 misses", hits, misses)
+	}
+}
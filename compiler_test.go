@@ -2,11 +2,18 @@ package libsass
 
 import (
 	"bytes"
+	"errors"
 	"fmt"
+	"io/ioutil"
 	"log"
 	"os"
 	"path/filepath"
+	"runtime"
+	"strings"
+	"sync"
 	"testing"
+
+	"github.com/wellington/go-libsass/libs"
 )
 
 func ExampleCompiler_stdin() {
@@ -192,3 +199,239 @@ func TestCompiler_path_withabsresolver(t *testing.T) {
 		t.Errorf("abs args got: %s wanted: %s", absArgsStr, expectedAbsArgs)
 	}
 }
+
+func TestCompiler_concurrent(t *testing.T) {
+	dir, err := ioutil.TempDir("", "concurrent")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	if err := os.Mkdir(filepath.Join(dir, "components"), 0777); err != nil {
+		t.Fatal(err)
+	}
+	writeSheets(t, dir, map[string]string{
+		"main1.scss": `@import "base", "components/buttons";
+.page { @extend %card; width: double(10px); @include box(2px); }
+@media print { .page { color: tone(red); } }`,
+		"main2.scss": `@import "components/buttons";
+@import "base";
+.alt { @extend .btn; margin: double(3em) percentage(0.25); }
+div { p { color: lighten($brand, 20%); } }`,
+		"_base.scss": `@import "vars";
+%card { padding: $pad; }
+@mixin box($w) { .box { border: $w solid $brand; } }
+@function tone($c) { @return mix($c, $brand, 50%); }`,
+		"_vars.scss": `$pad: 4px !default;
+$brand: #336699;`,
+		filepath.Join("components", "_buttons.scss"): `@import "../vars";
+.btn { color: $brand; &:hover { @extend %card; } }
+@for $i from 1 through 10 { .btn-#{$i} { width: double($i * 1px); } }`,
+	})
+	mains := []string{"main1.scss", "main2.scss"}
+	cache := NewSheetCache()
+	defer cache.Close()
+
+	// the source map is embedded into the css
+	compile := func(main string, cache *SheetCache) (string, error) {
+		var out bytes.Buffer
+		ctx := newContext()
+		ctx.includeMap = true
+		ctx.SheetCache = cache
+		ctx.Funcs.Add(Func{
+			Sign: "double($n)",
+			Fn: Handler(func(v interface{}, req SassValue, res *SassValue) error {
+				var n libs.SassNumber
+				if err := Unmarshal(req, &n); err != nil {
+					return err
+				}
+				n.Value *= 2
+				r, err := Marshal(n)
+				*res = r
+				return err
+			}),
+			Ctx: ctx,
+		})
+		err := ctx.fileCompile(filepath.Join(dir, main), &out, "", "")
+		return out.String(), err
+	}
+
+	want := make([]string, len(mains))
+	for i, main := range mains {
+		css, err := compile(main, nil)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if !strings.Contains(css, "sourceMappingURL=data:") {
+			t.Fatalf("no source map in:\n%s", css)
+		}
+		want[i] = css
+	}
+
+	var wg sync.WaitGroup
+	errs := make(chan error, 1)
+	for g := 0; g < 4*runtime.NumCPU(); g++ {
+		wg.Add(1)
+		go func(g int) {
+			defer wg.Done()
+			for n := 0; n < 20; n++ {
+				i := (g + n) % len(mains)
+				// half of them share parsed sheets
+				var shared *SheetCache
+				if g%2 == 0 {
+					shared = cache
+				}
+				css, err := compile(mains[i], shared)
+				if err == nil && css != want[i] {
+					err = fmt.Errorf("got:\n%s\nwanted:\n%s", css, want[i])
+				}
+				if err != nil {
+					select {
+					case errs <- err:
+					default:
+					}
+					return
+				}
+			}
+		}(g)
+	}
+	wg.Wait()
+	close(errs)
+	if err := <-errs; err != nil {
+		t.Fatal(err)
+	}
+}
+
+func compileThreads(t *testing.T, dir string, threads int) (string, string, error) {
+	var dst bytes.Buffer
+	mappath := filepath.Join(dir, "main.css.map")
+	os.Remove(mappath)
+	comp, err := New(&dst, nil,
+		Path(filepath.Join(dir, "main.scss")),
+		SourceMap(true, mappath, ""),
+		ImportThreads(threads),
+	)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := comp.Run(); err != nil {
+		return "", "", err
+	}
+	smap, err := ioutil.ReadFile(mappath)
+	if err != nil {
+		t.Fatal(err)
+	}
+	return dst.String(), string(smap), nil
+}
+
+func TestCompiler_importThreads(t *testing.T) {
+	dir, err := ioutil.TempDir("", "importthreads")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+
+	files := map[string]string{
+		"_base.scss": `$size: 1px !default;
+%base { margin: 0; }`,
+		"_nested.scss": `.nested { padding: $size; }`,
+	}
+	var main bytes.Buffer
+	main.WriteString("@import \"base\", url(print.css);\n")
+	for i := 0; i < 30; i++ {
+		name := fmt.Sprintf("p%d", i)
+		files["_"+name+".scss"] = fmt.Sprintf(`@import "base";
+.%s { @extend %%base; width: $size * %d;
+  @import "nested"; }
+@import "x.css";`, name, i)
+		fmt.Fprintf(&main, "@import \"%s\";\n", name)
+	}
+	files["main.scss"] = main.String()
+	writeSheets(t, dir, files)
+
+	css, smap, err := compileThreads(t, dir, 0)
+	if err != nil {
+		t.Fatal(err)
+	}
+	for i := 0; i < 3; i++ {
+		tcss, tsmap, err := compileThreads(t, dir, 4)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if tcss != css {
+			t.Errorf("got:\n%s\nwanted:\n%s", tcss, css)
+		}
+		if tsmap != smap {
+			t.Errorf("got map:\n%s\nwanted:\n%s", tsmap, smap)
+		}
+	}
+
+	// errors are reported like before
+	writeSheets(t, dir, map[string]string{"_p7.scss": `.p7 { width: }}`})
+	_, _, err = compileThreads(t, dir, 0)
+	_, _, terr := compileThreads(t, dir, 4)
+	if err == nil || terr == nil || err.Error() != terr.Error() {
+		t.Errorf("got error:\n%v\nwanted:\n%v", terr, err)
+	}
+}
+
+// chunkWriter counts the writes and fails after max of them
+type chunkWriter struct {
+	bytes.Buffer
+	writes int
+	max    int
+}
+
+func (w *chunkWriter) Write(p []byte) (int, error) {
+	w.writes++
+	if w.max > 0 && w.writes > w.max {
+		return 0, errors.New("disk full")
+	}
+	return w.Buffer.Write(p)
+}
+
+func TestCompiler_streamOutput(t *testing.T) {
+	var in bytes.Buffer
+	in.WriteString("/* header */\n")
+	for i := 0; i < 5000; i++ {
+		fmt.Fprintf(&in, ".u-%d { margin: %dpx; padding: 0 %dpx; }\n", i, i, i)
+	}
+	in.WriteString(`.last { content: "→"; }
+@import url(late.css);`)
+
+	for _, style := range []int{NESTED_STYLE, COMPRESSED_STYLE} {
+		var want bytes.Buffer
+		comp, err := New(&want, bytes.NewReader(in.Bytes()), OutputStyle(style))
+		if err != nil {
+			t.Fatal(err)
+		}
+		if err := comp.Run(); err != nil {
+			t.Fatal(err)
+		}
+
+		var got chunkWriter
+		comp, err = New(&got, bytes.NewReader(in.Bytes()),
+			OutputStyle(style), StreamOutput(true))
+		if err != nil {
+			t.Fatal(err)
+		}
+		if err := comp.Run(); err != nil {
+			t.Fatal(err)
+		}
+		if got.String() != want.String() {
+			t.Errorf("style %d got:\n%.200s\nwanted:\n%.200s", style, got.String(), want.String())
+		}
+		if got.writes < 2 {
+			t.Errorf("style %d expected chunked writes, got %d", style, got.writes)
+		}
+	}
+
+	// errors of the writer are passed on
+	fail := chunkWriter{max: 1}
+	comp, err := New(&fail, bytes.NewReader(in.Bytes()), StreamOutput(true))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := comp.Run(); err == nil || err.Error() != "disk full" {
+		t.Errorf("got error: %v", err)
+	}
+}
@@ -61,6 +61,15 @@ type compctx struct {
 	// compiled.
 	Headers *Headers
 
+	// SheetCache keeps parsed Sass files between compiles
+	SheetCache *SheetCache
+
+	// ImportThreads parse the imports of the main file ahead of time
+	ImportThreads int
+
+	// StreamOutput writes the css in chunks while it is rendered
+	StreamOutput bool
+
 	// ResolvedImports is the list of files libsass used to compile this
 	// Sass sheet.
 	ResolvedImports []string
@@ -117,6 +126,12 @@ func (ctx *compctx) Init(goopts libs.SassOptions) libs.SassOptions {
 	libs.SassOptionSetPrecision(goopts, ctx.Precision)
 	libs.SassOptionSetOutputStyle(goopts, ctx.OutputStyle)
 	libs.SassOptionSetSourceComments(goopts, ctx.Comments)
+	if ctx.SheetCache != nil {
+		libs.SassOptionSetSheetCache(goopts, ctx.SheetCache.cache)
+	}
+	if ctx.ImportThreads > 0 {
+		libs.SassOptionSetImportThreads(goopts, ctx.ImportThreads)
+	}
 
 	if ctx.includeMap {
 		libs.SassOptionSetSourceMapEmbed(goopts, true)
@@ -155,6 +170,8 @@ func (ctx *compctx) fileCompile(path string, out io.Writer, mappath, sourceMapRo
 		libs.SassOptionSetSourceMapRoot(goopts, sourceMapRoot)
 	}
 
+	release := ctx.bindOutput(goopts, out)
+
 	// Set options to the sass context
 	libs.SassFileContextSetOptions(gofc, goopts)
 	gocc := libs.SassFileContextGetContext(gofc)
@@ -164,21 +181,27 @@ func (ctx *compctx) fileCompile(path string, out io.Writer, mappath, sourceMapRo
 	ctx.ResolvedImports = libs.GetImportList(gocc)
 	libs.SassCompilerExecute(gocompiler)
 	defer libs.SassDeleteCompiler(gocompiler)
+	if err := release(); err != nil {
+		return err
+	}
 
-	goout := libs.SassContextGetOutputString(gocc)
 	if out == nil {
 		return errors.New("out writer required")
 	}
-	_, err := io.WriteString(out, goout)
+	// the writer gets the C buffer, no copy
+	goout := libs.SassContextTakeOutput(gocc)
+	_, err := out.Write(goout.Bytes)
+	goout.Release()
 	if err != nil {
 		return err
 	}
 	ctx.Status = libs.SassContextGetErrorStatus(gocc)
 	errJSON := libs.SassContextGetErrorJSON(gocc)
-	mapout := libs.SassContextGetSourceMapString(gocc)
+	mapout := libs.SassContextTakeSourceMap(gocc)
+	defer mapout.Release()
 
-	if len(mappath) > 0 && len(mapout) > 0 {
-		err := ioutil.WriteFile(mappath, []byte(mapout), 0666)
+	if len(mappath) > 0 && len(mapout.Bytes) > 0 {
+		err := ioutil.WriteFile(mappath, mapout.Bytes, 0666)
 		if err != nil {
 			return err
 		}
@@ -196,6 +219,91 @@ func (ctx *compctx) fileCompile(path string, out io.Writer, mappath, sourceMapRo
 	return nil
 }
 
+// bindOutput streams the css to out if asked to. The returned func
+// must be called once the compiler is done, it reports write errors.
+func (ctx *compctx) bindOutput(goopts libs.SassOptions, out io.Writer) func() error {
+	if !ctx.StreamOutput || out == nil {
+		return func() error { return nil }
+	}
+	idx := libs.BindOutput(goopts, out)
+	return func() error { return libs.RemoveOutput(idx) }
+}
+
+func (ctx *compctx) batchInit(entries []*BatchEntry, sourceMapRoot string) libs.SassBatch {
+	gobatch := libs.SassMakeBatch()
+	goopts := libs.SassBatchGetOptions(gobatch)
+	ctx.Init(goopts)
+
+	// write source map paths relative to this path
+	if len(sourceMapRoot) > 0 {
+		libs.SassOptionSetSourceMapRoot(goopts, sourceMapRoot)
+	}
+
+	for _, entry := range entries {
+		gofc := libs.SassBatchAddFile(gobatch, entry.Path)
+		if len(entry.MapPath) == 0 {
+			continue
+		}
+		// see fileCompile for the paths
+		var fpath string
+		if f, ok := entry.Out.(*os.File); ok {
+			fpath = f.Name()
+		}
+		entopts := libs.SassFileContextGetOptions(gofc)
+		libs.SassOptionSetSourceMapFile(entopts, entry.MapPath)
+		libs.SassOptionSetOutputPath(entopts, fpath)
+	}
+	return gobatch
+}
+
+// batchResults collects the results of the entries compiled last
+func (ctx *compctx) batchResults(gobatch libs.SassBatch, entries []*BatchEntry) ([]*BatchEntry, error) {
+	var first error
+	compiled := libs.SassBatchGetCompiled(gobatch)
+	done := make([]*BatchEntry, len(compiled))
+	for i, idx := range compiled {
+		entry := entries[idx]
+		gocc := libs.SassFileContextGetContext(libs.SassBatchGetFileContext(gobatch, idx))
+		entry.Err = ctx.batchResult(entry, gocc)
+		if first == nil {
+			first = entry.Err
+		}
+		done[i] = entry
+	}
+	return done, first
+}
+
+// batchResult writes the output of a compiled entry
+func (ctx *compctx) batchResult(entry *BatchEntry, gocc libs.SassContext) error {
+	defer ctx.Reset()
+	entry.ResolvedImports = libs.GetImportList(gocc)
+	if entry.Out == nil {
+		return errors.New("out writer required")
+	}
+	goout := libs.SassContextTakeOutput(gocc)
+	_, err := entry.Out.Write(goout.Bytes)
+	goout.Release()
+	if err != nil {
+		return err
+	}
+	mapout := libs.SassContextTakeSourceMap(gocc)
+	defer mapout.Release()
+	if len(entry.MapPath) > 0 && len(mapout.Bytes) > 0 {
+		err := ioutil.WriteFile(entry.MapPath, mapout.Bytes, 0666)
+		if err != nil {
+			return err
+		}
+	}
+	err = ctx.ProcessSassError([]byte(libs.SassContextTakeErrorJSON(gocc)))
+	if err != nil {
+		return err
+	}
+	if ctx.Error() != "" {
+		return errors.New(ctx.Error())
+	}
+	return nil
+}
+
 // compile reads in and writes the libsass compiled result to out.
 // Options and custom functions are applied as specified in Context.
 func (ctx *compctx) compile(out io.Writer, in io.Reader) error {
@@ -233,6 +341,7 @@ func (ctx *compctx) compile(out io.Writer, in io.Reader) error {
 	libs.SassOptionSetSourceComments(goopts, true)
 
 	ctx.Init(goopts)
+	release := ctx.bindOutput(goopts, out)
 
 	libs.SassDataContextSetOptions(godc, goopts)
 	goctx := libs.SassDataContextGetContext(godc)
@@ -241,9 +350,13 @@ func (ctx *compctx) compile(out io.Writer, in io.Reader) error {
 	libs.SassCompilerParse(gocompiler)
 	libs.SassCompilerExecute(gocompiler)
 	defer libs.SassDeleteCompiler(gocompiler)
+	if err := release(); err != nil {
+		return err
+	}
 
-	goout := libs.SassContextGetOutputString(goctx)
-	io.WriteString(out, goout)
+	goout := libs.SassContextTakeOutput(goctx)
+	out.Write(goout.Bytes)
+	goout.Release()
 
 	ctx.Status = libs.SassContextGetErrorStatus(goctx)
 	errJSON := libs.SassContextGetErrorJSON(goctx)
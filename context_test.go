@@ -2,8 +2,10 @@ package libsass
 
 import (
 	"bytes"
+	"fmt"
 	"log"
 	"os"
+	"strings"
 	"testing"
 
 	"github.com/wellington/go-libsass/libs"
@@ -88,6 +90,282 @@ div {
 
 }
 
+func TestContextBuiltinsReused(t *testing.T) {
+	src := `$g: 1;
+@function lighten($c, $a) { @return shadowed; }
+div {
+  $g: 2 !global;
+  a: lighten(red, 10%);
+  b: darken(red, 10%);
+  c: function-exists(darken);
+  d: global-variable-exists(g);
+  e: $g;
+}
+`
+	e := `div {
+  a: shadowed;
+  b: #cc0000;
+  c: true;
+  d: true;
+  e: 2; }
+`
+	// the second run must not see the shadowed lighten()
+	// or the global variable of the first one
+	for i := 0; i < 2; i++ {
+		var out bytes.Buffer
+		ctx := newContext()
+		if err := ctx.compile(&out, bytes.NewBufferString(src)); err != nil {
+			t.Fatal(err)
+		}
+		if e != out.String() {
+			t.Errorf("wanted:\n%s\ngot:\n%s\n", e, out.String())
+		}
+		src = "div { a: lighten(red, 10%); b: global-variable-exists(g); }"
+		e = `div {
+  a: #ff3333;
+  b: false; }
+`
+	}
+}
+
+// a custom function named like a built-in only shadows it
+// for its own compile, the shared built-ins stay untouched
+func TestContextBuiltinsShadowedByFunc(t *testing.T) {
+	src := "div { a: lighten(red, 10%); }"
+	for i, e := range []string{
+		"div {\n  a: #ff3333; }\n",
+		"div {\n  a: shadowed; }\n",
+		"div {\n  a: #ff3333; }\n",
+	} {
+		var out bytes.Buffer
+		ctx := newContext()
+		if i == 1 {
+			ctx.Funcs.Add(Func{
+				Sign: "lighten($c, $a)",
+				Fn: Handler(func(v interface{}, req SassValue, res *SassValue) error {
+					r, err := Marshal("shadowed")
+					*res = r
+					return err
+				}),
+				Ctx: ctx,
+			})
+		}
+		if err := ctx.compile(&out, bytes.NewBufferString(src)); err != nil {
+			t.Fatal(err)
+		}
+		if e != out.String() {
+			t.Errorf("%d wanted:\n%s\ngot:\n%s\n", i, e, out.String())
+		}
+	}
+}
+
+func TestContextExistsUnknown(t *testing.T) {
+	src := `$known: 1;
+@mixin known-mixin { a: b; }
+@function known-function() { @return 1; }
+@each $name in known, unknown-name {
+  .#{$name} {
+    v: variable-exists(#{$name});
+    g: global-variable-exists(#{$name});
+    f: function-exists(#{$name}-function);
+    m: mixin-exists(#{$name}-mixin);
+  }
+}
+`
+	e := `.known {
+  v: true;
+  g: true;
+  f: true;
+  m: true; }
+
+.unknown-name {
+  v: false;
+  g: false;
+  f: false;
+  m: false; }
+`
+	var out bytes.Buffer
+	ctx := newContext()
+	if err := ctx.compile(&out, bytes.NewBufferString(src)); err != nil {
+		t.Fatal(err)
+	}
+	if e != out.String() {
+		t.Errorf("wanted:\n%s\ngot:\n%s\n", e, out.String())
+	}
+}
+
+// !global assigns to the root scope from the top level and from
+// every nested scope, shadowing locals are left alone
+func TestContextGlobalAssignment(t *testing.T) {
+	src := `$top: a;
+$top: b !global;
+$rule: a;
+$mixin: a;
+$function: a;
+$local: a;
+@mixin set-global {
+  $mixin: b !global;
+}
+@function set-global() {
+  $function: b !global;
+  @return $function;
+}
+.rule {
+  $local: b;
+  $rule: b !global;
+  @if true {
+    $local: c !global;
+    .nested {
+      @include set-global;
+      f: set-global();
+      local: $local;
+    }
+  }
+  local: $local;
+}
+.globals {
+  top: $top;
+  rule: $rule;
+  mixin: $mixin;
+  function: $function;
+  local: $local;
+}
+`
+	e := `.rule {
+  local: b; }
+  .rule .nested {
+    f: b;
+    local: b; }
+
+.globals {
+  top: b;
+  rule: b;
+  mixin: b;
+  function: b;
+  local: c; }
+`
+	var out bytes.Buffer
+	ctx := newContext()
+	if err := ctx.compile(&out, bytes.NewBufferString(src)); err != nil {
+		t.Fatal(err)
+	}
+	if e != out.String() {
+		t.Errorf("wanted:\n%s\ngot:\n%s\n", e, out.String())
+	}
+}
+
+// variables of mixins and functions are resolved to call frame slots
+func TestContextSlotResolver(t *testing.T) {
+	cases := []struct {
+		name, in, want string
+	}{
+		{
+			name: "shadowed locals",
+			in: `$x: global;
+@mixin m($x) {
+  a: $x;
+  $y: outer;
+  @if true { $y: inner; b: $y; }
+  c: $y;
+  @each $x in each { d: $x; }
+  e: $x;
+}
+.s { @include m(param); f: $x; }`,
+			want: `.s {
+  a: param;
+  b: inner;
+  c: inner;
+  d: each;
+  e: param;
+  f: global; }
+`,
+		},
+		{
+			name: "global from mixin",
+			in: `$g: 1;
+@mixin set($v) { $g: $v !global; $l: local; }
+.a { @include set(2); g: $g; }
+.b { $g: 3 !global; @include set(4); g: $g; }
+.c { g: $g; l: variable-exists(l); }`,
+			want: `.a {
+  g: 2; }
+
+.b {
+  g: 4; }
+
+.c {
+  g: 4;
+  l: false; }
+`,
+		},
+		{
+			name: "content block",
+			in: `@mixin wrap($x: mixin) {
+  $y: mixin;
+  .w { @content; x: $x; y: $y; }
+}
+.c { $x: caller; $y: caller; @include wrap { x: $x; y: $y; } }`,
+			want: `.c .w {
+  x: caller;
+  y: caller;
+  x: mixin;
+  y: mixin; }
+`,
+		},
+		{
+			name: "recursion",
+			in: `@function fact($n) {
+  @if $n <= 1 { @return 1; }
+  $r: fact($n - 1);
+  @return $n * $r;
+}
+@mixin depth($n) {
+  $d: $n;
+  @if $n > 0 { @include depth($n - 1); }
+  .d#{$n} { d: $d; }
+}
+.r { f: fact(5); }
+@include depth(2);`,
+			want: `.r {
+  f: 120; }
+
+.d0 {
+  d: 0; }
+
+.d1 {
+  d: 1; }
+
+.d2 {
+  d: 2; }
+`,
+		},
+		{
+			name: "if with locals",
+			in: `@function pick($a, $b) {
+  $c: $a + $b;
+  @return if($c > 3, $c, $a);
+}
+.i { p: pick(1, 1); q: pick(2, 3); $t: 5; r: if($t > 4, $t, no); }`,
+			want: `.i {
+  p: 1;
+  q: 5;
+  r: 5; }
+`,
+		},
+	}
+	for _, c := range cases {
+		var out bytes.Buffer
+		ctx := newContext()
+		if err := ctx.compile(&out, bytes.NewBufferString(c.in)); err != nil {
+			t.Errorf("%s: %s", c.name, err)
+			continue
+		}
+		if c.want != out.String() {
+			t.Errorf("%s wanted:\n%s\ngot:\n%s\n", c.name, c.want, out.String())
+		}
+	}
+}
+
 func TestLibsassError(t *testing.T) {
 	in := bytes.NewBufferString(`div {
   color: red(blue, purple);
@@ -121,6 +399,147 @@ div {
 	}
 }
 
+func TestContextExtendCompound(t *testing.T) {
+	in := bytes.NewBufferString(`.a.b { x: y; }
+.a { z: w; }
+.b.c.a { u: v; }
+.e { @extend .a.b; }`)
+
+	var out bytes.Buffer
+	ctx := newContext()
+	if err := ctx.compile(&out, in); err != nil {
+		t.Fatal(err)
+	}
+	e := `.a.b, .e {
+  x: y; }
+
+.a {
+  z: w; }
+
+.b.c.a, .c.e {
+  u: v; }
+`
+	if e != out.String() {
+		t.Errorf("got:\n%s\nwanted:\n%s", out.String(), e)
+	}
+}
+
+// selectors with arguments are matched by their rendering
+func TestContextExtendWrapped(t *testing.T) {
+	in := bytes.NewBufferString(`.a:not(.b) { x: 1; }
+.c { @extend .a; }
+:matches(.d, .e) .f { x: 2; }
+.g { @extend .d; }
+.h:not(.i):not(.j) { x: 3; }
+.k:not(.i) { @extend .h; }
+.l::before:not(.m) { x: 4; }
+.n { @extend .l; }
+%p:nth-child(2n + 1) { x: 5; }
+.q:nth-child(2n + 1) { @extend %p; }
+.r:nth-child(2n+1) { @extend %p; }
+.s:not(.t) { @extend .u; }
+.u:not(.t) { x: 6; }
+a[href="x"] { x: 7; }
+.v { @extend a; }
+.w { @extend [href="x"]; }
+.x { y: selector-unify(".a:not(.b)", ".c:not(.b)"); z: selector-unify(":matches(.a, .b)", ":matches(.a, .b).c"); u: is-superselector(":not(.a)", ":not(.a).b"); v: is-superselector(":matches(.a, .b)", ".a"); }`)
+
+	var out bytes.Buffer
+	ctx := newContext()
+	if err := ctx.compile(&out, in); err != nil {
+		t.Fatal(err)
+	}
+	e := `.a:not(.b), .c:not(.b) {
+  x: 1; }
+
+:matches(.d, .g, .e) .f {
+  x: 2; }
+
+.h:not(.i):not(.j), .k:not(.i):not(.j) {
+  x: 3; }
+
+.l::before:not(.m), .n::before:not(.m) {
+  x: 4; }
+
+.q:nth-child(2n + 1), .r:nth-child(2n + 1):nth-child(2n+1) {
+  x: 5; }
+
+.u:not(.t), .s:not(.t) {
+  x: 6; }
+
+a[href="x"], .v[href="x"], .v.w, a.w {
+  x: 7; }
+
+.x {
+  y: .a.c:not(.b);
+  z: :matches(.a, .b) .c:matches(.a, .b);
+  u: true;
+  v: true; }
+`
+	if e != out.String() {
+		t.Errorf("wanted:\n%s\ngot:\n%s\n", e, out.String())
+	}
+}
+
+// selectors are still extended once more of them were generated
+// than the table of selector symbols takes
+func TestContextExtendManySelectors(t *testing.T) {
+	src := `.target { a: b; }
+@for $i from 1 through 70000 { .c-#{$i} { c: $i; } }
+.x { @extend .target; }
+.late { @extend .c-70000; }
+.late-#{"wrapped"} { @extend .late; }
+`
+	var out bytes.Buffer
+	ctx := newContext()
+	if err := ctx.compile(&out, bytes.NewBufferString(src)); err != nil {
+		t.Fatal(err)
+	}
+	for _, e := range []string{
+		".target, .x {\n  a: b; }\n",
+		".c-1 {\n  c: 1; }\n",
+		".c-70000, .late, .late-wrapped {\n  c: 70000; }\n",
+	} {
+		if !strings.Contains(out.String(), e) {
+			t.Errorf("missing:\n%s", e)
+		}
+	}
+}
+
+func TestContextInterpolatedSelectors(t *testing.T) {
+	// the same text in and outside of a media block and the root
+	in := bytes.NewBufferString(`@mixin el($e) { .card__#{$e} { x: $e; } }
+.card {
+  @include el(title);
+  @media print { @include el(title); }
+  @at-root #{".card__title"} { y: z; }
+}
+#{".card__title"} { w: v; }
+.e { @extend .card__title; }`)
+
+	var out bytes.Buffer
+	ctx := newContext()
+	if err := ctx.compile(&out, in); err != nil {
+		t.Fatal(err)
+	}
+	e := `.card .card__title, .card .e {
+  x: title; }
+
+@media print {
+  .card .card__title, .card .e {
+    x: title; } }
+
+.card__title, .e {
+  y: z; }
+
+.card__title, .e {
+  w: v; }
+`
+	if e != out.String() {
+		t.Errorf("got:\n%s\nwanted:\n%s", out.String(), e)
+	}
+}
+
 func ExampleContext_Compile() {
 	in := bytes.NewBufferString(`div {
 			  color: red(blue);
@@ -164,3 +583,55 @@ func BenchmarkContextCompile(b *testing.B) {
 		}
 	}
 }
+
+func BenchmarkContextCompile_extend(b *testing.B) {
+	var bits bytes.Buffer
+	for i := 0; i < 40; i++ {
+		fmt.Fprintf(&bits, "%%p%d { color: red; &:hover { x: %d; } }\n", i, i)
+		fmt.Fprintf(&bits, ".b%d.m { margin: %dpx; }\n", i, i)
+	}
+	for i := 0; i < 200; i++ {
+		fmt.Fprintf(&bits, ".c%d:not(.x) { @extend %%p%d; @extend %%p%d; @extend .b%d; k: %d; }\n",
+			i, i%40, (i*7)%40, i%40, i)
+	}
+	ctx := newContext()
+	var out bytes.Buffer
+
+	for i := 0; i < b.N; i++ {
+		out.Reset()
+		err := ctx.compile(&out, bytes.NewReader(bits.Bytes()))
+		if err != nil {
+			b.Fatal(err)
+		}
+	}
+}
+
+// the same sheet is compiled without and with an embedded source map
+func benchmarkSourceMap(b *testing.B, embed bool) {
+	var bits bytes.Buffer
+	for i := 0; i < 200; i++ {
+		fmt.Fprintf(&bits, ".b%d {\n  color: red;\n  &__e { margin: %dpx; }\n", i, i)
+		fmt.Fprintf(&bits, "  &--m { @extend .b%d; padding: 0 %dpx; }\n", i, i%7)
+		fmt.Fprintf(&bits, "  @media (min-width: %dpx) { width: percentage(%d / 200); }\n}\n", i*10, i)
+	}
+	ctx := newContext()
+	ctx.includeMap = embed
+	var out bytes.Buffer
+
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		out.Reset()
+		err := ctx.compile(&out, bytes.NewReader(bits.Bytes()))
+		if err != nil {
+			b.Fatal(err)
+		}
+	}
+}
+
+func BenchmarkContextCompile_nomap(b *testing.B) {
+	benchmarkSourceMap(b, false)
+}
+
+func BenchmarkContextCompile_sourcemap(b *testing.B) {
+	benchmarkSourceMap(b, true)
+}
@@ -2,5 +2,9 @@
 // are used to make the package more like Go than C. For low level
 // access see: http://godoc.org/github.com/wellington/go-libsass/libs
 //
+// Compilers are safe to run concurrently, one goroutine per Compiler.
+// Registered handlers and importers may be called from many
+// compilers at once.
+//
 // For more info, see https://github.com/sass/libsass
 package libsass
@@ -25,6 +25,33 @@ func RegisterSassFunc(sign string, fn SassFunc) {
 	ghMu.Unlock()
 }
 
+// RegisterPureSassFunc is RegisterSassFunc for functions that only
+// depend on their arguments. libsass calls fn once per distinct
+// arguments in a compile and reuses the result for repeated calls.
+func RegisterPureSassFunc(sign string, fn SassFunc) {
+	ghMu.Lock()
+	globalHandlers = append(globalHandlers, handler{
+		sign:     sign,
+		callback: SassHandler(fn),
+		pure:     true,
+	})
+	ghMu.Unlock()
+}
+
+// RegisterBatchSassFunc is RegisterSassFunc for functions called
+// many times in a loop. libsass collects the calls of all iterations
+// of an @each or @for body and passes their arguments to fn at once,
+// fn must return one result per argument list in the same order.
+func RegisterBatchSassFunc(sign string, fn SassBatchFunc) {
+	ghMu.Lock()
+	globalHandlers = append(globalHandlers, handler{
+		sign:     sign,
+		callback: SassBatchHandler(fn),
+		batched:  true,
+	})
+	ghMu.Unlock()
+}
+
 type key int
 
 const (
@@ -82,6 +109,49 @@ func SassHandler(h SassFunc) libs.SassCallback {
 	}
 }
 
+// SassBatchFunc describes func for handling the arguments of many
+// calls at once, in holds the argument list of each call
+type SassBatchFunc func(ctx context.Context, in []SassValue) ([]*SassValue, error)
+
+// SassBatchHandler contains callback context for running a batched
+// func within a libsass handler
+func SassBatchHandler(h SassBatchFunc) libs.SassCallback {
+	return func(v interface{}, usv libs.UnionSassValue, rsv *libs.UnionSassValue) error {
+		libCtx, ok := v.(*compctx)
+		if !ok {
+			*rsv = libs.MakeError("libsass Context not found")
+			return errors.New("libsass Context not found")
+		}
+
+		ctx := NewCompilerContext(libCtx.compiler)
+
+		req := make([]SassValue, libs.Len(usv))
+		for i := range req {
+			req[i] = SassValue{value: libs.Index(usv, i)}
+		}
+		res, err := h(ctx, req)
+		if err == nil && len(res) != len(req) {
+			err = fmt.Errorf("batched func returned %d results for %d calls",
+				len(res), len(req))
+		}
+		if err != nil {
+			*rsv = libs.MakeError(err.Error())
+			return err
+		}
+
+		lst := libs.MakeList(len(res))
+		for i, r := range res {
+			if r == nil {
+				libs.SetIndex(lst, i, libs.MakeNil())
+				continue
+			}
+			libs.SetIndex(lst, i, r.Val())
+		}
+		*rsv = lst
+		return nil
+	}
+}
+
 // RegisterHandler sets the passed signature and callback to the
 // handlers array.
 func RegisterHandler(sign string, callback HandlerFunc) {
@@ -120,6 +190,8 @@ func Handler(h HandlerFunc) libs.SassCallback {
 type handler struct {
 	sign     string
 	callback libs.SassCallback
+	pure     bool
+	batched  bool
 }
 
 var _ libs.SassCallback = TestCallback
@@ -143,6 +215,11 @@ type Func struct {
 	Sign string
 	Fn   libs.SassCallback
 	Ctx  interface{}
+	// Pure functions only depend on their arguments
+	Pure bool
+	// Batched functions get the arguments of many calls at once,
+	// see SassBatchHandler
+	Batched bool
 }
 
 type Funcs struct {
@@ -178,9 +255,11 @@ func (fs *Funcs) Bind(goopts libs.SassOptions) {
 	// Append registered handlers to cookie array
 	for i, h := range globalHandlers {
 		cookies[i] = libs.Cookie{
-			Sign: h.sign,
-			Fn:   h.callback,
-			Ctx:  fs.ctx,
+			Sign:    h.sign,
+			Fn:      h.callback,
+			Ctx:     fs.ctx,
+			Pure:    h.pure,
+			Batched: h.batched,
 		}
 	}
 	l := len(globalHandlers)
@@ -188,9 +267,11 @@ func (fs *Funcs) Bind(goopts libs.SassOptions) {
 
 	for i, h := range fs.f {
 		cookies[i+l] = libs.Cookie{
-			Sign: h.Sign,
-			Fn:   h.Fn,
-			Ctx:  fs.ctx,
+			Sign:    h.Sign,
+			Fn:      h.Fn,
+			Ctx:     fs.ctx,
+			Pure:    h.Pure,
+			Batched: h.Batched,
 		}
 	}
 	fs.idx = libs.BindFuncs(goopts, cookies)
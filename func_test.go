@@ -7,6 +7,8 @@ import (
 	"testing"
 	"time"
 
+	"golang.org/x/net/context"
+
 	"github.com/wellington/go-libsass/libs"
 )
 
@@ -185,3 +187,122 @@ div {
 	}
 
 }
+
+func TestFunc_pure(t *testing.T) {
+	in := bytes.NewBufferString(`div {
+  a: count(1px);
+  b: count(1px);
+  c: count(1in);
+  d: count("x");
+  e: count(x);
+  f: count(red);
+  g: count(#f00);
+  h: count(1px);
+}`)
+
+	var calls int
+	ctx := newContext()
+	ctx.Funcs.Add(Func{
+		Sign: "count($x)",
+		Fn: Handler(func(v interface{}, req SassValue, res *SassValue) error {
+			calls++
+			var err error
+			*res, err = Marshal(libs.SassNumber{Value: float64(calls)})
+			return err
+		}),
+		Ctx:  &ctx,
+		Pure: true,
+	})
+	var out bytes.Buffer
+	err := ctx.compile(&out, in)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	// only the exact same arguments share a result
+	e := `div {
+  a: 1;
+  b: 1;
+  c: 2;
+  d: 3;
+  e: 4;
+  f: 5;
+  g: 5;
+  h: 1; }
+`
+	if e != out.String() {
+		t.Errorf("wanted:\n%s\ngot:\n%s\n", e, out.String())
+	}
+	if calls != 5 {
+		t.Errorf("got %d calls wanted 5", calls)
+	}
+}
+
+func TestFunc_batched(t *testing.T) {
+	in := bytes.NewBufferString(`$sizes: (small: 1, medium: 2, large: 3);
+@each $name, $size in $sizes {
+  .#{$name} {
+    width: twice($size * 1px);
+    height: twice($size * 1pt);
+  }
+}
+div {
+  a: twice(5px);
+}`)
+
+	var calls, args int
+	ctx := newContext()
+	ctx.Funcs.Add(Func{
+		Sign: "twice($x)",
+		Fn: SassBatchHandler(func(_ context.Context, in []SassValue) ([]*SassValue, error) {
+			calls++
+			out := make([]*SassValue, len(in))
+			for i := range in {
+				args++
+				var x libs.SassNumber
+				if err := Unmarshal(in[i], &x); err != nil {
+					return nil, err
+				}
+				res, err := Marshal(libs.SassNumber{Value: 2 * x.Value, Unit: x.Unit})
+				if err != nil {
+					return nil, err
+				}
+				out[i] = &res
+			}
+			return out, nil
+		}),
+		Ctx:     &ctx,
+		Batched: true,
+	})
+	var out bytes.Buffer
+	err := ctx.compile(&out, in)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	e := `.small {
+  width: 2px;
+  height: 2pt; }
+
+.medium {
+  width: 4px;
+  height: 4pt; }
+
+.large {
+  width: 6px;
+  height: 6pt; }
+
+div {
+  a: 10px; }
+`
+	if e != out.String() {
+		t.Errorf("wanted:\n%s\ngot:\n%s\n", e, out.String())
+	}
+	// one call for the loop, one for the plain declaration
+	if calls != 2 {
+		t.Errorf("got %d calls wanted 2", calls)
+	}
+	if args != 7 {
+		t.Errorf("got %d argument lists wanted 7", args)
+	}
+}
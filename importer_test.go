@@ -2,6 +2,9 @@ package libsass
 
 import (
 	"bytes"
+	"io/ioutil"
+	"os"
+	"path/filepath"
 	"strings"
 	"testing"
 )
@@ -168,3 +171,45 @@ div.branch {
 		t.Errorf("%q does not contain %q", err.Error(), msg)
 	}
 }
+
+func TestSassImport_fileOnce(t *testing.T) {
+	dir, err := ioutil.TempDir("", "importonce")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	writeSheets(t, dir, map[string]string{
+		"main.scss": `@import "a", "c";`,
+		"_a.scss":   `@import "b"; a { color: $b; }`,
+		"_b.scss":   `$b: red; b { color: blue; }`,
+		"_c.scss":   `@import "b"; c { color: $b; }`,
+	})
+
+	var out bytes.Buffer
+	ctx := newContext()
+	// importers no longer disable the reuse of loaded files
+	ctx.Imports.m = make(map[string]Import)
+	ctx.Imports.Add("", "other", []byte("other { color: blue; }"))
+	err = ctx.fileCompile(filepath.Join(dir, "main.scss"), &out, "", "")
+	if err != nil {
+		t.Fatal(err)
+	}
+	e := `b {
+  color: blue; }
+
+a {
+  color: red; }
+
+b {
+  color: blue; }
+
+c {
+  color: red; }
+`
+	if e != out.String() {
+		t.Fatalf("got:\n%s\nwanted:\n%s", out.String(), e)
+	}
+	if e := 4; len(ctx.ResolvedImports) != e {
+		t.Errorf("got: %d wanted: %d\n%v", len(ctx.ResolvedImports), e, ctx.ResolvedImports)
+	}
+}
@@ -1,11 +1,12 @@
 package libs
 
+// #include <stdint.h>
 // #include "sass/context.h"
 //
 import "C"
 import (
 	"fmt"
-	"sync"
+	"unsafe"
 )
 
 // SassCallback defines the callback libsass eventually executes in
@@ -19,16 +20,17 @@ type Cookie struct {
 	Sign string
 	Fn   SassCallback
 	Ctx  interface{}
+	// Pure functions are called once per arguments and compile
+	Pure bool
+	// Batched functions get the arguments of many calls at once
+	Batched bool
 }
 
-// gate gobridge, it has some unknown race conditions
-var gobridgeMu sync.Mutex
-
 // GoBridge is exported to C for linking libsass to Go.  This function
 // adheres to the interface provided by libsass.
 //
 //export GoBridge
-func GoBridge(cargs UnionSassValue, cidx C.int) UnionSassValue {
+func GoBridge(cargs UnionSassValue, cidx C.uintptr_t) UnionSassValue {
 	// Recover the Cookie struct passed in
 	idx := int(cidx)
 	ck, ok := globalFuncs.Get(idx).(Cookie)
@@ -43,3 +45,20 @@ func GoBridge(cargs UnionSassValue, cidx C.int) UnionSassValue {
 	_ = err
 	return usv
 }
+
+// OutputBridge is exported to C to pass the chunks of a streamed output
+// to the bound io.Writer. Returning false aborts the compilation.
+//
+//export OutputBridge
+func OutputBridge(chunk *C.char, length C.size_t, cidx C.uintptr_t) C.bool {
+	sink, ok := globalOutputs.Get(int(cidx)).(*outputSink)
+	if !ok {
+		fmt.Printf("failed to resolve output sink %d\n", int(cidx))
+		return C.bool(false)
+	}
+	if sink.err != nil {
+		return C.bool(false)
+	}
+	_, sink.err = sink.w.Write(unsafe.Slice((*byte)(unsafe.Pointer(chunk)), int(length)))
+	return C.bool(sink.err == nil)
+}
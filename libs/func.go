@@ -33,10 +33,6 @@ func SassMakeFunction(signature string, idx int) SassFunc {
 
 var globalFuncs SafeMap
 
-func init() {
-	globalFuncs.init()
-}
-
 // BindFuncs attaches a slice of Functions to a sass options. Signatures
 // are already defined in the SassFunc.
 func BindFuncs(opts SassOptions, cookies []Cookie) []int {
@@ -46,6 +42,12 @@ func BindFuncs(opts SassOptions, cookies []Cookie) []int {
 	for i, cookie := range cookies {
 		idx := globalFuncs.Set(cookies[i])
 		fn := SassMakeFunction(cookie.Sign, idx)
+		if cookie.Pure {
+			C.sass_function_set_pure(C.Sass_Function_Entry(fn), true)
+		}
+		if cookie.Batched {
+			C.sass_function_set_batched(C.Sass_Function_Entry(fn), true)
+		}
 		funcs[i] = fn
 		ids[i] = idx
 	}
@@ -20,10 +20,6 @@ import "unsafe"
 
 var globalHeaders SafeMap
 
-func init() {
-	globalHeaders.init()
-}
-
 // BindHeader attaches the header to a libsass context ensuring
 // gc does not delete the pointers necessary to make this happen.
 func BindHeader(opts SassOptions, entries []ImportEntry) int {
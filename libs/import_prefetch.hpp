@@ -0,0 +1,3 @@
+#ifndef USE_LIBSASS
+#include "../libsass-build/import_prefetch.hpp"
+#endif
@@ -51,10 +51,6 @@ const (
 	ResolverModeImporterAbsPath
 )
 
-func init() {
-	globalImports.init()
-}
-
 // BindImporter attaches a custom importer Go function to an import in Sass
 func BindImporter(opts SassOptions, resolverMode ResolverMode, resolver ImportResolver) int {
 
@@ -0,0 +1,52 @@
+package libs
+
+// #include <stdint.h>
+// #include <stdbool.h>
+// #include "sass/context.h"
+//
+// extern bool OutputBridge(const char* chunk, size_t length, uintptr_t idx);
+//
+// bool SassOutputSink(const char* chunk, size_t length, void* cookie)
+// {
+//   uintptr_t idx = (uintptr_t)cookie;
+//   return OutputBridge(chunk, length, idx);
+// }
+//
+import "C"
+import (
+	"io"
+	"unsafe"
+)
+
+var globalOutputs SafeMap
+
+// outputSink remembers the first error of the writer
+type outputSink struct {
+	w   io.Writer
+	err error
+}
+
+// BindOutput streams the compiled css to w instead of the output string.
+// Chunks are written while libsass renders, w must not retain them.
+func BindOutput(opts SassOptions, w io.Writer) int {
+	idx := globalOutputs.Set(&outputSink{w: w})
+	C.sass_option_set_output_sink(
+		(*C.struct_Sass_Options)(unsafe.Pointer(opts)),
+		C.Sass_Output_Sink_Fn(C.SassOutputSink),
+	)
+	C.sass_option_set_output_sink_cookie(
+		(*C.struct_Sass_Options)(unsafe.Pointer(opts)),
+		unsafe.Pointer(uintptr(idx)),
+	)
+	return idx
+}
+
+// RemoveOutput releases the writer and returns its first error
+func RemoveOutput(idx int) error {
+	sink, _ := globalOutputs.Get(idx).(*outputSink)
+	globalOutputs.Del(idx)
+	if sink == nil {
+		return nil
+	}
+	return sink.err
+}
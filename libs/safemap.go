@@ -1,44 +1,104 @@
 package libs
 
-import "sync"
+import (
+	"sync"
+	"sync/atomic"
+)
 
-// globalImports stores []ImportEntry in a place where GC won't
-// delete it
+const (
+	slotBits  = 8
+	slotCount = 1 << slotBits
+	// the low bits of a handle index the table, the high bits hold
+	// the generation of the slot (bumped whenever it is freed)
+	indexBits = 24
+	indexMask = 1<<indexBits - 1
+	genMask   = int(^uint(0)>>1) >> indexBits
+)
+
+// slot boxes a registered value, atomic.Value can neither hold nil
+// nor values of different types
+type slot struct {
+	v    interface{}
+	live bool
+	gen  int
+}
+
+type slots [slotCount]atomic.Value
+
+// SafeMap stores the values registered with libsass (funcs, importers,
+// headers, ...) in a place where GC won't delete them. The handle
+// returned by Set is passed to libsass as the cookie and indexes the
+// table directly. Get never blocks, Set and Del serialize on a mutex
+// lookups don't touch. Slots are reused once deleted, but with a new
+// generation, so a stale handle never finds the next registration.
 type SafeMap struct {
-	sync.RWMutex
-	idx int
-	m   map[int]interface{}
+	mu     sync.Mutex
+	chunks atomic.Value // []*slots, replaced when growing
+	size   int
+	free   []int
 }
 
-func (s *SafeMap) nextidx() int {
-	s.Lock()
-	defer s.Unlock()
-	s.idx++
-	return s.idx
+func (s *SafeMap) slot(idx int) *atomic.Value {
+	chunks, _ := s.chunks.Load().([]*slots)
+	i := idx&indexMask - 1
+	if i < 0 || i>>slotBits >= len(chunks) {
+		return nil
+	}
+	return &chunks[i>>slotBits][i&(slotCount-1)]
 }
 
-func (s *SafeMap) init() {
-	s.m = make(map[int]interface{})
+// entry returns the slot of a live handle
+func (s *SafeMap) entry(idx int) (*atomic.Value, slot) {
+	sl := s.slot(idx)
+	if sl == nil {
+		return nil, slot{}
+	}
+	e, _ := sl.Load().(slot)
+	if !e.live || e.gen != idx>>indexBits {
+		return nil, slot{}
+	}
+	return sl, e
 }
 
 func (s *SafeMap) Get(idx int) interface{} {
-	s.RLock()
-	defer s.RUnlock()
-	return s.m[idx]
+	_, e := s.entry(idx)
+	return e.v
 }
 
 func (s *SafeMap) Del(idx int) {
-	s.Lock()
-	delete(s.m, idx)
-	s.Unlock()
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	sl, e := s.entry(idx)
+	if sl == nil {
+		return
+	}
+	sl.Store(slot{gen: (e.gen + 1) & genMask})
+	s.free = append(s.free, idx&indexMask)
 }
 
 // set accepts an entry and returns an index for it
 func (s *SafeMap) Set(ie interface{}) int {
-	idx := s.nextidx()
-	s.Lock()
-	s.m[idx] = ie
-	defer s.Unlock()
-
-	return idx
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if n := len(s.free); n > 0 {
+		idx := s.free[n-1]
+		s.free = s.free[:n-1]
+		sl := s.slot(idx)
+		e, _ := sl.Load().(slot)
+		sl.Store(slot{v: ie, live: true, gen: e.gen})
+		return e.gen<<indexBits | idx
+	}
+	if s.size == indexMask {
+		panic("libs: too many values registered")
+	}
+	chunks, _ := s.chunks.Load().([]*slots)
+	if s.size>>slotBits == len(chunks) {
+		grown := make([]*slots, len(chunks)+1)
+		copy(grown, chunks)
+		grown[len(chunks)] = new(slots)
+		s.chunks.Store(grown)
+	}
+	s.size++
+	s.slot(s.size).Store(slot{v: ie, live: true})
+	return s.size
 }
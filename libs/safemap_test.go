@@ -0,0 +1,72 @@
+package libs
+
+import "testing"
+
+func TestSafeMap(t *testing.T) {
+	var m SafeMap
+	if m.Get(1) != nil {
+		t.Error("empty map returned a value")
+	}
+	ids := make([]int, 3*slotCount)
+	for i := range ids {
+		ids[i] = m.Set(i)
+	}
+	for i, idx := range ids {
+		if v, _ := m.Get(idx).(int); v != i {
+			t.Errorf("got %v wanted %d", m.Get(idx), i)
+		}
+	}
+
+	m.Del(ids[7])
+	m.Del(ids[7])
+	if m.Get(ids[7]) != nil {
+		t.Error("deleted handle returned a value")
+	}
+	again := m.Set("again")
+	if again == ids[7] || again&indexMask != ids[7] {
+		t.Errorf("slot of handle %d was not reused, got %d", ids[7], again)
+	}
+	// a stale handle must not find the new value
+	if m.Get(ids[7]) != nil {
+		t.Error("stale handle returned a value")
+	}
+	m.Del(ids[7])
+	if v, _ := m.Get(again).(string); v != "again" {
+		t.Errorf("got %v wanted again", m.Get(again))
+	}
+	if idx := m.Set("new"); idx != len(ids)+1 {
+		t.Errorf("got handle %d wanted %d", idx, len(ids)+1)
+	}
+}
+
+func BenchmarkSafeMap_Get(b *testing.B) {
+	var m SafeMap
+	ids := make([]int, 1024)
+	for i := range ids {
+		ids[i] = m.Set(i)
+	}
+	b.ResetTimer()
+	b.RunParallel(func(pb *testing.PB) {
+		i := 0
+		for pb.Next() {
+			if m.Get(ids[i%len(ids)]) == nil {
+				b.Error("missing value")
+				return
+			}
+			i++
+		}
+	})
+}
+
+func BenchmarkSafeMap_SetGetDel(b *testing.B) {
+	var m SafeMap
+	b.RunParallel(func(pb *testing.PB) {
+		for pb.Next() {
+			idx := m.Set(pb)
+			for i := 0; i < 16; i++ {
+				m.Get(idx)
+			}
+			m.Del(idx)
+		}
+	})
+}
@@ -0,0 +1,3 @@
+#ifndef USE_LIBSASS
+#include "../libsass-build/sheet_cache.hpp"
+#endif
@@ -0,0 +1,3 @@
+#ifndef USE_LIBSASS
+#include "../libsass-build/slot_resolver.hpp"
+#endif
@@ -6,6 +6,7 @@
 #include "../libsass-build/backtrace.cpp"
 #include "../libsass-build/base64vlq.cpp"
 #include "../libsass-build/bind.cpp"
+#include "../libsass-build/call_batch.cpp"
 #include "../libsass-build/check_nesting.cpp"
 #include "../libsass-build/color_maps.cpp"
 #include "../libsass-build/constants.cpp"
@@ -17,8 +18,11 @@
 #include "../libsass-build/eval.cpp"
 #include "../libsass-build/expand.cpp"
 #include "../libsass-build/extend.cpp"
+#include "../libsass-build/extend_cache.cpp"
 #include "../libsass-build/file.cpp"
+#include "../libsass-build/function_cache.cpp"
 #include "../libsass-build/functions.cpp"
+#include "../libsass-build/import_prefetch.cpp"
 #include "../libsass-build/inspect.cpp"
 #include "../libsass-build/json.cpp"
 #include "../libsass-build/lexer.cpp"
@@ -26,6 +30,7 @@
 #include "../libsass-build/node.cpp"
 #include "../libsass-build/operators.cpp"
 #include "../libsass-build/output.cpp"
+#include "../libsass-build/parse_cache.cpp"
 #include "../libsass-build/parser.cpp"
 #include "../libsass-build/plugins.cpp"
 #include "../libsass-build/position.cpp"
@@ -37,8 +42,11 @@
 #include "../libsass-build/sass_functions.cpp"
 #include "../libsass-build/sass_util.cpp"
 #include "../libsass-build/sass_values.cpp"
+#include "../libsass-build/sheet_cache.cpp"
+#include "../libsass-build/slot_resolver.cpp"
 #include "../libsass-build/source_map.cpp"
 #include "../libsass-build/subset_map.cpp"
+#include "../libsass-build/symbol.cpp"
 #include "../libsass-build/to_c.cpp"
 #include "../libsass-build/to_value.cpp"
 #include "../libsass-build/units.cpp"
@@ -6,6 +6,7 @@ package libs
 //
 // #//for C.free
 // #include "stdlib.h"
+// #include "string.h"
 //
 // #include "sass/context.h"
 //
@@ -281,6 +282,63 @@ func SassContextGetSourceMapString(goctx SassContext) string {
 	return C.GoString(s)
 }
 
+// SassContextFindSourcePosition finds where a (zero based) position in
+// the compiled css comes from. Only compilations with a source map can
+// be queried, source is the link used in the map.
+func SassContextFindSourcePosition(goctx SassContext, line, column int) (source string, srcLine, srcColumn int, ok bool) {
+	var src *C.char
+	var l, c C.size_t
+	if !C.sass_context_find_source_position(goctx, C.size_t(line), C.size_t(column), &src, &l, &c) {
+		return "", 0, 0, false
+	}
+	return C.GoString(src), int(l), int(c), true
+}
+
+// SassSourceMapping is a single (zero based) mapping of a source map,
+// Source is the link used in the map.
+type SassSourceMapping struct {
+	Line, Column       int
+	Source             string
+	SrcLine, SrcColumn int
+}
+
+// SassContextGetSourceMappings returns the mappings of the source map
+// ordered by their position in the compiled css, without rendering or
+// parsing the json of the map.
+func SassContextGetSourceMappings(goctx SassContext) []SassSourceMapping {
+	size := C.sass_context_get_source_mappings(goctx, nil, 0)
+	if size == 0 {
+		return nil
+	}
+	cmaps := make([]C.struct_Sass_Source_Mapping, int(size))
+	C.sass_context_get_source_mappings(goctx, &cmaps[0], size)
+	sources := make(map[C.size_t]string)
+	mappings := make([]SassSourceMapping, len(cmaps))
+	for i, m := range cmaps {
+		src, ok := sources[m.source]
+		if !ok {
+			src = C.GoString(C.sass_context_get_source_map_source(goctx, m.source))
+			sources[m.source] = src
+		}
+		mappings[i] = SassSourceMapping{
+			Line:      int(m.generated_line),
+			Column:    int(m.generated_column),
+			Source:    src,
+			SrcLine:   int(m.source_line),
+			SrcColumn: int(m.source_column),
+		}
+	}
+	return mappings
+}
+
+// SassContextParseCacheStats reports how many generated selectors and
+// media queries of the compilation were reused and how many were parsed.
+func SassContextParseCacheStats(goctx SassContext) (hits, misses int) {
+	hits = int(C.sass_context_get_parse_cache_hits(goctx))
+	misses = int(C.sass_context_get_parse_cache_misses(goctx))
+	return
+}
+
 // SassOptionSetPrecision sets the precision of floating point math
 // ie. 3.2222px. This is currently bugged and does not work.
 func SassOptionSetPrecision(goopts SassOptions, i int) {
@@ -385,3 +443,164 @@ func SassOptionSetCImporters(goopts SassOptions, golst SassImporterList) {
 func SassOptionSetCFunctions() {
 
 }
+
+// SassSheetCache is a wrapper to C.struct_Sass_Sheet_Cache
+type SassSheetCache *C.struct_Sass_Sheet_Cache
+
+// SassMakeSheetCache creates a cache for parsed sheets that can be
+// shared by many compilations
+func SassMakeSheetCache() SassSheetCache {
+	return (SassSheetCache)(C.sass_make_sheet_cache())
+}
+
+// SassDeleteSheetCache frees the cache, no compilation may be using it
+func SassDeleteSheetCache(cache SassSheetCache) {
+	C.sass_delete_sheet_cache(cache)
+}
+
+// SassSheetCacheClear drops all sheets that are not in use
+func SassSheetCacheClear(cache SassSheetCache) {
+	C.sass_sheet_cache_clear(cache)
+}
+
+// SassSheetCacheInvalidate drops all cached sheets of the file
+func SassSheetCacheInvalidate(cache SassSheetCache, path string) {
+	s := C.CString(path)
+	defer C.free(unsafe.Pointer(s))
+	C.sass_sheet_cache_invalidate(cache, s)
+}
+
+// SassSheetCacheStats reports hits, misses and the number of cached sheets
+func SassSheetCacheStats(cache SassSheetCache) (hits, misses, size int) {
+	hits = int(C.sass_sheet_cache_get_hits(cache))
+	misses = int(C.sass_sheet_cache_get_misses(cache))
+	size = int(C.sass_sheet_cache_get_size(cache))
+	return
+}
+
+// SassSheetCacheExtendStats reports hits, misses and the number of
+// cached extended selectors
+func SassSheetCacheExtendStats(cache SassSheetCache) (hits, misses, size int) {
+	hits = int(C.sass_sheet_cache_get_extend_hits(cache))
+	misses = int(C.sass_sheet_cache_get_extend_misses(cache))
+	size = int(C.sass_sheet_cache_get_extend_size(cache))
+	return
+}
+
+// SassOptionSetSheetCache attaches a sheet cache to the options
+func SassOptionSetSheetCache(goopts SassOptions, cache SassSheetCache) {
+	C.sass_option_set_sheet_cache(goopts, cache)
+}
+
+// SassBatch is a wrapper to C.struct_Sass_Batch
+type SassBatch *C.struct_Sass_Batch
+
+// SassMakeBatch creates a batch of file contexts sharing options
+func SassMakeBatch() SassBatch {
+	return (SassBatch)(C.sass_make_batch())
+}
+
+// SassDeleteBatch frees the batch and all of its file contexts
+func SassDeleteBatch(batch SassBatch) {
+	C.sass_delete_batch(batch)
+}
+
+// SassBatchGetOptions returns the options shared by all entries
+func SassBatchGetOptions(batch SassBatch) SassOptions {
+	return (SassOptions)(C.sass_batch_get_options(batch))
+}
+
+// SassBatchAddFile adds an entry file to the batch
+func SassBatchAddFile(batch SassBatch, path string) SassFileContext {
+	s := C.CString(path)
+	defer C.free(unsafe.Pointer(s))
+	return (SassFileContext)(C.sass_batch_add_file(batch, s))
+}
+
+// SassBatchGetFileContext returns the file context of entry i
+func SassBatchGetFileContext(batch SassBatch, i int) SassFileContext {
+	return (SassFileContext)(C.sass_batch_get_file_context(batch, C.size_t(i)))
+}
+
+// SassCompileBatch compiles all entries on up to threads threads and
+// returns the number of failed entries
+func SassCompileBatch(batch SassBatch, threads int) int {
+	return int(C.sass_compile_batch(batch, C.int(threads)))
+}
+
+// SassBatchRecompile compiles the entries depending on the changed
+// files (and the ones that failed before) and returns the number of
+// failed entries
+func SassBatchRecompile(batch SassBatch, changed []string, threads int) int {
+	size := unsafe.Sizeof((*C.char)(nil))
+	carr := (**C.char)(C.calloc(C.size_t(len(changed)+1), C.size_t(size)))
+	defer C.free(unsafe.Pointer(carr))
+	paths := unsafe.Slice(carr, len(changed)+1)
+	for i, path := range changed {
+		paths[i] = C.CString(path)
+	}
+	defer func() {
+		for _, path := range paths {
+			C.free(unsafe.Pointer(path))
+		}
+	}()
+	return int(C.sass_batch_recompile(batch, carr, C.int(threads)))
+}
+
+// SassBatchGetCompiled lists the entries compiled by the last call
+func SassBatchGetCompiled(batch SassBatch) []int {
+	compiled := make([]int, int(C.sass_batch_get_compiled_size(batch)))
+	for i := range compiled {
+		compiled[i] = int(C.sass_batch_get_compiled(batch, C.size_t(i)))
+	}
+	return compiled
+}
+
+// SassBuffer holds a string taken over from libsass. Bytes points to
+// C memory and is only valid until Release is called.
+type SassBuffer struct {
+	Bytes []byte
+	cstr  *C.char
+}
+
+func takeBuffer(cstr *C.char) *SassBuffer {
+	if cstr == nil {
+		return &SassBuffer{}
+	}
+	return &SassBuffer{
+		Bytes: unsafe.Slice((*byte)(unsafe.Pointer(cstr)), int(C.strlen(cstr))),
+		cstr:  cstr,
+	}
+}
+
+// Release frees the C memory behind Bytes
+func (b *SassBuffer) Release() {
+	C.free(unsafe.Pointer(b.cstr))
+	b.cstr = nil
+	b.Bytes = nil
+}
+
+// SassContextTakeOutput takes over the compiled CSS without copying it
+// to Go memory. The buffer must be released by the caller.
+func SassContextTakeOutput(goctx SassContext) *SassBuffer {
+	return takeBuffer(C.sass_context_take_output_string(goctx))
+}
+
+// SassContextTakeSourceMap takes over the source map without copying
+// it to Go memory. The buffer must be released by the caller.
+func SassContextTakeSourceMap(goctx SassContext) *SassBuffer {
+	return takeBuffer(C.sass_context_take_source_map_string(goctx))
+}
+
+// SassContextTakeErrorJSON takes over the error in JSON format
+func SassContextTakeErrorJSON(goctx SassContext) string {
+	cstr := C.sass_context_take_error_json(goctx)
+	defer C.free(unsafe.Pointer(cstr))
+	return C.GoString(cstr)
+}
+
+// SassOptionSetImportThreads sets the number of threads parsing the
+// imports of the entry file ahead of time
+func SassOptionSetImportThreads(goopts SassOptions, i int) {
+	C.sass_option_set_import_threads(goopts, C.int(i))
+}
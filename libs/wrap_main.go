@@ -7,5 +7,6 @@ package libs
 // #cgo CXXFLAGS: -g -std=c++0x -O2 -fPIC
 // #cgo LDFLAGS: -lstdc++ -lm
 // #cgo darwin linux LDFLAGS: -ldl
+// #cgo linux LDFLAGS: -lpthread
 //
 import "C"
@@ -0,0 +1,221 @@
+package libs
+
+import (
+	"os"
+	"path/filepath"
+	"strings"
+	"testing"
+)
+
+func TestSassContextTakeOutput(t *testing.T) {
+	godc := SassMakeDataContext(`div { p { color: red; } }`)
+	defer SassDeleteDataContext(godc)
+	goopts := SassDataContextGetOptions(godc)
+	SassOptionSetSourceMapFile(goopts, "out.css.map")
+	SassDataContextSetOptions(godc, goopts)
+	gocompiler := SassMakeDataCompiler(godc)
+	SassCompilerParse(gocompiler)
+	SassCompilerExecute(gocompiler)
+	SassDeleteCompiler(gocompiler)
+
+	goctx := SassDataContextGetContext(godc)
+	out := SassContextTakeOutput(goctx)
+	e := "div p {\n  color: red; }\n\n/*# sourceMappingURL=out.css.map */"
+	if string(out.Bytes) != e {
+		t.Errorf("got:\n%s\nwanted:\n%s", out.Bytes, e)
+	}
+	out.Release()
+	if out.Bytes != nil {
+		t.Error("released buffer still has bytes")
+	}
+
+	smap := SassContextTakeSourceMap(goctx)
+	if len(smap.Bytes) == 0 || smap.Bytes[0] != '{' {
+		t.Errorf("unexpected source map: %s", smap.Bytes)
+	}
+	smap.Release()
+
+	// taken once only, the context has nothing left
+	out = SassContextTakeOutput(goctx)
+	if out.Bytes != nil {
+		t.Errorf("output taken twice: %s", out.Bytes)
+	}
+	out.Release()
+}
+
+func TestSassContextFindSourcePosition(t *testing.T) {
+	godc := SassMakeDataContext("@charset \"UTF-8\";\n/* \u00fc */\ndiv {\n  p { color: red; }\n}\n")
+	defer SassDeleteDataContext(godc)
+	goopts := SassDataContextGetOptions(godc)
+	SassOptionSetSourceMapFile(goopts, "out.css.map")
+	SassDataContextSetOptions(godc, goopts)
+	gocompiler := SassMakeDataCompiler(godc)
+	SassCompilerParse(gocompiler)
+	SassCompilerExecute(gocompiler)
+	SassDeleteCompiler(gocompiler)
+	goctx := SassDataContextGetContext(godc)
+
+	// the charset and the comment come first
+	e := "@charset \"UTF-8\";\n/* \u00fc */\ndiv p {\n  color: red; }\n"
+	out := SassContextTakeOutput(goctx)
+	defer out.Release()
+	if string(out.Bytes[:len(e)]) != e {
+		t.Fatalf("got:\n%s\nwanted:\n%s", out.Bytes, e)
+	}
+	tests := []struct {
+		line, column, srcLine, srcColumn int
+		ok                               bool
+	}{
+		{2, 0, 3, 2, true},  // div p
+		{2, 4, 3, 2, true},  // within the selector
+		{3, 2, 3, 6, true},  // color
+		{3, 9, 3, 13, true}, // red
+		{0, 0, 0, 0, false}, // the charset is not mapped
+		{9, 0, 0, 0, false},
+	}
+	for _, test := range tests {
+		src, l, c, ok := SassContextFindSourcePosition(goctx, test.line, test.column)
+		if ok != test.ok || (ok && (src != "stdin" || l != test.srcLine || c != test.srcColumn)) {
+			t.Errorf("%d:%d got: %s %d:%d %v wanted: %d:%d %v", test.line, test.column,
+				src, l, c, ok, test.srcLine, test.srcColumn, test.ok)
+		}
+	}
+}
+
+func TestSassContextParseCacheStats(t *testing.T) {
+	godc := SassMakeDataContext(`@mixin bp { @media (min-width: 1px) { @content; } }
+@for $i from 1 through 3 {
+  .#{"a"} { @include bp { b: $i; } }
+  .c { d: selector-nest(".e", "&:hover"); }
+}`)
+	defer SassDeleteDataContext(godc)
+	gocompiler := SassMakeDataCompiler(godc)
+	SassCompilerParse(gocompiler)
+	SassCompilerExecute(gocompiler)
+	SassDeleteCompiler(gocompiler)
+	goctx := SassDataContextGetContext(godc)
+
+	// the selector, the query and both arguments of selector-nest
+	// are parsed once and reused twice
+	hits, misses := SassContextParseCacheStats(goctx)
+	if hits != 8 || misses != 4 {
+		t.Errorf("got: %d hits %d misses wanted: 8 hits 4 misses", hits, misses)
+	}
+}
+
+func TestSassContextGetSourceMappings(t *testing.T) {
+	godc := SassMakeDataContext("div {\n  p { color: red; }\n}\n")
+	defer SassDeleteDataContext(godc)
+	goopts := SassDataContextGetOptions(godc)
+	SassOptionSetSourceMapFile(goopts, "out.css.map")
+	SassDataContextSetOptions(godc, goopts)
+	gocompiler := SassMakeDataCompiler(godc)
+	SassCompilerParse(gocompiler)
+	SassCompilerExecute(gocompiler)
+	SassDeleteCompiler(gocompiler)
+	goctx := SassDataContextGetContext(godc)
+
+	mappings := SassContextGetSourceMappings(goctx)
+	if len(mappings) == 0 {
+		t.Fatal("no mappings")
+	}
+	for i, m := range mappings {
+		if m.Source != "stdin" {
+			t.Errorf("%d got source: %s", i, m.Source)
+		}
+		if i > 0 && (m.Line < mappings[i-1].Line ||
+			m.Line == mappings[i-1].Line && m.Column < mappings[i-1].Column) {
+			t.Errorf("%d out of order: %v %v", i, mappings[i-1], m)
+		}
+		// the lookup agrees with the last mapping of a position
+		if i+1 < len(mappings) && mappings[i+1].Line == m.Line &&
+			mappings[i+1].Column == m.Column {
+			continue
+		}
+		src, l, c, ok := SassContextFindSourcePosition(goctx, m.Line, m.Column)
+		if !ok || src != m.Source || l != m.SrcLine || c != m.SrcColumn {
+			t.Errorf("%d got: %s %d:%d %v wanted: %v", i, src, l, c, ok, m)
+		}
+	}
+	// div of div p
+	e := SassSourceMapping{Line: 0, Column: 0, Source: "stdin", SrcLine: 0, SrcColumn: 0}
+	if mappings[0] != e {
+		t.Errorf("got: %v wanted: %v", mappings[0], e)
+	}
+}
+
+func TestSassContextSourceMapUTF8(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "utf8.scss")
+	src := "/* é\U0001F600 */\ndiv { color: red; }\n"
+	if err := os.WriteFile(path, []byte(src), 0644); err != nil {
+		t.Fatal(err)
+	}
+	// the whole compile reports errors thrown
+	// while the source map is rendered
+	compile := func(root string) SassFileContext {
+		gofc := SassMakeFileContext(path)
+		goopts := SassFileContextGetOptions(gofc)
+		SassOptionSetSourceMapFile(goopts, "out.css.map")
+		SassOptionSetSourceMapContents(goopts, true)
+		SassOptionSetSourceMapRoot(goopts, root)
+		SassFileContextSetOptions(gofc, goopts)
+		SassCompileFileContext(gofc)
+		return gofc
+	}
+
+	// valid characters are copied as they are
+	gofc := compile("/é")
+	defer SassDeleteFileContext(gofc)
+	goctx := SassFileContextGetContext(gofc)
+	if status := SassContextGetErrorStatus(goctx); status != 0 {
+		t.Fatalf("got status: %d", status)
+	}
+	m := SassContextGetSourceMapString(goctx)
+	for _, e := range []string{
+		`"sourceRoot": "/é"`,
+		`"/* é😀 */\ndiv { color: red; }\n"`,
+	} {
+		if !strings.Contains(m, e) {
+			t.Errorf("got:\n%s\nwanted:\n%s", m, e)
+		}
+	}
+
+	// invalid bytes are an error like in json_stringify,
+	// builds with NDEBUG write U+FFFD for them instead
+	gofc = compile("/\xff")
+	defer SassDeleteFileContext(gofc)
+	goctx = SassFileContextGetContext(gofc)
+	if status := SassContextGetErrorStatus(goctx); status == 0 {
+		t.Errorf("no error for invalid utf-8:\n%s", SassContextGetSourceMapString(goctx))
+	}
+}
+
+func TestGoBridgeReusedHandle(t *testing.T) {
+	cookies := []Cookie{{
+		Sign: "bridged()",
+		Fn: func(v interface{}, csv UnionSassValue, rsv *UnionSassValue) error {
+			*rsv = MakeString("ok")
+			return nil
+		},
+	}}
+	// the freed slot is reused with a new generation
+	// every time, handles must pass the bridge intact
+	for i := 0; i < 300; i++ {
+		godc := SassMakeDataContext("div { a: bridged(); }")
+		goopts := SassDataContextGetOptions(godc)
+		ids := BindFuncs(goopts, cookies)
+		SassDataContextSetOptions(godc, goopts)
+		gocompiler := SassMakeDataCompiler(godc)
+		SassCompilerParse(gocompiler)
+		SassCompilerExecute(gocompiler)
+		SassDeleteCompiler(gocompiler)
+		buf := SassContextTakeOutput(SassDataContextGetContext(godc))
+		out := string(buf.Bytes)
+		buf.Release()
+		RemoveFuncs(ids)
+		SassDeleteDataContext(godc)
+		if e := "div {\n  a: ok; }\n"; out != e {
+			t.Fatalf("compile %d got:\n%s\nwanted:\n%s", i, out, e)
+		}
+	}
+}
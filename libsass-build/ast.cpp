@@ -17,8 +17,6 @@
 
 namespace Sass {
 
-  static Null sass_null(ParserState("null"));
-
   bool Wrapped_Selector::find ( bool (*f)(AST_Node_Obj) )
   {
     // check children first
@@ -505,10 +503,52 @@ namespace Sass {
     return false;
   }
 
+  bool Simple_Selector::has_arguments() const
+  {
+    if (simple_type() == WRAPPED_SEL) return true;
+    if (Pseudo_Selector_Ptr_Const pseudo = Cast<Pseudo_Selector>(this)) return pseudo->expression();
+    if (Attribute_Selector_Ptr_Const attr = Cast<Attribute_Selector>(this)) return attr->value();
+    return false;
+  }
+
+  Symbol Simple_Selector::symbol()
+  {
+    if (!symbol_ && !has_arguments()) symbol_ = selector_symbol(to_string());
+    return symbol_;
+  }
+
+  // Selectors are matched by their rendering, either interned or
+  // as a string for selectors with arguments (see `symbol`).
+  typedef std::pair<Symbol, std::string> Selector_Key;
+
+  static Selector_Key selector_key(Selector_Ptr sel)
+  {
+    if (Simple_Selector_Ptr simple = Cast<Simple_Selector>(sel)) {
+      if (Symbol symbol = simple->symbol()) return Selector_Key(symbol, "");
+    }
+    return Selector_Key(0, sel->to_string());
+  }
+
+  // sorted set of selector keys
+  static void unique_keys(std::vector<Selector_Key>& keys)
+  {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  }
+
+  // strip off colons to ensure :after matches ::after since ruby sass is forgiving
+  static std::string pseudo_element_name(Simple_Selector_Ptr sel)
+  {
+    Symbol symbol = sel->symbol();
+    std::string pseudo(symbol ? *symbol : sel->to_string());
+    return pseudo.substr(pseudo.find_first_not_of(":"));
+  }
+
   Compound_Selector_Ptr Simple_Selector::unify_with(Compound_Selector_Ptr rhs)
   {
+    Selector_Key self(selector_key(this));
     for (size_t i = 0, L = rhs->length(); i < L; ++i)
-    { if (to_string() == rhs->at(i)->to_string()) return rhs; }
+    { if (self == selector_key(rhs->at(i))) return rhs; }
 
     // check for pseudo elements because they are always last
     size_t i, L;
@@ -841,7 +881,7 @@ namespace Sass {
     return false;
   }
 
-  bool Compound_Selector::is_superselector_of(Selector_List_Obj rhs, std::string wrapped)
+  bool Compound_Selector::is_superselector_of(Selector_List_Obj rhs, const std::string& wrapped)
   {
     for (Complex_Selector_Obj item : rhs->elements()) {
       if (is_superselector_of(item, wrapped)) return true;
@@ -849,13 +889,13 @@ namespace Sass {
     return false;
   }
 
-  bool Compound_Selector::is_superselector_of(Complex_Selector_Obj rhs, std::string wrapped)
+  bool Compound_Selector::is_superselector_of(Complex_Selector_Obj rhs, const std::string& wrapped)
   {
     if (rhs->head()) return is_superselector_of(rhs->head(), wrapped);
     return false;
   }
 
-  bool Compound_Selector::is_superselector_of(Compound_Selector_Obj rhs, std::string wrapping)
+  bool Compound_Selector::is_superselector_of(Compound_Selector_Obj rhs, const std::string& wrapping)
   {
     Compound_Selector_Ptr lhs = this;
     Simple_Selector_Ptr lbase = lhs->base();
@@ -867,35 +907,32 @@ namespace Sass {
     for (size_t i = 0, L = length(); i < L; ++i)
     {
       if ((*this)[i]->is_pseudo_element()) {
-        std::string pseudo((*this)[i]->to_string());
-        pseudo = pseudo.substr(pseudo.find_first_not_of(":")); // strip off colons to ensure :after matches ::after since ruby sass is forgiving
-        lpsuedoset.insert(pseudo);
+        lpsuedoset.insert(pseudo_element_name((*this)[i]));
       }
     }
     for (size_t i = 0, L = rhs->length(); i < L; ++i)
     {
       if ((*rhs)[i]->is_pseudo_element()) {
-        std::string pseudo((*rhs)[i]->to_string());
-        pseudo = pseudo.substr(pseudo.find_first_not_of(":")); // strip off colons to ensure :after matches ::after since ruby sass is forgiving
-        rpsuedoset.insert(pseudo);
+        rpsuedoset.insert(pseudo_element_name((*rhs)[i]));
       }
     }
     if (lpsuedoset != rpsuedoset) {
       return false;
     }
 
-    // would like to replace this without stringification
     // https://github.com/sass/sass/issues/2229
-    // SimpleSelectorSet lset, rset;
-    std::set<std::string> lset, rset;
+    // selectors are matched by their rendering
+    std::vector<Selector_Key> lset, rset;
 
     if (lbase && rbase)
     {
-      if (lbase->to_string() == rbase->to_string()) {
+      if (selector_key(lbase) == selector_key(rbase)) {
         for (size_t i = 1, L = length(); i < L; ++i)
-        { lset.insert((*this)[i]->to_string()); }
+        { lset.push_back(selector_key((*this)[i])); }
         for (size_t i = 1, L = rhs->length(); i < L; ++i)
-        { rset.insert((*rhs)[i]->to_string()); }
+        { rset.push_back(selector_key((*rhs)[i])); }
+        unique_keys(lset);
+        unique_keys(rset);
         return includes(rset.begin(), rset.end(), lset.begin(), lset.end());
       }
       return false;
@@ -933,8 +970,8 @@ namespace Sass {
           }}
         }
       }
-      // match from here on as strings
-      lset.insert(wlhs->to_string());
+      // match from here on by rendering
+      lset.push_back(selector_key(wlhs));
     }
 
     for (size_t n = 0, nL = rhs->length(); n < nL; ++n)
@@ -957,13 +994,15 @@ namespace Sass {
           }
         }
       }
-      rset.insert(r->to_string());
+      rset.push_back(selector_key(r));
     }
 
     //for (auto l : lset) { cerr << "l: " << l << endl; }
     //for (auto r : rset) { cerr << "r: " << r << endl; }
 
     if (lset.empty()) return true;
+    unique_keys(lset);
+    unique_keys(rset);
     // return true if rset contains all the elements of lset
     return includes(rset.begin(), rset.end(), lset.begin(), lset.end());
 
@@ -1039,8 +1078,8 @@ namespace Sass {
     // do some magic we inherit from node and extend
     Node node = subweave(lhsNode, rhsNode);
     Selector_List_Obj result = SASS_MEMORY_NEW(Selector_List, pstate());
-    NodeDequePtr col = node.collection(); // move from collection to list
-    for (NodeDeque::iterator it = col->begin(), end = col->end(); it != end; it++)
+    NodeCollectionPtr col = node.collection(); // move from collection to list
+    for (NodeCollection::iterator it = col->begin(), end = col->end(); it != end; it++)
     { result->append(nodeToComplexSelector(Node::naiveTrim(*it))); }
 
     // only return if list has some entries
@@ -1080,12 +1119,12 @@ namespace Sass {
     // there is no break?!
   }
 
-  bool Complex_Selector::is_superselector_of(Compound_Selector_Obj rhs, std::string wrapping)
+  bool Complex_Selector::is_superselector_of(Compound_Selector_Obj rhs, const std::string& wrapping)
   {
     return last()->head() && last()->head()->is_superselector_of(rhs, wrapping);
   }
 
-  bool Complex_Selector::is_superselector_of(Complex_Selector_Obj rhs, std::string wrapping)
+  bool Complex_Selector::is_superselector_of(Complex_Selector_Obj rhs, const std::string& wrapping)
   {
     Complex_Selector_Ptr lhs = this;
     // check for selectors with leading or trailing combinators
@@ -1603,7 +1642,7 @@ namespace Sass {
 
   // it's a superselector if every selector of the right side
   // list is a superselector of the given left side selector
-  bool Complex_Selector::is_superselector_of(Selector_List_Obj sub, std::string wrapping)
+  bool Complex_Selector::is_superselector_of(Selector_List_Obj sub, const std::string& wrapping)
   {
     // Check every rhs selector against left hand list
     for(size_t i = 0, L = sub->length(); i < L; ++i) {
@@ -1614,7 +1653,7 @@ namespace Sass {
 
   // it's a superselector if every selector of the right side
   // list is a superselector of the given left side selector
-  bool Selector_List::is_superselector_of(Selector_List_Obj sub, std::string wrapping)
+  bool Selector_List::is_superselector_of(Selector_List_Obj sub, const std::string& wrapping)
   {
     // Check every rhs selector against left hand list
     for(size_t i = 0, L = sub->length(); i < L; ++i) {
@@ -1625,7 +1664,7 @@ namespace Sass {
 
   // it's a superselector if every selector on the right side
   // is a superselector of any one of the left side selectors
-  bool Selector_List::is_superselector_of(Compound_Selector_Obj sub, std::string wrapping)
+  bool Selector_List::is_superselector_of(Compound_Selector_Obj sub, const std::string& wrapping)
   {
     // Check every lhs selector against right hand
     for(size_t i = 0, L = length(); i < L; ++i) {
@@ -1636,7 +1675,7 @@ namespace Sass {
 
   // it's a superselector if every selector on the right side
   // is a superselector of any one of the left side selectors
-  bool Selector_List::is_superselector_of(Complex_Selector_Obj sub, std::string wrapping)
+  bool Selector_List::is_superselector_of(Complex_Selector_Obj sub, const std::string& wrapping)
   {
     // Check every lhs selector against right hand
     for(size_t i = 0, L = length(); i < L; ++i) {
@@ -1718,10 +1757,10 @@ namespace Sass {
     for (size_t i = 0, L = length(); i < L; ++i)
     {
       bool found = false;
-      std::string thisSelector((*this)[i]->to_string());
+      Selector_Key thisSelector(selector_key((*this)[i]));
       for (size_t j = 0, M = rhs->length(); j < M; ++j)
       {
-        if (thisSelector == (*rhs)[j]->to_string())
+        if (thisSelector == selector_key((*rhs)[j]))
         {
           found = true;
           break;
@@ -1813,6 +1852,17 @@ namespace Sass {
     return true;
   }
 
+  const std::string& Color::disp() const
+  {
+    static const std::string none;
+    return disp_ ? *disp_ : none;
+  }
+
+  void Color::disp(const std::string& name)
+  {
+    disp_ = name.empty() ? 0 : intern_color_name(name);
+  }
+
   Number::Number(ParserState pstate, double val, std::string u, bool zero)
   : Value(pstate),
     Units(),
@@ -958,6 +958,8 @@ namespace Sass {
     ADD_PROPERTY(void*, cookie)
     ADD_PROPERTY(bool, is_overload_stub)
     ADD_PROPERTY(Signature, signature)
+    // variables declared in each call frame
+    ADD_CONSTREF(std::vector<Symbol>, slots)
   public:
     Definition(const Definition* ptr)
     : Has_Block(ptr),
@@ -969,7 +971,8 @@ namespace Sass {
       c_function_(ptr->c_function_),
       cookie_(ptr->cookie_),
       is_overload_stub_(ptr->is_overload_stub_),
-      signature_(ptr->signature_)
+      signature_(ptr->signature_),
+      slots_(ptr->slots_)
     { }
 
     Definition(ParserState pstate,
@@ -1031,17 +1034,27 @@ namespace Sass {
   // Mixin calls (i.e., `@include ...`).
   //////////////////////////////////////
   class Mixin_Call : public Has_Block {
-    ADD_CONSTREF(std::string, name)
+    std::string name_;
+    Symbol symbol_;
     ADD_PROPERTY(Arguments_Obj, arguments)
   public:
     Mixin_Call(ParserState pstate, std::string n, Arguments_Obj args, Block_Obj b = 0)
-    : Has_Block(pstate, b), name_(n), arguments_(args)
+    : Has_Block(pstate, b), name_(n), symbol_(0), arguments_(args)
     { }
     Mixin_Call(const Mixin_Call* ptr)
     : Has_Block(ptr),
       name_(ptr->name_),
+      symbol_(ptr->symbol_),
       arguments_(ptr->arguments_)
     { }
+    const std::string& name() const { return name_; }
+    void name(std::string n) { symbol_ = 0; name_ = n; }
+    // interned on first lookup
+    Symbol symbol()
+    {
+      if (!symbol_) symbol_ = mixin_symbol(name_);
+      return symbol_;
+    }
     ATTACH_AST_OPERATIONS(Mixin_Call)
     ATTACH_OPERATIONS()
   };
@@ -1466,7 +1479,8 @@ namespace Sass {
   // Function calls.
   //////////////////
   class Function_Call : public PreValue {
-    HASH_CONSTREF(std::string, name)
+    std::string name_;
+    Symbol symbol_;
     HASH_PROPERTY(Arguments_Obj, arguments)
     HASH_PROPERTY(Function_Obj, func)
     ADD_PROPERTY(bool, via_call)
@@ -1474,17 +1488,18 @@ namespace Sass {
     size_t hash_;
   public:
     Function_Call(ParserState pstate, std::string n, Arguments_Obj args, void* cookie)
-    : PreValue(pstate), name_(n), arguments_(args), func_(0), via_call_(false), cookie_(cookie), hash_(0)
+    : PreValue(pstate), name_(n), symbol_(0), arguments_(args), func_(0), via_call_(false), cookie_(cookie), hash_(0)
     { concrete_type(FUNCTION); }
     Function_Call(ParserState pstate, std::string n, Arguments_Obj args, Function_Obj func)
-    : PreValue(pstate), name_(n), arguments_(args), func_(func), via_call_(false), cookie_(0), hash_(0)
+    : PreValue(pstate), name_(n), symbol_(0), arguments_(args), func_(func), via_call_(false), cookie_(0), hash_(0)
     { concrete_type(FUNCTION); }
     Function_Call(ParserState pstate, std::string n, Arguments_Obj args)
-    : PreValue(pstate), name_(n), arguments_(args), via_call_(false), cookie_(0), hash_(0)
+    : PreValue(pstate), name_(n), symbol_(0), arguments_(args), via_call_(false), cookie_(0), hash_(0)
     { concrete_type(FUNCTION); }
     Function_Call(const Function_Call* ptr)
     : PreValue(ptr),
       name_(ptr->name_),
+      symbol_(ptr->symbol_),
       arguments_(ptr->arguments_),
       func_(ptr->func_),
       via_call_(ptr->via_call_),
@@ -1492,6 +1507,15 @@ namespace Sass {
       hash_(ptr->hash_)
     { concrete_type(FUNCTION); }
 
+    const std::string& name() const { return name_; }
+    void name(std::string n) { hash_ = 0; symbol_ = 0; name_ = n; }
+    // interned on first lookup, with underscores normalized
+    Symbol symbol()
+    {
+      if (!symbol_) symbol_ = function_symbol(Util::normalize_underscores(name_));
+      return symbol_;
+    }
+
     bool is_css() {
       if (func_) return func_->is_css();
       return false;
@@ -1551,15 +1575,28 @@ namespace Sass {
   // Variable references.
   ///////////////////////
   class Variable : public PreValue {
-    ADD_CONSTREF(std::string, name)
+    std::string name_;
+    Symbol symbol_;
+    // slot + 1 in the frame of the enclosing
+    // mixin or function, set by Slot_Resolver
+    ADD_PROPERTY(size_t, slot)
   public:
     Variable(ParserState pstate, std::string n)
-    : PreValue(pstate), name_(n)
+    : PreValue(pstate), name_(n), symbol_(0), slot_(0)
     { concrete_type(VARIABLE); }
     Variable(const Variable* ptr)
-    : PreValue(ptr), name_(ptr->name_)
+    : PreValue(ptr), name_(ptr->name_), symbol_(ptr->symbol_), slot_(ptr->slot_)
     { concrete_type(VARIABLE); }
 
+    const std::string& name() const { return name_; }
+    void name(std::string n) { symbol_ = 0; name_ = n; }
+    // interned on first lookup
+    Symbol symbol()
+    {
+      if (!symbol_) symbol_ = variable_symbol(name_);
+      return symbol_;
+    }
+
     virtual bool operator==(const Expression& rhs) const
     {
       try
@@ -1592,6 +1629,12 @@ namespace Sass {
     size_t hash_;
   public:
     Number(ParserState pstate, double val, std::string u = "", bool zero = true);
+    Number(ParserState pstate, double val, const Units& units, bool zero = true)
+    : Value(pstate),
+      Units(units),
+      value_(val), zero_(zero),
+      hash_(0)
+    { concrete_type(NUMBER); }
 
     Number(const Number* ptr)
     : Value(ptr),
@@ -1611,10 +1654,10 @@ namespace Sass {
     {
       if (hash_ == 0) {
         hash_ = std::hash<double>()(value_);
-        for (const auto numerator : numerators)
-          hash_combine(hash_, std::hash<std::string>()(numerator));
-        for (const auto denominator : denominators)
-          hash_combine(hash_, std::hash<std::string>()(denominator));
+        for (size_t i = 0, L = numerators.size(); i < L; ++i)
+          hash_combine(hash_, std::hash<Unit_Id>()(numerators[i]));
+        for (size_t i = 0, L = denominators.size(); i < L; ++i)
+          hash_combine(hash_, std::hash<Unit_Id>()(~denominators[i]));
       }
       return hash_;
     }
@@ -1634,13 +1677,14 @@ namespace Sass {
     HASH_PROPERTY(double, g)
     HASH_PROPERTY(double, b)
     HASH_PROPERTY(double, a)
-    ADD_CONSTREF(std::string, disp)
+    // name as written in the source (interned)
+    const std::string* disp_;
     size_t hash_;
   public:
-    Color(ParserState pstate, double r, double g, double b, double a = 1, const std::string disp = "")
-    : Value(pstate), r_(r), g_(g), b_(b), a_(a), disp_(disp),
+    Color(ParserState pstate, double r, double g, double b, double a = 1, const std::string& disp = "")
+    : Value(pstate), r_(r), g_(g), b_(b), a_(a), disp_(0),
       hash_(0)
-    { concrete_type(COLOR); }
+    { concrete_type(COLOR); this->disp(disp); }
     Color(const Color* ptr)
     : Value(ptr),
       r_(ptr->r_),
@@ -1653,6 +1697,9 @@ namespace Sass {
     std::string type() const { return "color"; }
     static std::string type_name() { return "color"; }
 
+    const std::string& disp() const;
+    void disp(const std::string& name);
+
     virtual size_t hash()
     {
       if (hash_ == 0) {
@@ -2346,13 +2393,15 @@ namespace Sass {
   // Abstract base class for simple selectors.
   ////////////////////////////////////////////
   class Simple_Selector : public Selector {
-    ADD_CONSTREF(std::string, ns)
-    ADD_CONSTREF(std::string, name)
+    SELECTOR_CONSTREF(std::string, ns)
+    SELECTOR_CONSTREF(std::string, name)
     ADD_PROPERTY(Simple_Type, simple_type)
-    ADD_PROPERTY(bool, has_ns)
+    SELECTOR_PROPERTY(bool, has_ns)
+  protected:
+    Symbol symbol_;
   public:
     Simple_Selector(ParserState pstate, std::string n = "")
-    : Selector(pstate), ns_(""), name_(n), has_ns_(false)
+    : Selector(pstate), ns_(""), name_(n), has_ns_(false), symbol_(0)
     {
       simple_type(SIMPLE);
       size_t pos = n.find('|');
@@ -2367,8 +2416,16 @@ namespace Sass {
     : Selector(ptr),
       ns_(ptr->ns_),
       name_(ptr->name_),
-      has_ns_(ptr->has_ns_)
+      has_ns_(ptr->has_ns_),
+      symbol_(ptr->symbol_)
     { simple_type(SIMPLE); }
+    // the rendered selector interned once, so selectors that print
+    // the same are compared and collected by pointer. Selectors with
+    // arguments are too diverse to intern them, they return 0 and
+    // are compared by their rendering instead, like any selector
+    // first rendered after the table of symbols is full.
+    Symbol symbol();
+    bool has_arguments() const;
     virtual std::string ns_name() const
     {
       std::string name("");
@@ -2560,10 +2617,10 @@ namespace Sass {
   // Attribute selectors -- e.g., [src*=".jpg"], etc.
   ///////////////////////////////////////////////////
   class Attribute_Selector : public Simple_Selector {
-    ADD_CONSTREF(std::string, matcher)
+    SELECTOR_CONSTREF(std::string, matcher)
     // this cannot be changed to obj atm!!!!!!????!!!!!!!
-    ADD_PROPERTY(String_Obj, value) // might be interpolated
-    ADD_PROPERTY(char, modifier);
+    SELECTOR_PROPERTY(String_Obj, value) // might be interpolated
+    SELECTOR_PROPERTY(char, modifier);
   public:
     Attribute_Selector(ParserState pstate, std::string n, std::string m, String_Obj v, char o = 0)
     : Simple_Selector(pstate, n), matcher_(m), value_(v), modifier_(o)
@@ -2612,7 +2669,7 @@ namespace Sass {
 
   // Pseudo Selector cannot have any namespace?
   class Pseudo_Selector : public Simple_Selector {
-    ADD_PROPERTY(String_Obj, expression)
+    SELECTOR_PROPERTY(String_Obj, expression)
   public:
     Pseudo_Selector(ParserState pstate, std::string n, String_Obj expr = 0)
     : Simple_Selector(pstate, n), expression_(expr)
@@ -2740,9 +2797,9 @@ namespace Sass {
         return (*this)[0];
       return 0;
     }
-    virtual bool is_superselector_of(Compound_Selector_Obj sub, std::string wrapped = "");
-    virtual bool is_superselector_of(Complex_Selector_Obj sub, std::string wrapped = "");
-    virtual bool is_superselector_of(Selector_List_Obj sub, std::string wrapped = "");
+    virtual bool is_superselector_of(Compound_Selector_Obj sub, const std::string& wrapped = "");
+    virtual bool is_superselector_of(Complex_Selector_Obj sub, const std::string& wrapped = "");
+    virtual bool is_superselector_of(Selector_List_Obj sub, const std::string& wrapped = "");
     virtual size_t hash()
     {
       if (Selector::hash_ == 0) {
@@ -2862,9 +2919,9 @@ namespace Sass {
 
     size_t length() const;
     Selector_List_Ptr resolve_parent_refs(std::vector<Selector_List_Obj>& pstack, Backtraces& traces, bool implicit_parent = true);
-    virtual bool is_superselector_of(Compound_Selector_Obj sub, std::string wrapping = "");
-    virtual bool is_superselector_of(Complex_Selector_Obj sub, std::string wrapping = "");
-    virtual bool is_superselector_of(Selector_List_Obj sub, std::string wrapping = "");
+    virtual bool is_superselector_of(Compound_Selector_Obj sub, const std::string& wrapping = "");
+    virtual bool is_superselector_of(Complex_Selector_Obj sub, const std::string& wrapping = "");
+    virtual bool is_superselector_of(Selector_List_Obj sub, const std::string& wrapping = "");
     Selector_List_Ptr unify_with(Complex_Selector_Ptr rhs);
     Combinator clear_innermost();
     void append(Complex_Selector_Obj, Backtraces& traces);
@@ -2984,9 +3041,9 @@ namespace Sass {
     virtual bool has_real_parent_ref() const;
     void remove_parent_selectors();
     Selector_List_Ptr resolve_parent_refs(std::vector<Selector_List_Obj>& pstack, Backtraces& traces, bool implicit_parent = true);
-    virtual bool is_superselector_of(Compound_Selector_Obj sub, std::string wrapping = "");
-    virtual bool is_superselector_of(Complex_Selector_Obj sub, std::string wrapping = "");
-    virtual bool is_superselector_of(Selector_List_Obj sub, std::string wrapping = "");
+    virtual bool is_superselector_of(Compound_Selector_Obj sub, const std::string& wrapping = "");
+    virtual bool is_superselector_of(Complex_Selector_Obj sub, const std::string& wrapping = "");
+    virtual bool is_superselector_of(Selector_List_Obj sub, const std::string& wrapping = "");
     Selector_List_Ptr unify_with(Selector_List_Ptr);
     void populate_extends(Selector_List_Obj, Subset_Map&);
     Selector_List_Obj eval(Eval& eval);
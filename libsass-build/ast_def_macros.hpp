@@ -77,4 +77,21 @@ public: \
   void name(type name##__) { hash_ = 0; name##_ = name##__; } \
 private:
 
+// simple selectors drop their interned rendering when changed
+#define SELECTOR_PROPERTY(type, name)\
+protected:\
+  type name##_;\
+public:\
+  type name() const        { return name##_; }\
+  type name(type name##__) { symbol_ = 0; return name##_ = name##__; }\
+private:
+
+#define SELECTOR_CONSTREF(type, name) \
+protected: \
+  type name##_; \
+public: \
+  const type& name() const { return name##_; } \
+  void name(type name##__) { symbol_ = 0; name##_ = name##__; } \
+private:
+
 #endif
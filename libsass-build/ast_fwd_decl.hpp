@@ -413,7 +413,7 @@ namespace Sass {
   typedef std::pair<Complex_Selector_Obj, SubSetMapPairs> SubSetMapResult;
   typedef std::vector<SubSetMapResult> SubSetMapResults;
 
-  typedef std::deque<Complex_Selector_Obj> ComplexSelectorDeque;
+  typedef std::vector<Complex_Selector_Obj> ComplexSelectorVector;
   typedef std::set<Simple_Selector_Obj, OrderNodes> SimpleSelectorSet;
   typedef std::set<Complex_Selector_Obj, OrderNodes> ComplexSelectorSet;
   typedef std::set<Compound_Selector_Obj, OrderNodes> CompoundSelectorSet;
@@ -421,9 +421,6 @@ namespace Sass {
 
   typedef std::vector<Sass_Import_Entry>* ImporterStack;
 
-  // only to switch implementations for testing
-  #define environment_map std::map
-
   // ###########################################################################
   // explicit type conversion functions
   // ###########################################################################
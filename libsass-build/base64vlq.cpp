@@ -6,7 +6,12 @@ namespace Sass {
   std::string Base64VLQ::encode(const int number) const
   {
     std::string encoded = "";
+    encode(encoded, number);
+    return encoded;
+  }
 
+  void Base64VLQ::encode(std::string& out, const int number) const
+  {
     int vlq = to_vlq_signed(number);
 
     do {
@@ -15,10 +20,8 @@ namespace Sass {
       if (vlq > 0) {
         digit |= VLQ_CONTINUATION_BIT;
       }
-      encoded += base64_encode(digit);
+      out += base64_encode(digit);
     } while (vlq > 0);
-
-    return encoded;
   }
 
   char Base64VLQ::base64_encode(const int number) const
@@ -10,6 +10,8 @@ namespace Sass {
   public:
 
     std::string encode(const int number) const;
+    // append the encoded number to the given string
+    void encode(std::string& out, const int number) const;
 
   private:
 
@@ -0,0 +1,239 @@
+#include "sass.hpp"
+#include <set>
+
+#include "ast.hpp"
+#include "bind.hpp"
+#include "eval.hpp"
+#include "util.hpp"
+#include "expand.hpp"
+#include "context.hpp"
+#include "prelexer.hpp"
+#include "call_batch.hpp"
+
+namespace Sass {
+
+  Call_Batch::Call_Batch(Eval& eval, Block_Ptr body, const std::vector<std::string>& variables)
+  : eval(eval), ctx(eval.ctx), variables(variables), calls()
+  {
+    bool batched = false;
+    for (Sass_Function_Entry fn : ctx.c_functions) {
+      batched = batched || sass_function_get_batched(fn);
+    }
+    // variable names are normalized by the parser
+    if (batched && is_stable(body)) collect(body);
+  }
+
+  Call_Batch::~Call_Batch()
+  {
+    ctx.function_cache.unqueue(this);
+  }
+
+  // arguments must evaluate the same way before and in the body
+  bool Call_Batch::is_simple(Expression_Ptr ex)
+  {
+    if (!ex) return true;
+    if (Variable_Ptr var = Cast<Variable>(ex)) {
+      for (const std::string& variable : variables) {
+        if (variable == var->name()) return true;
+      }
+      return false;
+    }
+    if (Cast<Number>(ex) || Cast<Color>(ex) || Cast<Boolean>(ex) || Cast<Null>(ex)) return true;
+    if (Cast<String_Constant>(ex)) return true;
+    if (Argument_Ptr arg = Cast<Argument>(ex)) return is_simple(arg->value());
+    if (Unary_Expression_Ptr unary = Cast<Unary_Expression>(ex)) return is_simple(unary->operand());
+    if (Binary_Expression_Ptr binary = Cast<Binary_Expression>(ex)) {
+      return is_simple(binary->left()) && is_simple(binary->right());
+    }
+    if (Arguments_Ptr args = Cast<Arguments>(ex)) {
+      for (Argument_Obj arg : args->elements()) if (!is_simple(arg)) return false;
+      return true;
+    }
+    if (List_Ptr list = Cast<List>(ex)) {
+      for (Expression_Obj item : list->elements()) if (!is_simple(item)) return false;
+      return true;
+    }
+    if (String_Schema_Ptr schema = Cast<String_Schema>(ex)) {
+      for (Expression_Obj item : schema->elements()) if (!is_simple(item)) return false;
+      return true;
+    }
+    if (Map_Ptr map = Cast<Map>(ex)) {
+      for (Expression_Obj key : map->keys()) {
+        if (!is_simple(key) || !is_simple(map->at(key))) return false;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  // the body must not change the loop variables or any function
+  bool Call_Batch::is_stable(Block_Ptr b)
+  {
+    if (!b) return true;
+    for (Statement_Obj stm : b->elements()) {
+      if (Cast<Definition>(stm)) return false;
+      if (Assignment_Ptr assignment = Cast<Assignment>(stm)) {
+        for (const std::string& variable : variables) {
+          if (variable == assignment->variable()) return false;
+        }
+      }
+      if (If_Ptr cond = Cast<If>(stm)) {
+        if (!is_stable(cond->alternative())) return false;
+      }
+      if (Has_Block_Ptr parent = Cast<Has_Block>(stm)) {
+        if (!is_stable(parent->block())) return false;
+      }
+    }
+    return true;
+  }
+
+  // declarations are expanded exactly once per iteration
+  void Call_Batch::collect(Block_Ptr b)
+  {
+    if (!b) return;
+    for (Statement_Obj stm : b->elements()) {
+      if (Declaration_Ptr dec = Cast<Declaration>(stm)) {
+        collect(dec->value());
+        collect(dec->block());
+      }
+      else if (Ruleset_Ptr rule = Cast<Ruleset>(stm)) {
+        collect(rule->block());
+      }
+    }
+  }
+
+  // only descend where every operand is evaluated
+  void Call_Batch::collect(Expression_Ptr ex)
+  {
+    if (!ex) return;
+    if (Function_Call_Ptr c = Cast<Function_Call>(ex)) {
+      if (c->func() || c->via_call() || c->is_css()) return;
+      if (Prelexer::re_special_fun(c->symbol()->c_str())) return;
+      EnvResult rv(eval.environment()->find(c->symbol()));
+      if (!rv.found) return;
+      Definition_Ptr def = Cast<Definition>(*rv.value);
+      if (!def || def->is_overload_stub() || !def->c_function()) return;
+      if (!sass_function_get_batched(def->c_function())) return;
+      if (!is_simple(c->arguments())) return;
+      for (Parameter_Obj param : def->parameters()->elements()) {
+        if (!is_simple(param->default_value())) return;
+      }
+      Call call = { c, def };
+      calls.push_back(call);
+    }
+    else if (Binary_Expression_Ptr binary = Cast<Binary_Expression>(ex)) {
+      if (binary->optype() == AND || binary->optype() == OR) return;
+      collect(binary->left());
+      collect(binary->right());
+    }
+    else if (Unary_Expression_Ptr unary = Cast<Unary_Expression>(ex)) {
+      collect(unary->operand());
+    }
+    else if (List_Ptr list = Cast<List>(ex)) {
+      for (Expression_Obj item : list->elements()) collect(item);
+    }
+    else if (String_Schema_Ptr schema = Cast<String_Schema>(ex)) {
+      for (Expression_Obj item : schema->elements()) collect(item);
+    }
+  }
+
+  // evaluate and bind the arguments as the call would do
+  union Sass_Value* Call_Batch::arguments(const Call& call)
+  {
+    Expand& exp = eval.exp;
+    size_t traces = eval.traces.size();
+    size_t envs = exp.env_stack.size();
+    size_t callees = ctx.callee_stack.size();
+    try {
+      Arguments_Obj args = call.call->arguments();
+      args->set_delayed(false);
+      args = Cast<Arguments>(args->perform(&eval));
+      Parameters_Obj params = call.def->parameters();
+      Env fn_env(call.def->environment());
+      exp.env_stack.push_back(&fn_env);
+      bind(std::string("Function"), call.call->name(), params, args, &ctx, &fn_env, &eval);
+      union Sass_Value* c_args = eval.c_arguments(params, fn_env);
+      exp.env_stack.pop_back();
+      return c_args;
+    }
+    // reported once the call is evaluated
+    catch (...) {
+      eval.traces.resize(traces, Backtrace(call.call->pstate()));
+      exp.env_stack.resize(envs);
+      ctx.callee_stack.resize(callees);
+      return 0;
+    }
+  }
+
+  void Call_Batch::prefetch(Env& env, const std::vector<std::vector<Expression_Obj>>& iterations)
+  {
+    if (calls.empty()) return;
+    std::vector<Sass_Function_Entry> fns;
+    std::vector<std::vector<union Sass_Value*>> args;
+    std::vector<std::vector<std::string>> keys;
+    std::set<std::string> seen;
+    for (const std::vector<Expression_Obj>& values : iterations) {
+      for (size_t i = 0, L = variables.size(); i < L && i < values.size(); ++i) {
+        env.set_local(variables[i], values[i]);
+      }
+      for (const Call& call : calls) {
+        union Sass_Value* c_args = arguments(call);
+        if (!c_args) continue;
+        Sass_Function_Entry fn = call.def->c_function();
+        std::string key(Function_Cache::key(fn, c_args));
+        // pure results are shared anyway
+        if (sass_function_get_pure(fn)) {
+          if (ctx.function_cache.find(key) || !seen.insert(key).second) {
+            sass_delete_value(c_args);
+            continue;
+          }
+        }
+        size_t i = 0;
+        while (i < fns.size() && fns[i] != fn) ++ i;
+        if (i == fns.size()) {
+          fns.push_back(fn);
+          args.push_back(std::vector<union Sass_Value*>());
+          keys.push_back(std::vector<std::string>());
+        }
+        args[i].push_back(c_args);
+        keys[i].push_back(key);
+      }
+    }
+    for (size_t i = 0; i < fns.size(); ++i) {
+      std::vector<union Sass_Value*> results(invoke(fns[i], args[i], ctx.c_compiler));
+      for (size_t j = 0; j < results.size(); ++j) {
+        ctx.function_cache.queue(keys[i][j], results[j], this);
+        sass_delete_value(args[i][j]);
+      }
+    }
+  }
+
+  std::vector<union Sass_Value*> Call_Batch::invoke(Sass_Function_Entry fn, const std::vector<union Sass_Value*>& args, struct Sass_Compiler* compiler)
+  {
+    size_t L = args.size();
+    union Sass_Value* batch = sass_make_list(L, SASS_COMMA, false);
+    for (size_t i = 0; i < L; ++i) {
+      sass_list_set_value(batch, i, sass_clone_value(args[i]));
+    }
+    union Sass_Value* c_val = sass_function_get_function(fn)(batch, fn, compiler);
+    std::vector<union Sass_Value*> results;
+    if (sass_value_is_list(c_val) && sass_list_get_length(c_val) == L) {
+      for (size_t i = 0; i < L; ++i) {
+        results.push_back(sass_clone_value(sass_list_get_value(c_val, i)));
+      }
+    }
+    // every call reports the error
+    else if (sass_value_is_error(c_val) || sass_value_is_warning(c_val)) {
+      for (size_t i = 0; i < L; ++i) results.push_back(sass_clone_value(c_val));
+    }
+    else {
+      for (size_t i = 0; i < L; ++i) {
+        results.push_back(sass_make_error("batched function must return one result per call"));
+      }
+    }
+    if (c_val != batch) sass_delete_value(c_val);
+    sass_delete_value(batch);
+    return results;
+  }
+
+}
@@ -0,0 +1,59 @@
+#ifndef SASS_CALL_BATCH_H
+#define SASS_CALL_BATCH_H
+
+#include <string>
+#include <vector>
+
+#include "ast_fwd_decl.hpp"
+#include "environment.hpp"
+#include "sass/values.h"
+#include "sass/functions.h"
+
+namespace Sass {
+
+  class Eval;
+  class Context;
+
+  // Prefetches the results of batched c functions called in a loop
+  // body. Before the body is expanded, the arguments of every call are
+  // evaluated for all iterations and each function is invoked once
+  // with all of them. The results are queued in the function cache
+  // and picked up when the calls are evaluated for real.
+  // Only calls in declarations are considered and only if their
+  // arguments depend on nothing but the loop variables. Anything we
+  // can't prefetch is simply called when it is reached.
+  class Call_Batch {
+  private:
+    struct Call {
+      Function_Call_Obj call;
+      Definition_Obj def;
+    };
+    Eval& eval;
+    Context& ctx;
+    std::vector<std::string> variables;
+    std::vector<Call> calls;
+    bool is_simple(Expression_Ptr ex);
+    bool is_stable(Block_Ptr b);
+    void collect(Block_Ptr b);
+    void collect(Expression_Ptr ex);
+    union Sass_Value* arguments(const Call& call);
+
+  public:
+    Call_Batch(Eval& eval, Block_Ptr body, const std::vector<std::string>& variables);
+    ~Call_Batch();
+
+    // nothing to prefetch, the loop can run as usual
+    bool empty() const { return calls.empty(); }
+
+    // queue results for the given values of the loop variables
+    void prefetch(Env& env, const std::vector<std::vector<Expression_Obj>>& iterations);
+
+    // call the function with a list of argument lists at once
+    // returns one result per argument list (owned by the caller)
+    static std::vector<union Sass_Value*> invoke(Sass_Function_Entry fn, const std::vector<union Sass_Value*>& args, struct Sass_Compiler* compiler);
+
+  };
+
+}
+
+#endif
@@ -1,4 +1,6 @@
 #include "sass.hpp"
+#include <mutex>
+#include <unordered_set>
 #include "ast.hpp"
 #include "color_maps.hpp"
 
@@ -645,4 +647,13 @@ namespace Sass {
     return color_to_name(key);
   }
 
+  const std::string* intern_color_name(const std::string& name)
+  {
+    // few distinct spellings, never removed
+    static std::mutex mutex;
+    static std::unordered_set<std::string> names;
+    std::lock_guard<std::mutex> lock(mutex);
+    return &*names.insert(name).first;
+  }
+
 }
@@ -325,6 +325,8 @@ namespace Sass {
   const char* color_to_name(const int);
   const char* color_to_name(const Color&);
   const char* color_to_name(const double);
+  // display names as written, interned process wide
+  const std::string* intern_color_name(const std::string&);
 
 }
 
@@ -23,6 +23,7 @@
 #include "listize.hpp"
 #include "extend.hpp"
 #include "remove_placeholders.hpp"
+#include "slot_resolver.hpp"
 #include "functions.hpp"
 #include "sass_functions.hpp"
 #include "backtrace.hpp"
@@ -60,7 +61,8 @@ namespace Sass {
   }
 
   Context::Context(struct Sass_Context& c_ctx)
-  : CWD(File::get_cwd()),
+  : sheet_lease(c_ctx.sheet_cache ? &c_ctx.sheet_cache->cpp_cache : 0, this),
+    CWD(File::get_cwd()),
     c_options(c_ctx),
     entry_path(""),
     head_imports(0),
@@ -75,6 +77,12 @@ namespace Sass {
     import_stack(),
     callee_stack(),
     traces(),
+    sheet_cache(sheet_lease.cache),
+    cached_buffers(),
+    parsing_sheets(),
+    prefetch(0),
+    function_cache(),
+    parse_cache(),
     c_compiler(NULL),
 
     c_headers               (std::vector<Sass_Importer_Entry>()),
@@ -112,6 +120,8 @@ namespace Sass {
     sort (c_importers.begin(), c_importers.end(), sort_importers);
 
     emitter.set_filename(abs2rel(output_path, source_map_file, CWD));
+    // mappings are only rendered into a source map
+    emitter.source_mapping = source_map_file != "" || c_options.source_map_embed;
 
   }
 
@@ -136,6 +146,8 @@ namespace Sass {
   {
     // resources were allocated by malloc
     for (size_t i = 0; i < resources.size(); ++i) {
+      // unless the sheet cache owns them
+      if (cached_buffers.count(resources[i].contents)) continue;
       free(resources[i].contents);
       free(resources[i].srcmap);
     }
@@ -238,6 +250,10 @@ namespace Sass {
   {
     // make sure we resolve against an absolute path
     std::string base_path(rel2abs(import.base_path));
+    // the same imports are usually resolved many times
+    std::string key(base_path + '\n' + import.imp_path);
+    auto cached = resolved_includes.find(key);
+    if (cached != resolved_includes.end()) return cached->second;
     // first try to resolve the load path relative to the base path
     std::vector<Include> vec(resolve_includes(base_path, import.imp_path));
     // then search in every include path (but only if nothing found yet)
@@ -247,13 +263,15 @@ namespace Sass {
       std::vector<Include> resolved(resolve_includes(include_paths[i], import.imp_path));
       if (resolved.size()) vec.insert(vec.end(), resolved.begin(), resolved.end());
     }
+    // also remember negative results
+    resolved_includes.insert(std::make_pair(key, vec));
     // return vector
     return vec;
   }
 
   // register include with resolved path and its content
   // memory of the resources will be freed by us on exit
-  void Context::register_resource(const Include& inc, const Resource& res)
+  void Context::register_resource(const Include& inc, const Resource& res, Sheet_Cache::Entry* entry, Import_Prefetch::Sheet* sheet)
   {
 
     // do not parse same resource twice
@@ -293,9 +311,23 @@ namespace Sass {
     const char* contents = resources[idx].contents;
     // keep a copy of the path around (for parserstates)
     // ToDo: we clean it, but still not very elegant!?
-    strings.push_back(sass_copy_c_string(inc.abs_path.c_str()));
+    if (!entry && !sheet) strings.push_back(sass_copy_c_string(inc.abs_path.c_str()));
+    // cached sheets may outlive us, so they use their own path
+    // and a unique source id (translated for the source map)
+    else if (entry) emitter.add_source_id(entry->file_id, idx);
+    // prefetched sheets were parsed with their own path and id
+    // the buffers are now owned by us (like any other resource)
+    else {
+      strings.push_back(sheet->path);
+      sheet->path = 0; sheet->contents = 0;
+      emitter.add_source_id(sheet->file_id, idx);
+    }
     // create the initial parser state from resource
-    ParserState pstate(strings.back(), contents, idx);
+    ParserState pstate(entry ? entry->path : strings.back(), contents,
+      entry ? entry->file_id : sheet ? sheet->file_id : idx);
+
+    // give the unused entry back on errors
+    try {
 
     // check existing import stack for possible recursion
     for (size_t i = 0; i < import_stack.size() - 2; ++i) {
@@ -315,13 +347,26 @@ namespace Sass {
       }
     }
 
-    // create a parser instance from the given c_str buffer
-    Parser p(Parser::from_c_str(contents, *this, traces, pstate));
     // do not yet dispose these buffers
     sass_import_take_source(import);
     sass_import_take_srcmap(import);
+    // collect imports of the cached sheet
+    if (entry) parsing_sheets.push_back(entry);
+    Block_Obj root;
+    // the sheet was already parsed, but its imports
+    // are loaded now, just where the parser would have
+    if (sheet) {
+      root = sheet->root;
+      for (const Deferred_Import& imp : sheet->imports) {
+        load_deferred_import(imp, pstate.path);
+      }
+      delete sheet; sheet = 0;
+    }
     // then parse the root block
-    Block_Obj root = p.parse();
+    else root = Parser::from_c_str(contents, *this, traces, pstate).parse();
+    // resolve variables of mixins and functions
+    Slot_Resolver()(root);
+    if (entry) parsing_sheets.pop_back();
     // delete memory of current stack frame
     sass_delete_import(import_stack.back());
     // remove current stack frame
@@ -331,17 +376,172 @@ namespace Sass {
       ast_pair(inc.abs_path, { res, root });
     // register resulting resource
     sheets.insert(ast_pair);
+
+    // keep the sheet for later compilations
+    if (entry && entry->restorable) {
+      entry->root = root;
+      cached_buffers.insert(contents);
+      sheet_cache->store(entry, this);
+    }
+    // parser states still point to the path
+    else if (entry) strings.push_back(sheet_cache->discard(entry));
+
+    }
+    catch (...) {
+      delete sheet;
+      if (entry) {
+        if (!parsing_sheets.empty() && parsing_sheets.back() == entry) parsing_sheets.pop_back();
+        strings.push_back(sheet_cache->discard(entry));
+      }
+      throw;
+    }
   }
 
   // register include with resolved path and its content
   // memory of the resources will be freed by us on exit
-  void Context::register_resource(const Include& inc, const Resource& res, ParserState& prstate)
+  void Context::register_resource(const Include& inc, const Resource& res, ParserState& prstate, Sheet_Cache::Entry* entry, Import_Prefetch::Sheet* sheet)
   {
     traces.push_back(Backtrace(prstate));
-    register_resource(inc, res);
+    register_resource(inc, res, entry, sheet);
     traces.pop_back();
   }
 
+  // cached sheets are only valid for the same include paths
+  std::string Context::sheet_cache_key(const std::string& abs_path)
+  {
+    std::string key(abs_path);
+    for (size_t i = 0, S = include_paths.size(); i < S; ++i)
+    { key += '\n'; key += include_paths[i]; }
+    return key;
+  }
+
+  // remember imports of all cached sheets being parsed
+  // they need to be restored together with the sheet
+  void Context::track_import(const Include& inc)
+  {
+    for (Sheet_Cache::Entry* entry : parsing_sheets) {
+      entry->imports.push_back(inc);
+    }
+  }
+
+  // remember what the custom importers answered while
+  // parsing cached sheets, they are asked again on reuse
+  void Context::track_request(const std::string& load_path, Sass_Import_List includes)
+  {
+    if (parsing_sheets.empty()) return;
+    Sheet_Cache::Request request(load_path, import_stack.back(), includes);
+    for (Sheet_Cache::Entry* entry : parsing_sheets) {
+      entry->requests.push_back(request);
+    }
+  }
+
+  // ask the custom importers about all the imports of a cached
+  // sheet again, it is only valid if they still pass them on
+  // the same way (to the same files)
+  bool Context::same_answers(const Sheet_Cache::Entry* entry)
+  {
+    for (const Sheet_Cache::Request& request : entry->requests) {
+      // importers may query the importing sheet
+      Sass_Import_Entry prev = sass_make_import(
+        request.prev_imp_path.c_str(), request.prev_abs_path.c_str(), 0, 0);
+      import_stack.push_back(prev);
+      Sass_Import_List includes = 0;
+      for (Sass_Importer_Entry& importer_ent : c_importers) {
+        Sass_Importer_Fn fn = sass_importer_get_function(importer_ent);
+        includes = fn(request.load_path.c_str(), importer_ent, c_compiler);
+        if (includes) break;
+      }
+      import_stack.pop_back();
+      Sheet_Cache::Request answer(request.load_path, prev, includes);
+      if (includes) sass_delete_import_list(includes);
+      sass_delete_import(prev);
+      if (!(answer == request)) return false;
+    }
+    return true;
+  }
+
+  // load an import of a prefetched sheet and replace its
+  // placeholder node (see `Parser::parse_block_node`)
+  void Context::load_deferred_import(const Deferred_Import& def, const char* ctx_path)
+  {
+    Import_Ptr imp = def.imp;
+    ParserState pstate(def.pstate);
+    import_locations(imp, def.locations, ctx_path, pstate);
+    std::vector<Statement_Obj> nodes;
+    // if it is a url, we only add the statement
+    if (!imp->urls().empty()) nodes.push_back(imp);
+    // process all resources now (add Import_Stub nodes)
+    for (size_t i = 0, S = imp->incs().size(); i < S; ++i) {
+      nodes.push_back(SASS_MEMORY_NEW(Import_Stub, pstate, imp->incs()[i]));
+    }
+    std::vector<Statement_Obj>& elements(def.block->elements());
+    for (auto it = elements.begin(); it != elements.end(); ++it) {
+      if (it->ptr() != imp) continue;
+      elements.insert(elements.erase(it), nodes.begin(), nodes.end());
+      break;
+    }
+  }
+
+  // read and register the resolved file resource
+  bool Context::load_sheet(const Include& inc, ParserState& pstate)
+  {
+    // the sheet may have been parsed ahead of time
+    if (Import_Prefetch::Sheet* sheet = prefetch ? prefetch->take(inc.abs_path) : 0) {
+      register_resource(inc, { sheet->contents, 0 }, pstate, 0, sheet);
+      return true;
+    }
+    // must be created before reading the file
+    Sheet_Cache::Entry* entry = sheet_cache ?
+      sheet_cache->prepare(sheet_cache_key(inc.abs_path), inc.abs_path) : 0;
+    // try to read the content of the resolved file entry
+    // the memory buffer returned must be freed by us!
+    char* contents = read_file(inc.abs_path);
+    if (contents == 0) {
+      if (entry) free(sheet_cache->discard(entry));
+      return false;
+    }
+    if (entry) entry->load(contents);
+    // register the newly resolved file resource
+    register_resource(inc, { contents, 0 }, pstate, entry);
+    return true;
+  }
+
+  // reuse a sheet parsed by an earlier compilation
+  // all the sheets it imported are loaded as well
+  // (their imports were checked with the outer sheet)
+  bool Context::load_cached_sheet(const Include& inc, ParserState& pstate, bool checked)
+  {
+    Sheet_Cache::Entry* entry = sheet_cache->acquire(
+      sheet_cache_key(inc.abs_path), inc.abs_path, this);
+    if (entry == 0) return false;
+    // custom importers may resolve the imports differently now
+    // parse it again (the new entry replaces the one we hold)
+    if (!checked && !same_answers(entry)) {
+      sheet_cache->reject();
+      return false;
+    }
+    // register the cached resource like a parsed one
+    size_t idx = resources.size();
+    emitter.add_source_index(idx);
+    resources.push_back({ entry->contents, 0 });
+    cached_buffers.insert(entry->contents);
+    included_files.push_back(inc.abs_path);
+    srcmap_links.push_back(abs2rel(inc.abs_path, source_map_file, CWD));
+    emitter.add_source_id(entry->file_id, idx);
+    sheets.insert(std::make_pair(inc.abs_path, StyleSheet({ entry->contents, 0 }, entry->root)));
+    // imports are resolved the same way as before
+    std::vector<Include> imports(entry->imports);
+    for (const Include& import : imports) {
+      track_import(import);
+      if (sheets.count(import.abs_path)) continue;
+      if (load_cached_sheet(import, pstate, true)) continue;
+      if (!load_sheet(import, pstate)) {
+        error("File to import not found or unreadable: " + import.imp_path + ".", pstate, traces);
+      }
+    }
+    return true;
+  }
+
   // Add a new import to the context (called from `import_url`)
   Include Context::load_import(const Importer& imp, ParserState pstate)
   {
@@ -364,17 +564,17 @@ namespace Sass {
 
     // process the resolved entry
     else if (resolved.size() == 1) {
-      bool use_cache = c_importers.size() == 0;
+      // cached sheets must know about all their imports
+      track_import(resolved[0]);
       // use cache for the resource loading
-      if (use_cache && sheets.count(resolved[0].abs_path)) return resolved[0];
-      // try to read the content of the resolved file entry
-      // the memory buffer returned must be freed by us!
-      if (char* contents = read_file(resolved[0].abs_path)) {
-        // register the newly resolved file resource
-        register_resource(resolved[0], { contents, 0 }, pstate);
-        // return resolved entry
-        return resolved[0];
-      }
+      // custom importers are always asked first and we only
+      // get here if they passed the import to the file system
+      // so the file on disk is what they want us to load
+      if (sheets.count(resolved[0].abs_path)) return resolved[0];
+      // reuse the sheet parsed by an earlier compilation
+      if (sheet_cache && load_cached_sheet(resolved[0], pstate)) return resolved[0];
+      // try to load and parse the resolved file entry
+      if (load_sheet(resolved[0], pstate)) return resolved[0];
     }
 
     // nothing found
@@ -382,6 +582,21 @@ namespace Sass {
 
   }
 
+  // load all locations of an import statement
+  void Context::import_locations(Import_Ptr imp, const std::vector<std::pair<std::string, Function_Call_Obj>>& locations, const char* ctx_path, ParserState& pstate)
+  {
+    for (auto location : locations) {
+      if (location.second) {
+        imp->urls().push_back(location.second);
+      }
+      // check if custom importers want to take over the handling
+      else if (!call_importers(unquote(location.first), ctx_path, pstate, imp)) {
+        // nobody wants it, so we do our import
+        import_url(imp, location.first, ctx_path);
+      }
+    }
+  }
+
   void Context::import_url (Import_Ptr imp, std::string load_path, const std::string& ctx_path) {
 
     ParserState pstate(imp->pstate());
@@ -435,6 +650,8 @@ namespace Sass {
       if (Sass_Import_List includes =
           fn(load_path.c_str(), importer_ent, c_compiler)
       ) {
+        // cached sheets must know how their imports were resolved
+        if (only_one) track_request(load_path, includes);
         // get c pointer copy to iterate over
         Sass_Import_List it_includes = includes;
         while (*it_includes) { ++count;
@@ -456,6 +673,10 @@ namespace Sass {
           const char *abs_path = sass_import_get_abs_path(include_ent);
           // handle error message passed back from custom importer
           // it may (or may not) override the line and column info
+          // we can't restore sheets that depend on these imports
+          if (source || srcmap) {
+            for (Sheet_Cache::Entry* entry : parsing_sheets) entry->restorable = false;
+          }
           if (const char* err_message = sass_import_get_error_message(include_ent)) {
             if (source || srcmap) register_resource({ importer, uniq_path }, { source, srcmap }, pstate);
             if (line == std::string::npos && column == std::string::npos) error(err_message, pstate, traces);
@@ -496,6 +717,8 @@ namespace Sass {
         if (only_one) break;
       }
     }
+    // nobody wanted it, which is just as important
+    if (only_one && !has_import) track_request(load_path, 0);
     // return result
     return has_import;
   }
@@ -506,33 +729,67 @@ namespace Sass {
   void register_built_in_functions(Context&, Env* env);
   void register_c_functions(Context&, Env* env, Sass_Function_List);
   void register_c_function(Context&, Env* env, Sass_Function_Entry);
+  Env* built_in_env(Context&);
+
+  // passes the rendered chunks to the c callback
+  class C_Output_Sink : public Output_Sink {
+    public:
+      Sass_Output_Sink_Fn fn;
+      void* cookie;
+      C_Output_Sink(Sass_Output_Sink_Fn fn, void* cookie)
+      : fn(fn), cookie(cookie)
+      { }
+      void write(const char* chunk, size_t length)
+      {
+        if (!fn(chunk, length, cookie)) {
+          throw std::runtime_error("output sink failed to write");
+        }
+      }
+  };
 
   char* Context::render(Block_Obj root)
   {
     // check for valid block
     if (!root) return 0;
+    // hand the output over in chunks
+    if (c_options.output_sink) {
+      C_Output_Sink sink(c_options.output_sink, c_options.output_sink_cookie);
+      emitter.stream(root, &sink);
+      emitter.flush_buffer(true);
+      std::string url(render_source_map_url());
+      if (!url.empty()) sink.write(url.data(), url.size());
+      // everything went to the sink
+      return sass_copy_c_string("");
+    }
     // start the render process
     root->perform(&emitter);
     // finish emitter stream
     emitter.finalize();
     // get the resulting buffer from stream
-    OutputBuffer emitted = emitter.get_buffer();
+    const OutputBuffer& emitted = emitter.get_buffer();
     // should we append a source map url?
-    if (!c_options.omit_source_map_url) {
-      // generate an embeded source map
-      if (c_options.source_map_embed) {
-        emitted.buffer += linefeed;
-        emitted.buffer += format_embedded_source_map();
-      }
-      // or just link the generated one
-      else if (source_map_file != "") {
-        emitted.buffer += linefeed;
-        emitted.buffer += format_source_mapping_url(source_map_file);
-      }
-    }
+    std::string url(render_source_map_url());
     // create a copy of the resulting buffer string
     // this must be freed or taken over by implementor
-    return sass_copy_c_string(emitted.buffer.c_str());
+    char* output = (char*) sass_alloc_memory(emitted.buffer.size() + url.size() + 1);
+    std::memcpy(output, emitted.buffer.data(), emitted.buffer.size());
+    std::memcpy(output + emitted.buffer.size(), url.c_str(), url.size() + 1);
+    return output;
+  }
+
+  // linefeed and source map comment to end the output
+  std::string Context::render_source_map_url()
+  {
+    if (c_options.omit_source_map_url) return "";
+    // generate an embeded source map
+    if (c_options.source_map_embed) {
+      return linefeed + format_embedded_source_map();
+    }
+    // or just link the generated one
+    if (source_map_file != "") {
+      return linefeed + format_source_mapping_url(source_map_file);
+    }
+    return "";
   }
 
   void Context::apply_custom_headers(Block_Obj root, const char* ctx_path, ParserState pstate)
@@ -590,8 +847,12 @@ namespace Sass {
     // add the entry to the stack
     import_stack.push_back(import);
 
-    // create the source entry for file entry
-    register_resource({{ input_path, "." }, abs_path }, { contents, 0 });
+    {
+      // parse the imports of the entry ahead of time
+      Import_Prefetch prefetch(*this, contents, abs_path);
+      // create the source entry for file entry
+      register_resource({{ input_path, "." }, abs_path }, { contents, 0 });
+    }
 
     // create root ast tree node
     return compile();
@@ -632,8 +893,12 @@ namespace Sass {
     // add the entry to the stack
     import_stack.push_back(import);
 
-    // register a synthetic resource (path does not really exist, skip in includes)
-    register_resource({{ input_path, "." }, input_path }, { source_c_str, srcmap_c_str });
+    {
+      // parse the imports of the entry ahead of time
+      Import_Prefetch prefetch(*this, source_c_str, input_path);
+      // register a synthetic resource (path does not really exist, skip in includes)
+      register_resource({{ input_path, "." }, input_path }, { source_c_str, srcmap_c_str });
+    }
 
     // create root ast tree node
     return compile();
@@ -650,9 +915,9 @@ namespace Sass {
     Block_Obj root = sheets.at(entry_path).root;
     // abort on invalid root
     if (root.isNull()) return 0;
-    Env global; // create root environment
-    // register built-in functions on env
-    register_built_in_functions(*this, &global);
+    // create root environment on top of the
+    // (already registered) built-in functions
+    Env global(built_in_env(*this));
     // register custom functions (defined via C-API)
     for (size_t i = 0, S = c_functions.size(); i < S; ++i)
     { register_c_function(*this, &global, c_functions[i]); }
@@ -677,6 +942,10 @@ namespace Sass {
       // create crtp visitor object
       Extend extend(subset_map);
       extend.setEval(expand.eval);
+      // cached results have no source positions
+      if (sheet_cache && !emitter.source_mapping) {
+        extend.setCache(sheet_cache->extend_cache);
+      }
       // extend tree nodes
       extend(root);
     }
@@ -692,14 +961,17 @@ namespace Sass {
 
   std::string Context::format_embedded_source_map()
   {
-    std::string map = emitter.render_srcmap(*this);
-    std::istringstream is( map );
-    std::ostringstream buffer;
+    const std::string& map = source_map_json();
+    std::string url("/*# sourceMappingURL=data:application/json;base64,");
+    size_t prefix = url.size();
+    // four chars per three bytes and a linefeed
+    url.resize(prefix + (map.size() + 2) / 3 * 4 + 1);
     base64::encoder E;
-    E.encode(is, buffer);
-    std::string url = "data:application/json;base64," + buffer.str();
-    url.erase(url.size() - 1);
-    return "/*# sourceMappingURL=" + url + " */";
+    int size = E.encode(map.data(), static_cast<int>(map.size()), &url[prefix]);
+    size += E.encode_end(&url[prefix + size]);
+    // drop the linefeed of the encoder
+    url.resize(prefix + size - 1);
+    return url + " */";
   }
 
   std::string Context::format_source_mapping_url(const std::string& file)
@@ -711,8 +983,24 @@ namespace Sass {
   char* Context::render_srcmap()
   {
     if (source_map_file == "") return 0;
-    std::string map = emitter.render_srcmap(*this);
-    return sass_copy_c_string(map.c_str());
+    return sass_copy_c_string(source_map_json().c_str());
+  }
+
+  // rendered once for the embedded url and the map file
+  const std::string& Context::source_map_json()
+  {
+    if (srcmap_json.empty()) srcmap_json = emitter.render_srcmap(*this);
+    return srcmap_json;
+  }
+
+  SourceMap* Context::take_source_map()
+  {
+    if (!emitter.source_mapping) return 0;
+    SourceMap* smap = new SourceMap(emitter.take_smap());
+    for (size_t idx : smap->source_index) {
+      smap->sources.push_back(srcmap_links[idx]);
+    }
+    return smap;
   }
 
 
@@ -734,16 +1022,16 @@ namespace Sass {
   {
     Definition_Ptr def = make_native_function(sig, f, ctx);
     def->environment(env);
-    (*env)[def->name() + "[f]"] = def;
+    env->local_frame()[function_symbol(def->name())] = def;
   }
 
   void register_function(Context& ctx, Signature sig, Native_Function f, size_t arity, Env* env)
   {
     Definition_Ptr def = make_native_function(sig, f, ctx);
     std::stringstream ss;
-    ss << def->name() << "[f]" << arity;
+    ss << def->name() << "/" << arity;
     def->environment(env);
-    (*env)[ss.str()] = def;
+    env->local_frame()[function_symbol(ss.str())] = def;
   }
 
   void register_overload_stub(Context& ctx, std::string name, Env* env)
@@ -755,10 +1043,24 @@ namespace Sass {
                                        0,
                                        0,
                                        true);
-    (*env)[name + "[f]"] = stub;
+    env->local_frame()[function_symbol(name)] = stub;
   }
 
 
+  // built-in functions never change after registration, so their
+  // signatures are only parsed once and every global env links to
+  // the resulting frame; ref-counts are not atomic, therefore each
+  // thread gets its own copy instead of one shared by the process
+  Env* built_in_env(Context& ctx)
+  {
+    static thread_local Env env;
+    if (!env.is_builtin()) {
+      register_built_in_functions(ctx, &env);
+      env.is_builtin(true);
+    }
+    return &env;
+  }
+
   void register_built_in_functions(Context& ctx, Env* env)
   {
     using namespace Functions;
@@ -874,7 +1176,7 @@ namespace Sass {
   {
     Definition_Ptr def = make_c_function(descr, ctx);
     def->environment(env);
-    (*env)[def->name() + "[f]"] = def;
+    env->local_frame()[function_symbol(def->name())] = def;
   }
 
 }
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 
 #define BUFFERSIZE 255
 #include "b64/encode.h"
@@ -19,6 +20,10 @@
 #include "output.hpp"
 #include "plugins.hpp"
 #include "file.hpp"
+#include "sheet_cache.hpp"
+#include "import_prefetch.hpp"
+#include "function_cache.hpp"
+#include "parse_cache.hpp"
 
 
 struct Sass_Function;
@@ -28,6 +33,7 @@ namespace Sass {
   class Context {
   public:
     void import_url (Import_Ptr imp, std::string load_path, const std::string& ctx_path);
+    void import_locations(Import_Ptr imp, const std::vector<std::pair<std::string, Function_Call_Obj>>& locations, const char* ctx_path, ParserState& pstate);
     bool call_headers(const std::string& load_path, const char* ctx_path, ParserState& pstate, Import_Ptr imp)
     { return call_loader(load_path, ctx_path, pstate, imp, c_headers, false); };
     bool call_importers(const std::string& load_path, const char* ctx_path, ParserState& pstate, Import_Ptr imp)
@@ -36,6 +42,10 @@ namespace Sass {
   private:
     bool call_loader(const std::string& load_path, const char* ctx_path, ParserState& pstate, Import_Ptr imp, std::vector<Sass_Importer_Entry> importers, bool only_one = true);
 
+    // must be the first member, since we may only give sheets
+    // back to the cache once all our ast nodes are destroyed
+    Sheet_Lease sheet_lease;
+
   public:
     const std::string CWD;
     struct Sass_Options& c_options;
@@ -52,11 +62,27 @@ namespace Sass {
     std::vector<char*> strings;
     std::vector<Resource> resources;
     std::map<const std::string, StyleSheet> sheets;
+    // results of find_includes (may be empty) keyed by
+    // base path and import path (include paths are fixed)
+    std::map<const std::string, std::vector<Include>> resolved_includes;
     Subset_Map subset_map;
     std::vector<Sass_Import_Entry> import_stack;
     std::vector<Sass_Callee> callee_stack;
     std::vector<Backtrace> traces;
 
+    // parsed sheets shared between compilations
+    Sheet_Cache* sheet_cache;
+    // buffers of resources owned by the cache
+    std::set<const char*> cached_buffers;
+    // cache entries currently being parsed
+    std::vector<Sheet_Cache::Entry*> parsing_sheets;
+    // sheets parsed ahead of time (while parsing the entry)
+    Import_Prefetch* prefetch;
+    // results of pure c functions
+    Function_Cache function_cache;
+    // selectors parsed from interpolated text
+    Parse_Cache parse_cache;
+
     struct Sass_Compiler* c_compiler;
 
     // absolute paths to includes
@@ -64,6 +90,8 @@ namespace Sass {
     // relative includes for sourcemap
     std::vector<std::string> srcmap_links;
     // vectors above have same size
+    // rendered source map (see `source_map_json`)
+    std::string srcmap_json;
 
     std::vector<std::string> plugin_paths; // relative paths to load plugins
     std::vector<std::string> include_paths; // lookup paths for includes
@@ -95,9 +123,11 @@ namespace Sass {
     virtual Block_Obj compile();
     virtual char* render(Block_Obj root);
     virtual char* render_srcmap();
+    // hand the mappings over to outlive the context
+    SourceMap* take_source_map();
 
-    void register_resource(const Include&, const Resource&);
-    void register_resource(const Include&, const Resource&, ParserState&);
+    void register_resource(const Include&, const Resource&, Sheet_Cache::Entry* = 0, Import_Prefetch::Sheet* = 0);
+    void register_resource(const Include&, const Resource&, ParserState&, Sheet_Cache::Entry* = 0, Import_Prefetch::Sheet* = 0);
     std::vector<Include> find_includes(const Importer& import);
     Include load_import(const Importer&, ParserState pstate);
 
@@ -110,7 +140,17 @@ namespace Sass {
     void collect_include_paths(const char* paths_str);
     void collect_include_paths(string_list* paths_array);
     std::string format_embedded_source_map();
+    const std::string& source_map_json();
+
+    bool load_sheet(const Include&, ParserState&);
+    bool load_cached_sheet(const Include&, ParserState&, bool checked = false);
+    bool same_answers(const Sheet_Cache::Entry* entry);
+    std::string sheet_cache_key(const std::string& abs_path);
+    void track_import(const Include&);
+    void track_request(const std::string& load_path, Sass_Import_List includes);
+    void load_deferred_import(const Deferred_Import&, const char* ctx_path);
     std::string format_source_mapping_url(const std::string& out_path);
+    std::string render_source_map_url();
 
 
     // void register_built_in_functions(Env* env);
@@ -5,10 +5,19 @@
 #include "emitter.hpp"
 #include "utf8_string.hpp"
 
+// size of the chunks passed to the sink
+#define SASS_OUTPUT_CHUNK 65536
+// bytes kept back for look-behinds
+#define SASS_OUTPUT_TAIL 16
+
 namespace Sass {
 
   Emitter::Emitter(struct Sass_Output_Options& opt)
   : wbuf(),
+    flushed(0),
+    mapped(0),
+    sink(0),
+    source_mapping(false),
     opt(opt),
     indentation(0),
     scheduled_space(0),
@@ -41,6 +50,9 @@ namespace Sass {
   void Emitter::add_source_index(size_t idx)
   { wbuf.smap.source_index.push_back(idx); }
 
+  void Emitter::add_source_id(size_t file, size_t idx)
+  { wbuf.smap.source_ids.insert(std::make_pair(file, idx)); }
+
   std::string Emitter::render_srcmap(Context &ctx)
   { return wbuf.smap.render_srcmap(ctx); }
 
@@ -50,9 +62,26 @@ namespace Sass {
   void Emitter::schedule_mapping(const AST_Node_Ptr node)
   { scheduled_mapping = node; }
   void Emitter::add_open_mapping(const AST_Node_Ptr node)
-  { wbuf.smap.add_open_mapping(node); }
+  {
+    if (!source_mapping) return;
+    sync_mappings();
+    wbuf.smap.add_open_mapping(node);
+  }
   void Emitter::add_close_mapping(const AST_Node_Ptr node)
-  { wbuf.smap.add_close_mapping(node); }
+  {
+    if (!source_mapping) return;
+    sync_mappings();
+    wbuf.smap.add_close_mapping(node);
+  }
+
+  // positions are only needed where mappings are added,
+  // scan the text appended since then once to get there
+  void Emitter::sync_mappings(void)
+  {
+    const char* text = wbuf.buffer.data();
+    wbuf.smap.append(text + mapped, text + wbuf.buffer.size());
+    mapped = wbuf.buffer.size();
+  }
   ParserState Emitter::remap(const ParserState& pstate)
   { return wbuf.smap.remap(pstate); }
 
@@ -96,19 +125,27 @@ namespace Sass {
   // prepend some text or token to the buffer
   void Emitter::prepend_output(const OutputBuffer& output)
   {
-    wbuf.smap.prepend(output);
-    wbuf.buffer = output.buffer + wbuf.buffer;
+    if (source_mapping) {
+      sync_mappings();
+      wbuf.smap.prepend(output);
+      mapped += output.buffer.size();
+    }
+    wbuf.buffer.insert(0, output.buffer);
   }
 
   // prepend some text or token to the buffer
   void Emitter::prepend_string(const std::string& text)
   {
-    // do not adjust mappings for utf8 bom
-    // seems they are not counted in any UA
-    if (text.compare("\xEF\xBB\xBF") != 0) {
-      wbuf.smap.prepend(Offset(text));
+    if (source_mapping) {
+      sync_mappings();
+      // do not adjust mappings for utf8 bom
+      // seems they are not counted in any UA
+      if (text.compare("\xEF\xBB\xBF") != 0) {
+        wbuf.smap.prepend(Offset(text));
+      }
+      mapped += text.size();
     }
-    wbuf.buffer = text + wbuf.buffer;
+    wbuf.buffer.insert(0, text);
   }
 
   char Emitter::last_char()
@@ -116,6 +153,24 @@ namespace Sass {
     return wbuf.buffer.back();
   }
 
+  void Emitter::flush_buffer(bool final)
+  {
+    if (!sink) return;
+    size_t size = wbuf.buffer.size();
+    if (!final) {
+      if (size < SASS_OUTPUT_CHUNK) return;
+      size -= SASS_OUTPUT_TAIL;
+    }
+    if (size == 0) return;
+    if (source_mapping) {
+      sync_mappings();
+      mapped -= size;
+    }
+    sink->write(wbuf.buffer.data(), size);
+    wbuf.buffer.erase(0, size);
+    flushed += size;
+  }
+
   // append a single char to the buffer
   void Emitter::append_char(const char chr)
   {
@@ -123,8 +178,8 @@ namespace Sass {
     flush_schedules();
     // add to buffer
     wbuf.buffer += chr;
-    // account for data in source-maps
-    wbuf.smap.append(Offset(chr));
+    // hand over to the sink
+    flush_buffer();
   }
 
   // append some text or token to the buffer
@@ -139,14 +194,12 @@ namespace Sass {
       std::string out = comment_to_string(text);
       // add to buffer
       wbuf.buffer += out;
-      // account for data in source-maps
-      wbuf.smap.append(Offset(out));
     } else {
       // add to buffer
       wbuf.buffer += text;
-      // account for data in source-maps
-      wbuf.smap.append(Offset(text));
     }
+    // hand over to the sink
+    flush_buffer();
   }
 
   // append some white-space only text
@@ -10,6 +10,13 @@
 namespace Sass {
   class Context;
 
+  // receives the rendered output in chunks
+  class Output_Sink {
+    public:
+      virtual ~Output_Sink() { }
+      virtual void write(const char* chunk, size_t length) = 0;
+  };
+
   class Emitter {
 
     public:
@@ -18,12 +25,27 @@ namespace Sass {
 
     protected:
       OutputBuffer wbuf;
+      // bytes passed to the sink
+      size_t flushed;
+      // bytes of the buffer counted by the source map
+      size_t mapped;
+    public:
+      // streams the buffer once it grows too big
+      Output_Sink* sink;
+      // record source mappings (only the rendered
+      // output needs them, not values to_string)
+      bool source_mapping;
     public:
       const std::string& buffer(void) { return wbuf.buffer; }
-      const SourceMap smap(void) { return wbuf.smap; }
-      const OutputBuffer output(void) { return wbuf; }
+      // bytes emitted so far (including flushed ones)
+      size_t output_size(void) { return flushed + wbuf.buffer.size(); }
+      const SourceMap& smap(void) { return wbuf.smap; }
+      // move the source map out (once rendering is done)
+      SourceMap take_smap(void) { return std::move(wbuf.smap); }
+      const OutputBuffer& output(void) { return wbuf; }
       // proxy methods for source maps
       void add_source_index(size_t idx);
+      void add_source_id(size_t file, size_t idx);
       void set_filename(const std::string& str);
       void add_open_mapping(const AST_Node_Ptr node);
       void add_close_mapping(const AST_Node_Ptr node);
@@ -78,6 +100,11 @@ namespace Sass {
       void append_token(const std::string& text, const AST_Node_Ptr node);
       // query last appended character
       char last_char();
+      // count the text appended since the last mapping
+      void sync_mappings(void);
+      // pass the buffer to the sink (keeps a short tail
+      // for look-behinds unless this is the final flush)
+      void flush_buffer(bool final = false);
 
     public: // syntax sugar
       void append_indentation();
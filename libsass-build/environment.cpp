@@ -4,20 +4,99 @@
 
 namespace Sass {
 
+  template <typename T>
+  std::pair<Symbol, T>* Env_Frame<T>::lookup(Symbol key)
+  {
+    if (size_ > index_size) {
+      auto it = index_.find(key);
+      return it == index_.end() ? 0 : &item(it->second);
+    }
+    for (size_t i = 0; i < size_; ++i) {
+      std::pair<Symbol, T>& entry = item(i);
+      if (entry.first == key) return &entry;
+    }
+    return 0;
+  }
+
+  template <typename T>
+  T* Env_Frame<T>::find(Symbol key)
+  {
+    std::pair<Symbol, T>* found = lookup(key);
+    return found && found->second ? &found->second : 0;
+  }
+
+  template <typename T>
+  void Env_Frame<T>::declare(const std::vector<Symbol>& keys)
+  {
+    for (Symbol key : keys) {
+      if (size_ >= inline_size && (size_ - inline_size) % chunk_size == 0) {
+        chunks_.push_back(new std::pair<Symbol, T>[chunk_size]);
+      }
+      item(size_ ++).first = key;
+    }
+    if (size_ > index_size) {
+      for (size_t i = 0; i < size_; ++i) index_[item(i).first] = i;
+    }
+  }
+
+  template <typename T>
+  T& Env_Frame<T>::operator[](Symbol key)
+  {
+    if (std::pair<Symbol, T>* found = lookup(key)) return found->second;
+    // reuse the slot of an erased key
+    for (size_t i = 0; i < size_; ++i) {
+      std::pair<Symbol, T>& entry = item(i);
+      if (entry.first == 0) {
+        entry.first = key;
+        if (size_ > index_size) index_[key] = i;
+        return entry.second;
+      }
+    }
+    if (size_ >= inline_size && (size_ - inline_size) % chunk_size == 0) {
+      chunks_.push_back(new std::pair<Symbol, T>[chunk_size]);
+    }
+    std::pair<Symbol, T>& entry = item(size_);
+    entry.first = key;
+    if (++ size_ > index_size) {
+      // index all items once the frame gets big
+      if (index_.empty()) {
+        for (size_t i = 0; i < size_; ++i) {
+          if (item(i).first) index_[item(i).first] = i;
+        }
+      }
+      else index_[key] = size_ - 1;
+    }
+    return entry.second;
+  }
+
+  template <typename T>
+  void Env_Frame<T>::erase(Symbol key)
+  {
+    for (size_t i = 0; i < size_; ++i) {
+      std::pair<Symbol, T>& entry = item(i);
+      if (entry.first == key) {
+        entry.first = 0;
+        entry.second = T();
+        if (size_ > index_size) index_.erase(key);
+        return;
+      }
+    }
+  }
+
   template <typename T>
   Environment<T>::Environment(bool is_shadow)
-  : local_frame_(environment_map<std::string, T>()),
-    parent_(0), is_shadow_(false)
+  : local_frame_(),
+    parent_(0), is_shadow_(false), is_builtin_(false), is_call_(false)
   { }
   template <typename T>
   Environment<T>::Environment(Environment<T>* env, bool is_shadow)
-  : local_frame_(environment_map<std::string, T>()),
-    parent_(env), is_shadow_(is_shadow)
+  : local_frame_(),
+    parent_(env), is_shadow_(is_shadow), is_builtin_(false), is_call_(false)
   { }
   template <typename T>
   Environment<T>::Environment(Environment<T>& env, bool is_shadow)
-  : local_frame_(environment_map<std::string, T>()),
-    parent_(&env), is_shadow_(is_shadow)
+  : local_frame_(),
+    parent_(&env), is_shadow_(is_shadow), is_builtin_(false), is_call_(false)
   { }
 
   // link parent to create a stack
@@ -26,12 +105,20 @@ namespace Sass {
   template <typename T>
   void Environment<T>::link(Environment* env) { parent_ = env; }
 
+  // the root scope has no parent or only
+  // links to the shared built-in frame
+  template <typename T>
+  bool Environment<T>::is_root() const
+  {
+    return ! parent_ || parent_->is_builtin_;
+  }
+
   // this is used to find the global frame
   // which is the second last on the stack
   template <typename T>
   bool Environment<T>::is_lexical() const
   {
-    return !! parent_ && parent_->parent_;
+    return !! parent_ && ! parent_->is_root();
   }
 
   // only match the real root scope
@@ -41,43 +128,37 @@ namespace Sass {
   template <typename T>
   bool Environment<T>::is_global() const
   {
-    return parent_ && ! parent_->parent_;
+    return parent_ && ! is_root() && parent_->is_root();
   }
 
   template <typename T>
-  environment_map<std::string, T>& Environment<T>::local_frame() {
+  Env_Frame<T>& Environment<T>::local_frame() {
     return local_frame_;
   }
 
   template <typename T>
-  bool Environment<T>::has_local(const std::string& key) const
-  { return local_frame_.find(key) != local_frame_.end(); }
+  bool Environment<T>::has_local(Symbol key) const
+  { return local_frame_.find(key) != 0; }
 
   template <typename T> EnvResult
-  Environment<T>::find_local(const std::string& key)
+  Environment<T>::find_local(Symbol key)
   {
-    auto end = local_frame_.end();
-    auto it = local_frame_.find(key);
-    return EnvResult(it, it != end);
+    T* value = local_frame_.find(key);
+    return EnvResult(value, value != 0);
   }
 
   template <typename T>
-  T& Environment<T>::get_local(const std::string& key)
+  T& Environment<T>::get_local(Symbol key)
   { return local_frame_[key]; }
 
   template <typename T>
-  void Environment<T>::set_local(const std::string& key, const T& val)
-  {
-    local_frame_[key] = val;
-  }
-  template <typename T>
-  void Environment<T>::set_local(const std::string& key, T&& val)
+  void Environment<T>::set_local(Symbol key, const T& val)
   {
     local_frame_[key] = val;
   }
 
   template <typename T>
-  void Environment<T>::del_local(const std::string& key)
+  void Environment<T>::del_local(Symbol key)
   { local_frame_.erase(key); }
 
   template <typename T>
@@ -91,30 +172,25 @@ namespace Sass {
   }
 
   template <typename T>
-  bool Environment<T>::has_global(const std::string& key)
+  bool Environment<T>::has_global(Symbol key)
   { return global_env()->has(key); }
 
   template <typename T>
-  T& Environment<T>::get_global(const std::string& key)
+  T& Environment<T>::get_global(Symbol key)
   { return (*global_env())[key]; }
 
   template <typename T>
-  void Environment<T>::set_global(const std::string& key, const T& val)
-  {
-    global_env()->local_frame_[key] = val;
-  }
-  template <typename T>
-  void Environment<T>::set_global(const std::string& key, T&& val)
+  void Environment<T>::set_global(Symbol key, const T& val)
   {
     global_env()->local_frame_[key] = val;
   }
 
   template <typename T>
-  void Environment<T>::del_global(const std::string& key)
+  void Environment<T>::del_global(Symbol key)
   { global_env()->local_frame_.erase(key); }
 
   template <typename T>
-  Environment<T>* Environment<T>::lexical_env(const std::string& key)
+  Environment<T>* Environment<T>::lexical_env(Symbol key)
   {
     Environment* cur = this;
     while (cur) {
@@ -130,7 +206,7 @@ namespace Sass {
   // move down the stack but stop before we
   // reach the global frame (is not included)
   template <typename T>
-  bool Environment<T>::has_lexical(const std::string& key) const
+  bool Environment<T>::has_lexical(Symbol key) const
   {
     auto cur = this;
     while (cur->is_lexical()) {
@@ -144,31 +220,14 @@ namespace Sass {
   // either update already existing lexical value
   // or if flag is set, we create one if no lexical found
   template <typename T>
-  void Environment<T>::set_lexical(const std::string& key, const T& val)
-  {
-    Environment<T>* cur = this;
-    bool shadow = false;
-    while ((cur && cur->is_lexical()) || shadow) {
-      EnvResult rv(cur->find_local(key));
-      if (rv.found) {
-        rv.it->second = val;
-        return;
-      }
-      shadow = cur->is_shadow();
-      cur = cur->parent_;
-    }
-    set_local(key, val);
-  }
-  // this one moves the value
-  template <typename T>
-  void Environment<T>::set_lexical(const std::string& key, T&& val)
+  void Environment<T>::set_lexical(Symbol key, const T& val)
   {
     Environment<T>* cur = this;
     bool shadow = false;
     while ((cur && cur->is_lexical()) || shadow) {
       EnvResult rv(cur->find_local(key));
       if (rv.found) {
-        rv.it->second = val;
+        *rv.value = val;
         return;
       }
       shadow = cur->is_shadow();
@@ -180,7 +239,7 @@ namespace Sass {
   // look on the full stack for key
   // include all scopes available
   template <typename T>
-  bool Environment<T>::has(const std::string& key) const
+  bool Environment<T>::has(Symbol key) const
   {
     auto cur = this;
     while (cur) {
@@ -195,7 +254,7 @@ namespace Sass {
   // look on the full stack for key
   // include all scopes available
   template <typename T> EnvResult
-  Environment<T>::find(const std::string& key)
+  Environment<T>::find(Symbol key)
   {
     auto cur = this;
     while (true) {
@@ -206,14 +265,24 @@ namespace Sass {
     }
   };
 
+  // the resolver made sure no frame
+  // between us and the call has the key
+  template <typename T>
+  T* Environment<T>::find_slot(size_t slot, Symbol key)
+  {
+    auto cur = this;
+    while (cur && !cur->is_call_) cur = cur->parent_;
+    return cur ? cur->local_frame_.at(slot, key) : 0;
+  }
+
   // use array access for getter and setter functions
   template <typename T>
-  T& Environment<T>::operator[](const std::string& key)
+  T& Environment<T>::operator[](Symbol key)
   {
     auto cur = this;
     while (cur) {
-      if (cur->has_local(key)) {
-        return cur->get_local(key);
+      if (T* value = cur->local_frame_.find(key)) {
+        return *value;
       }
       cur = cur->parent_;
     }
@@ -240,6 +309,7 @@ namespace Sass {
   #endif
 */
   // compile implementation for AST_Node
+  template class Env_Frame<AST_Node_Obj>;
   template class Environment<AST_Node_Obj>;
 
 }
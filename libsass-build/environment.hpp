@@ -2,28 +2,78 @@
 #define SASS_ENVIRONMENT_H
 
 #include <string>
+#include <vector>
+#include <unordered_map>
+#include "symbol.hpp"
 #include "ast_fwd_decl.hpp"
 #include "ast_def_macros.hpp"
 
 namespace Sass {
 
-  typedef environment_map<std::string, AST_Node_Obj>::iterator EnvIter;
-
   class EnvResult {
     public:
-      EnvIter it;
+      AST_Node_Obj* value;
       bool found;
     public:
-      EnvResult(EnvIter it, bool found)
-      : it(it), found(found) {}
+      EnvResult(AST_Node_Obj* value, bool found)
+      : value(value), found(found) {}
+  };
+
+  // Flat table of one scope keyed by symbols. The first few items
+  // live inline, the rest in chunks that never move, so references
+  // stay valid while the frame grows (values are updated in place
+  // after evaluating them). Bigger frames get a hash index. Keys can
+  // be declared up front, they are not found until a value is set.
+  template <typename T>
+  class Env_Frame {
+  private:
+    static const size_t inline_size = 4;
+    static const size_t chunk_size = 16;
+    static const size_t index_size = 12;
+    std::pair<Symbol, T> inline_[inline_size];
+    std::vector<std::pair<Symbol, T>*> chunks_;
+    std::unordered_map<Symbol, size_t> index_;
+    size_t size_;
+    std::pair<Symbol, T>& item(size_t i)
+    {
+      if (i < inline_size) return inline_[i];
+      i -= inline_size;
+      return chunks_[i / chunk_size][i % chunk_size];
+    }
+    std::pair<Symbol, T>* lookup(Symbol key);
+    Env_Frame(const Env_Frame&);
+    Env_Frame& operator=(const Env_Frame&);
+  public:
+    Env_Frame() : chunks_(), index_(), size_(0) { }
+    ~Env_Frame() { for (auto chunk : chunks_) delete[] chunk; }
+    // returns 0 if the key is not set in this frame
+    T* find(Symbol key);
+    // returns 0 unless the key is set at that slot
+    T* at(size_t slot, Symbol key)
+    {
+      if (slot >= size_) return 0;
+      std::pair<Symbol, T>& entry = item(slot);
+      return entry.first == key && entry.second ? &entry.second : 0;
+    }
+    // reserve slots for the keys in order, frame must be empty
+    void declare(const std::vector<Symbol>& keys);
+    const T* find(Symbol key) const
+    { return const_cast<Env_Frame*>(this)->find(key); }
+    T& operator[](Symbol key);
+    T& operator[](const std::string& key)
+    { return (*this)[variable_symbol(key)]; }
+    void erase(Symbol key);
   };
 
   template <typename T>
   class Environment {
-    // TODO: test with map
-    environment_map<std::string, T> local_frame_;
+    Env_Frame<T> local_frame_;
     ADD_PROPERTY(Environment*, parent)
     ADD_PROPERTY(bool, is_shadow)
+    // read-only frame shared by many global frames
+    ADD_PROPERTY(bool, is_builtin)
+    // frame of a mixin or function call
+    ADD_PROPERTY(bool, is_call)
 
   public:
     Environment(bool is_shadow = false);
@@ -34,6 +84,10 @@ namespace Sass {
     void link(Environment& env);
     void link(Environment* env);
 
+    // the root scope has no parent or only
+    // links to the shared built-in frame
+    bool is_root() const;
+
     // this is used to find the global frame
     // which is the second last on the stack
     bool is_lexical() const;
@@ -46,58 +100,87 @@ namespace Sass {
 
     // scope operates on the current frame
 
-    environment_map<std::string, T>& local_frame();
+    Env_Frame<T>& local_frame();
 
-    bool has_local(const std::string& key) const;
+    // all keys are symbols, strings are interned as variables
+    // (lookups never intern them, unknown names are not bound)
+    // functions and mixins are looked up by their own symbols
 
-    EnvResult find_local(const std::string& key);
+    bool has_local(Symbol key) const;
+    bool has_local(const std::string& key) const
+    { Symbol symbol = find_variable_symbol(key); return symbol && has_local(symbol); }
 
-    T& get_local(const std::string& key);
+    EnvResult find_local(Symbol key);
+
+    T& get_local(Symbol key);
+    T& get_local(const std::string& key)
+    { return get_local(variable_symbol(key)); }
 
     // set variable on the current frame
-    void set_local(const std::string& key, const T& val);
-    void set_local(const std::string& key, T&& val);
+    void set_local(Symbol key, const T& val);
+    void set_local(const std::string& key, const T& val)
+    { set_local(variable_symbol(key), val); }
 
-    void del_local(const std::string& key);
+    void del_local(Symbol key);
 
     // global operates on the global frame
     // which is the second last on the stack
     Environment* global_env();
     // get the env where the variable already exists
     // if it does not yet exist, we return current env
-    Environment* lexical_env(const std::string& key);
+    Environment* lexical_env(Symbol key);
 
-    bool has_global(const std::string& key);
+    bool has_global(Symbol key);
+    bool has_global(const std::string& key)
+    { Symbol symbol = find_variable_symbol(key); return symbol && has_global(symbol); }
 
-    T& get_global(const std::string& key);
+    T& get_global(Symbol key);
+    T& get_global(const std::string& key)
+    { return get_global(variable_symbol(key)); }
 
     // set a variable on the global frame
-    void set_global(const std::string& key, const T& val);
-    void set_global(const std::string& key, T&& val);
+    void set_global(Symbol key, const T& val);
+    void set_global(const std::string& key, const T& val)
+    { set_global(variable_symbol(key), val); }
 
-    void del_global(const std::string& key);
+    void del_global(Symbol key);
+    void del_global(const std::string& key)
+    { del_global(variable_symbol(key)); }
 
     // see if we have a lexical variable
     // move down the stack but stop before we
     // reach the global frame (is not included)
-    bool has_lexical(const std::string& key) const;
+    bool has_lexical(Symbol key) const;
+    bool has_lexical(const std::string& key) const
+    { Symbol symbol = find_variable_symbol(key); return symbol && has_lexical(symbol); }
 
     // see if we have a lexical we could update
     // either update already existing lexical value
     // or we create a new one on the current frame
-    void set_lexical(const std::string& key, T&& val);
-    void set_lexical(const std::string& key, const T& val);
+    void set_lexical(Symbol key, const T& val);
+    void set_lexical(const std::string& key, const T& val)
+    { set_lexical(variable_symbol(key), val); }
 
     // look on the full stack for key
     // include all scopes available
-    bool has(const std::string& key) const;
+    bool has(Symbol key) const;
+    bool has(const std::string& key) const
+    { Symbol symbol = find_variable_symbol(key); return symbol && has(symbol); }
 
     // look on the full stack for key
     // include all scopes available
-    EnvResult find(const std::string& key);
+    EnvResult find(Symbol key);
+    EnvResult find(const std::string& key)
+    { Symbol symbol = find_variable_symbol(key); return symbol ? find(symbol) : EnvResult(0, false); }
+
+    // look up a slot resolved by Slot_Resolver in the
+    // frame of the innermost call, 0 if it is not set
+    T* find_slot(size_t slot, Symbol key);
 
     // use array access for getter and setter functions
-    T& operator[](const std::string& key);
+    T& operator[](Symbol key);
+    T& operator[](const std::string& key)
+    { return (*this)[variable_symbol(key)]; }
 
     #ifdef DEBUG
     size_t print(std::string prefix = "");
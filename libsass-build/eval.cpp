@@ -26,6 +26,7 @@
 #include "expand.hpp"
 #include "color_maps.hpp"
 #include "sass_functions.hpp"
+#include "call_batch.hpp"
 
 namespace Sass {
 
@@ -52,6 +53,20 @@ namespace Sass {
     return exp.selector();
   }
 
+  union Sass_Value* Eval::c_arguments(Parameters_Obj params, Env& fn_env)
+  {
+    To_C to_c;
+    union Sass_Value* c_args = sass_make_list(params->length(), SASS_COMMA, false);
+    for(size_t i = 0; i < params->length(); i++) {
+      Parameter_Obj param = params->at(i);
+      std::string key = param->name();
+      AST_Node_Obj node = fn_env.get_local(key);
+      Expression_Obj arg = Cast<Expression>(node);
+      sass_list_set_value(c_args, i, arg->perform(&to_c));
+    }
+    return c_args;
+  }
+
   Expression_Ptr Eval::operator()(Block_Ptr b)
   {
     Expression_Ptr val = 0;
@@ -176,7 +191,7 @@ namespace Sass {
       for (double i = start;
            i < end;
            ++i) {
-        Number_Obj it = SASS_MEMORY_NEW(Number, low->pstate(), i, sass_end->unit());
+        Number_Obj it = SASS_MEMORY_NEW(Number, low->pstate(), i, *sass_end);
         env.set_local(variable, it);
         val = body->perform(this);
         if (val) break;
@@ -186,7 +201,7 @@ namespace Sass {
       for (double i = start;
            i > end;
            --i) {
-        Number_Obj it = SASS_MEMORY_NEW(Number, low->pstate(), i, sass_end->unit());
+        Number_Obj it = SASS_MEMORY_NEW(Number, low->pstate(), i, *sass_end);
         env.set_local(variable, it);
         val = body->perform(this);
         if (val) break;
@@ -315,7 +330,7 @@ namespace Sass {
     Env* env = exp.environment();
 
     // try to use generic function
-    if (env->has("@warn[f]")) {
+    if (env->has(function_symbol("@warn"))) {
 
       // add call stack entry
       ctx.callee_stack.push_back({
@@ -327,7 +342,7 @@ namespace Sass {
         { env }
       });
 
-      Definition_Ptr def = Cast<Definition>((*env)["@warn[f]"]);
+      Definition_Ptr def = Cast<Definition>((*env)[function_symbol("@warn")]);
       // Block_Obj          body   = def->block();
       // Native_Function func   = def->native_function();
       Sass_Function_Entry c_function = def->c_function();
@@ -363,7 +378,7 @@ namespace Sass {
     Env* env = exp.environment();
 
     // try to use generic function
-    if (env->has("@error[f]")) {
+    if (env->has(function_symbol("@error"))) {
 
       // add call stack entry
       ctx.callee_stack.push_back({
@@ -375,7 +390,7 @@ namespace Sass {
         { env }
       });
 
-      Definition_Ptr def = Cast<Definition>((*env)["@error[f]"]);
+      Definition_Ptr def = Cast<Definition>((*env)[function_symbol("@error")]);
       // Block_Obj          body   = def->block();
       // Native_Function func   = def->native_function();
       Sass_Function_Entry c_function = def->c_function();
@@ -407,7 +422,7 @@ namespace Sass {
     Env* env = exp.environment();
 
     // try to use generic function
-    if (env->has("@debug[f]")) {
+    if (env->has(function_symbol("@debug"))) {
 
       // add call stack entry
       ctx.callee_stack.push_back({
@@ -419,7 +434,7 @@ namespace Sass {
         { env }
       });
 
-      Definition_Ptr def = Cast<Definition>((*env)["@debug[f]"]);
+      Definition_Ptr def = Cast<Definition>((*env)[function_symbol("@debug")]);
       // Block_Obj          body   = def->block();
       // Native_Function func   = def->native_function();
       Sass_Function_Entry c_function = def->c_function();
@@ -922,14 +937,18 @@ namespace Sass {
         stm << "Stack depth exceeded max of " << Constants::MaxCallStack;
         error(stm.str(), c->pstate(), traces);
     }
-    std::string name(Util::normalize_underscores(c->name()));
-    std::string full_name(name + "[f]");
+    static const Symbol generic = function_symbol("*");
+    static const Symbol call = function_symbol("call");
+    static const Symbol if_ = function_symbol("if");
+    Symbol full_name = c->symbol();
     // we make a clone here, need to implement that further
     Arguments_Obj args = c->arguments();
 
     Env* env = environment();
-    if (!env->has(full_name) || (!c->via_call() && Prelexer::re_special_fun(name.c_str()))) {
-      if (!env->has("*[f]")) {
+    EnvResult rv(env->find(full_name));
+    if (!rv.found || (!c->via_call() && Prelexer::re_special_fun(full_name->c_str()))) {
+      rv = env->find(generic);
+      if (!rv.found) {
         for (Argument_Obj arg : args->elements()) {
           if (List_Obj ls = Cast<List>(arg->value())) {
             if (ls->size() == 0) error("() isn't a valid CSS value.", c->pstate(), traces);
@@ -950,18 +969,18 @@ namespace Sass {
         return str;
       } else {
         // call generic function
-        full_name = "*[f]";
+        full_name = generic;
       }
     }
 
     // further delay for calls
-    if (full_name != "call[f]") {
+    if (full_name != call) {
       args->set_delayed(false); // verified
     }
-    if (full_name != "if[f]") {
+    if (full_name != if_) {
       args = Cast<Arguments>(args->perform(this));
     }
-    Definition_Ptr def = Cast<Definition>((*env)[full_name]);
+    Definition_Ptr def = Cast<Definition>(*rv.value);
 
     if (c->func()) def = c->func()->definition();
 
@@ -975,11 +994,12 @@ namespace Sass {
         // arguments before rest argument plus rest
         if (rest) L += rest->length() - 1;
       }
-      ss << full_name << L;
-      full_name = ss.str();
-      std::string resolved_name(full_name);
-      if (!env->has(resolved_name)) error("overloaded function `" + std::string(c->name()) + "` given wrong number of arguments", c->pstate(), traces);
-      def = Cast<Definition>((*env)[resolved_name]);
+      ss << *full_name << "/" << L;
+      // the argument count is not bound by the source
+      full_name = find_function_symbol(ss.str());
+      if (full_name) rv = env->find(full_name);
+      if (!full_name || !rv.found) error("overloaded function `" + std::string(c->name()) + "` given wrong number of arguments", c->pstate(), traces);
+      def = Cast<Definition>(*rv.value);
     }
 
     Expression_Obj     result = c;
@@ -991,6 +1011,8 @@ namespace Sass {
 
     Parameters_Obj params = def->parameters();
     Env fn_env(def->environment());
+    fn_env.is_call(true);
+    fn_env.local_frame().declare(def->slots());
     exp.env_stack.push_back(&fn_env);
 
     if (func || body) {
@@ -1024,7 +1046,7 @@ namespace Sass {
     // convert call into C-API compatible form
     else if (c_function) {
       Sass_Function_Fn c_func = sass_function_get_function(c_function);
-      if (full_name == "*[f]") {
+      if (full_name == generic) {
         String_Quoted_Obj str = SASS_MEMORY_NEW(String_Quoted, c->pstate(), c->name());
         Arguments_Obj new_args = SASS_MEMORY_NEW(Arguments, c->pstate());
         new_args->append(SASS_MEMORY_NEW(Argument, c->pstate(), str));
@@ -1046,27 +1068,36 @@ namespace Sass {
         { env }
       });
 
-      To_C to_c;
-      union Sass_Value* c_args = sass_make_list(params->length(), SASS_COMMA, false);
-      for(size_t i = 0; i < params->length(); i++) {
-        Parameter_Obj param = params->at(i);
-        std::string key = param->name();
-        AST_Node_Obj node = fn_env.get_local(key);
-        Expression_Obj arg = Cast<Expression>(node);
-        sass_list_set_value(c_args, i, arg->perform(&to_c));
+      union Sass_Value* c_args = c_arguments(params, fn_env);
+      // pure functions are called once per arguments
+      bool pure = sass_function_get_pure(c_function);
+      bool batched = sass_function_get_batched(c_function);
+      std::string key;
+      union Sass_Value* c_val = 0;
+      if (pure || batched) key = Function_Cache::key(c_function, c_args);
+      if (pure) c_val = ctx.function_cache.find(key);
+      if (c_val) {
+        result = cval_to_astnode(c_val, traces, c->pstate());
+        c_val = 0;
       }
-      union Sass_Value* c_val = c_func(c_args, c_function, ctx.c_compiler);
-      if (sass_value_get_tag(c_val) == SASS_ERROR) {
-        error("error in C function " + c->name() + ": " + sass_error_get_message(c_val), c->pstate(), traces);
-      } else if (sass_value_get_tag(c_val) == SASS_WARNING) {
-        error("warning in C function " + c->name() + ": " + sass_warning_get_message(c_val), c->pstate(), traces);
+      else {
+        // most likely prefetched by the enclosing loop
+        if (batched) c_val = ctx.function_cache.dequeue(key);
+        if (batched && !c_val) c_val = Call_Batch::invoke(c_function, std::vector<union Sass_Value*>(1, c_args), ctx.c_compiler)[0];
+        if (!batched) c_val = c_func(c_args, c_function, ctx.c_compiler);
+        if (sass_value_get_tag(c_val) == SASS_ERROR) {
+          error("error in C function " + c->name() + ": " + sass_error_get_message(c_val), c->pstate(), traces);
+        } else if (sass_value_get_tag(c_val) == SASS_WARNING) {
+          error("warning in C function " + c->name() + ": " + sass_warning_get_message(c_val), c->pstate(), traces);
+        }
+        if (pure) ctx.function_cache.store(key, c_val);
+        result = cval_to_astnode(c_val, traces, c->pstate());
       }
-      result = cval_to_astnode(c_val, traces, c->pstate());
 
       ctx.callee_stack.pop_back();
       traces.pop_back();
       sass_delete_value(c_args);
-      if (c_val != c_args)
+      if (c_val && c_val != c_args)
         sass_delete_value(c_val);
     }
 
@@ -1095,9 +1126,9 @@ namespace Sass {
   {
     Expression_Obj value = 0;
     Env* env = environment();
-    const std::string& name(v->name());
-    EnvResult rv(env->find(name));
-    if (rv.found) value = static_cast<Expression*>(rv.it->second.ptr());
+    AST_Node_Obj* slot = v->slot() ? env->find_slot(v->slot() - 1, v->symbol()) : 0;
+    EnvResult rv(slot ? EnvResult(slot, true) : env->find(v->symbol()));
+    if (rv.found) value = static_cast<Expression*>(rv.value->ptr());
     else error("Undefined variable: \"" + v->name() + "\".", v->pstate(), traces);
     if (Argument_Ptr arg = Cast<Argument>(value)) value = arg->value();
     if (Number_Ptr nr = Cast<Number>(value)) nr->zero(true); // force flag
@@ -1105,7 +1136,7 @@ namespace Sass {
     if (force) value->is_expanded(false);
     value->set_delayed(false); // verified
     value = value->perform(this);
-    if(!force) rv.it->second = value;
+    if(!force) *rv.value = value;
     return value.detach();
   }
 
@@ -1583,28 +1614,11 @@ namespace Sass {
     std::string result_str(sel->to_string(ctx.c_options));
     ctx.c_options.in_selector = false; // flag temporary only
     result_str = unquote(Util::rtrim(result_str));
-    char* temp_cstr = sass_copy_c_string(result_str.c_str());
-    ctx.strings.push_back(temp_cstr); // attach to context
-    Parser p = Parser::from_c_str(temp_cstr, ctx, traces, s->pstate());
-    p.last_media_block = s->media_block();
     // a selector schema may or may not connect to parent?
     bool chroot = s->connect_parent() == false;
-    Selector_List_Obj sl = p.parse_selector_list(chroot);
-    auto vec_str_rend = ctx.strings.rend();
-    auto vec_str_rbegin = ctx.strings.rbegin();
-    // remove the first item searching from the back
-    // we cannot assume our item is still the last one
-    // order is not important, so we can optimize this
-    auto it = std::find(vec_str_rbegin, vec_str_rend, temp_cstr);
-    // undefined behavior if not found!
-    if (it != vec_str_rend) {
-      // overwrite with last item
-      *it = ctx.strings.back();
-      // remove last one from vector
-      ctx.strings.pop_back();
-      // free temporary copy
-      free(temp_cstr);
-    }
+    // generated rules tend to repeat their selectors
+    Selector_List_Obj sl = ctx.parse_cache.parse_selector_list(ctx, traces,
+      result_str, s->pstate(), s->media_block(), chroot);
     flag_is_in_selector_schema.reset();
     return operator()(sl);
   }
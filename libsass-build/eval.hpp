@@ -33,6 +33,8 @@ namespace Sass {
 
     Env* environment();
     Selector_List_Obj selector();
+    // bound parameters as passed to a c function
+    union Sass_Value* c_arguments(Parameters_Obj params, Env& fn_env);
 
     // for evaluating function bodies
     Expression_Ptr operator()(Block_Ptr);
@@ -10,6 +10,7 @@
 #include "context.hpp"
 #include "parser.hpp"
 #include "sass_functions.hpp"
+#include "call_batch.hpp"
 
 namespace Sass {
 
@@ -178,10 +179,8 @@ namespace Sass {
     ctx.ast_gc.push_back(cpy); cpy->block(0);
     Expression_Obj mq = eval(m->media_queries());
     std::string str_mq(mq->to_string(ctx.c_options));
-    char* str = sass_copy_c_string(str_mq.c_str());
-    ctx.strings.push_back(str);
-    Parser p(Parser::from_c_str(str, ctx, traces, mq->pstate()));
-    mq = p.parse_media_queries(); // re-assign now
+    // re-assign now (shared with blocks expanded from the same source)
+    mq = ctx.parse_cache.parse_media_queries(ctx, traces, str_mq, mq->pstate());
     cpy->media_queries(mq);
     media_block_stack.push_back(cpy);
     Block_Obj blk = operator()(m->block());
@@ -453,30 +452,53 @@ namespace Sass {
     env_stack.push_back(&env);
     call_stack.push_back(f);
     Block_Ptr body = f->block();
+    Call_Batch batch(eval, body, std::vector<std::string>(1, variable));
+    // values are only collected up front for a batch
+    std::vector<std::vector<Expression_Obj>> iterations;
     if (start < end) {
       if (f->is_inclusive()) ++end;
       for (double i = start;
            i < end;
            ++i) {
-        Number_Obj it = SASS_MEMORY_NEW(Number, low->pstate(), i, sass_end->unit());
-        env.set_local(variable, it);
-        append_block(body);
+        Number_Obj it = SASS_MEMORY_NEW(Number, low->pstate(), i, *sass_end);
+        if (batch.empty()) {
+          env.set_local(variable, it);
+          append_block(body);
+        }
+        else iterations.push_back(std::vector<Expression_Obj>(1, it));
       }
     } else {
       if (f->is_inclusive()) --end;
       for (double i = start;
            i > end;
            --i) {
-        Number_Obj it = SASS_MEMORY_NEW(Number, low->pstate(), i, sass_end->unit());
-        env.set_local(variable, it);
-        append_block(body);
+        Number_Obj it = SASS_MEMORY_NEW(Number, low->pstate(), i, *sass_end);
+        if (batch.empty()) {
+          env.set_local(variable, it);
+          append_block(body);
+        }
+        else iterations.push_back(std::vector<Expression_Obj>(1, it));
       }
     }
+    batch.prefetch(env, iterations);
+    for (const std::vector<Expression_Obj>& values : iterations) {
+      env.set_local(variable, values[0]);
+      append_block(body);
+    }
     call_stack.pop_back();
     env_stack.pop_back();
     return 0;
   }
 
+  // set the loop variables and expand the body once
+  void Expand::expand_iteration(Env& env, const std::vector<std::string>& variables, const std::vector<Expression_Obj>& values, Block_Ptr body)
+  {
+    for (size_t j = 0, K = values.size(); j < K; ++j) {
+      env.set_local(variables[j], values[j]);
+    }
+    append_block(body);
+  }
+
   // Eval does not create a new env scope
   // But iteration vars are reset afterwards
   Statement_Ptr Expand::operator()(Each_Ptr e)
@@ -505,22 +527,28 @@ namespace Sass {
     env_stack.push_back(&env);
     call_stack.push_back(e);
     Block_Ptr body = e->block();
+    Call_Batch batch(eval, body, variables);
+    // values of the variables for each iteration
+    // they are only collected up front for a batch
+    std::vector<std::vector<Expression_Obj>> iterations;
 
     if (map) {
       for (auto key : map->keys()) {
         Expression_Obj k = key->perform(&eval);
         Expression_Obj v = map->at(key)->perform(&eval);
 
+        std::vector<Expression_Obj> values;
         if (variables.size() == 1) {
           List_Obj variable = SASS_MEMORY_NEW(List, map->pstate(), 2, SASS_SPACE);
           variable->append(k);
           variable->append(v);
-          env.set_local(variables[0], variable);
+          values.push_back(variable);
         } else {
-          env.set_local(variables[0], k);
-          env.set_local(variables[1], v);
+          values.push_back(k);
+          values.push_back(v);
         }
-        append_block(body);
+        if (batch.empty()) expand_iteration(env, variables, values, body);
+        else iterations.push_back(values);
       }
     }
     else {
@@ -530,6 +558,7 @@ namespace Sass {
       }
       for (size_t i = 0, L = list->length(); i < L; ++i) {
         Expression_Obj item = list->at(i);
+        std::vector<Expression_Obj> values;
         // unwrap value if the expression is an argument
         if (Argument_Obj arg = Cast<Argument>(item)) item = arg->value();
         // check if we got passed a list of args (investigate)
@@ -537,27 +566,32 @@ namespace Sass {
           if (variables.size() == 1) {
             List_Obj var = scalars;
             // if (arglist) var = (*scalars)[0];
-            env.set_local(variables[0], var);
+            values.push_back(var);
           } else {
             for (size_t j = 0, K = variables.size(); j < K; ++j) {
               Expression_Obj res = j >= scalars->length()
                 ? SASS_MEMORY_NEW(Null, expr->pstate())
                 : (*scalars)[j]->perform(&eval);
-              env.set_local(variables[j], res);
+              values.push_back(res);
             }
           }
         } else {
           if (variables.size() > 0) {
-            env.set_local(variables.at(0), item);
+            values.push_back(item);
             for (size_t j = 1, K = variables.size(); j < K; ++j) {
               Expression_Obj res = SASS_MEMORY_NEW(Null, expr->pstate());
-              env.set_local(variables[j], res);
+              values.push_back(res);
             }
           }
         }
-        append_block(body);
+        if (batch.empty()) expand_iteration(env, variables, values, body);
+        else iterations.push_back(values);
       }
     }
+    batch.prefetch(env, iterations);
+    for (const std::vector<Expression_Obj>& values : iterations) {
+      expand_iteration(env, variables, values, body);
+    }
     call_stack.pop_back();
     env_stack.pop_back();
     return 0;
@@ -673,8 +707,8 @@ namespace Sass {
   {
     Env* env = environment();
     Definition_Obj dd = SASS_MEMORY_COPY(d);
-    env->local_frame()[d->name() +
-                        (d->type() == Definition::MIXIN ? "[m]" : "[f]")] = dd;
+    env->local_frame()[d->type() == Definition::MIXIN ?
+                        mixin_symbol(d->name()) : function_symbol(d->name())] = dd;
 
     if (d->type() == Definition::FUNCTION && (
       Prelexer::calc_fn_call(d->name().c_str()) ||
@@ -703,11 +737,11 @@ namespace Sass {
     recursions ++;
 
     Env* env = environment();
-    std::string full_name(c->name() + "[m]");
-    if (!env->has(full_name)) {
+    EnvResult found(env->find(c->symbol()));
+    if (!found.found) {
       error("no mixin named " + c->name(), c->pstate(), traces);
     }
-    Definition_Obj def = Cast<Definition>((*env)[full_name]);
+    Definition_Obj def = Cast<Definition>(*found.value);
     Block_Obj body = def->block();
     Parameters_Obj params = def->parameters();
 
@@ -728,6 +762,8 @@ namespace Sass {
     });
 
     Env new_env(def->environment());
+    new_env.is_call(true);
+    new_env.local_frame().declare(def->slots());
     env_stack.push_back(&new_env);
     if (c->block()) {
       // represent mixin content blocks as thunks/closures
@@ -738,7 +774,7 @@ namespace Sass {
                                           c->block(),
                                           Definition::MIXIN);
       thunk->environment(env);
-      new_env.local_frame()["@content[m]"] = thunk;
+      new_env.local_frame()[mixin_symbol("@content")] = thunk;
     }
 
     bind(std::string("Mixin"), c->name(), params, args, &ctx, &new_env, &eval);
@@ -773,7 +809,7 @@ namespace Sass {
   {
     Env* env = environment();
     // convert @content directives into mixin calls to the underlying thunk
-    if (!env->has("@content[m]")) return 0;
+    if (!env->has(mixin_symbol("@content"))) return 0;
 
     if (block_stack.back()->is_root()) {
       selector_stack.push_back(0);
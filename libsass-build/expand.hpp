@@ -75,6 +75,7 @@ namespace Sass {
     Statement_Ptr fallback(U x) { return fallback_impl(x); }
 
     void append_block(Block_Ptr);
+    void expand_iteration(Env& env, const std::vector<std::string>& variables, const std::vector<Expression_Obj>& values, Block_Ptr body);
   };
 
 }
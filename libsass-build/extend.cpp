@@ -299,17 +299,17 @@ namespace Sass {
     return isSuperselector;
   }
 
-  void nodeToComplexSelectorDeque(const Node& node, ComplexSelectorDeque& out) {
-    for (NodeDeque::iterator iter = node.collection()->begin(), iterEnd = node.collection()->end(); iter != iterEnd; iter++) {
+  void nodeToComplexSelectorVector(const Node& node, ComplexSelectorVector& out) {
+    for (NodeCollection::iterator iter = node.collection()->begin(), iterEnd = node.collection()->end(); iter != iterEnd; iter++) {
       Node& child = *iter;
       out.push_back(nodeToComplexSelector(child));
     }
   }
 
-  Node complexSelectorDequeToNode(const ComplexSelectorDeque& deque) {
+  Node complexSelectorVectorToNode(const ComplexSelectorVector& deque) {
     Node result = Node::createCollection();
 
-    for (ComplexSelectorDeque::const_iterator iter = deque.begin(), iterEnd = deque.end(); iter != iterEnd; iter++) {
+    for (ComplexSelectorVector::const_iterator iter = deque.begin(), iterEnd = deque.end(); iter != iterEnd; iter++) {
       Complex_Selector_Obj pChild = *iter;
       result.collection()->push_back(complexSelectorToNode(pChild));
     }
@@ -362,9 +362,9 @@ namespace Sass {
   # Computes a single longest common subsequence for arrays x and y.
   # Algorithm from http://en.wikipedia.org/wiki/Longest_common_subsequence_problem#Reading_out_an_LCS
   */
-  void lcs_backtrace(const LCSTable& c, ComplexSelectorDeque& x, ComplexSelectorDeque& y, int i, int j, const LcsCollectionComparator& comparator, ComplexSelectorDeque& out) {
+  void lcs_backtrace(const LCSTable& c, ComplexSelectorVector& x, ComplexSelectorVector& y, int i, int j, const LcsCollectionComparator& comparator, ComplexSelectorVector& out) {
     //DEBUG_PRINTLN(LCS, "LCSBACK: X=" << x << " Y=" << y << " I=" << i << " J=" << j)
-    // TODO: make printComplexSelectorDeque and use DEBUG_EXEC AND DEBUG_PRINTLN HERE to get equivalent output
+    // TODO: make printComplexSelectorVector and use DEBUG_EXEC AND DEBUG_PRINTLN HERE to get equivalent output
 
     if (i == 0 || j == 0) {
       DEBUG_PRINTLN(LCS, "RETURNING EMPTY")
@@ -380,7 +380,7 @@ namespace Sass {
       return;
     }
 
-    if (c[i][j - 1] > c[i - 1][j]) {
+    if (c.at(i, j - 1) > c.at(i - 1, j)) {
       DEBUG_PRINTLN(LCS, "RETURNING AFTER TABLE COMPARE")
       lcs_backtrace(c, x, y, i, j - 1, comparator, out);
       return;
@@ -397,13 +397,11 @@ namespace Sass {
   # Calculates the memoization table for the Least Common Subsequence algorithm.
   # Algorithm from http://en.wikipedia.org/wiki/Longest_common_subsequence_problem#Computing_the_length_of_the_LCS
   */
-  void lcs_table(const ComplexSelectorDeque& x, const ComplexSelectorDeque& y, const LcsCollectionComparator& comparator, LCSTable& out) {
+  void lcs_table(const ComplexSelectorVector& x, const ComplexSelectorVector& y, const LcsCollectionComparator& comparator, LCSTable& c) {
     //DEBUG_PRINTLN(LCS, "LCSTABLE: X=" << x << " Y=" << y)
-    // TODO: make printComplexSelectorDeque and use DEBUG_EXEC AND DEBUG_PRINTLN HERE to get equivalent output
+    // TODO: make printComplexSelectorVector and use DEBUG_EXEC AND DEBUG_PRINTLN HERE to get equivalent output
 
-    LCSTable c(x.size(), std::vector<int>(y.size()));
-
-    // These shouldn't be necessary since the vector will be initialized to 0 already.
+    // These shouldn't be necessary since the table is initialized to 0 already.
     // x.size.times {|i| c[i][0] = 0}
     // y.size.times {|j| c[0][j] = 0}
 
@@ -412,14 +410,12 @@ namespace Sass {
         Complex_Selector_Obj pCompareOut;
 
         if (comparator(x[i], y[j], pCompareOut)) {
-          c[i][j] = c[i - 1][j - 1] + 1;
+          c.at(i, j) = c.at(i - 1, j - 1) + 1;
         } else {
-          c[i][j] = std::max(c[i][j - 1], c[i - 1][j]);
+          c.at(i, j) = std::max(c.at(i, j - 1), c.at(i - 1, j));
         }
       }
     }
-
-    out = c;
   }
 
   /*
@@ -436,14 +432,14 @@ namespace Sass {
 
   http://en.wikipedia.org/wiki/Longest_common_subsequence_problem
   */
-  void lcs(ComplexSelectorDeque& x, ComplexSelectorDeque& y, const LcsCollectionComparator& comparator, ComplexSelectorDeque& out) {
+  void lcs(ComplexSelectorVector& x, ComplexSelectorVector& y, const LcsCollectionComparator& comparator, ComplexSelectorVector& out) {
     //DEBUG_PRINTLN(LCS, "LCS: X=" << x << " Y=" << y)
-    // TODO: make printComplexSelectorDeque and use DEBUG_EXEC AND DEBUG_PRINTLN HERE to get equivalent output
+    // TODO: make printComplexSelectorVector and use DEBUG_EXEC AND DEBUG_PRINTLN HERE to get equivalent output
 
-    x.push_front(NULL);
-    y.push_front(NULL);
+    x.insert(x.begin(), Complex_Selector_Obj());
+    y.insert(y.begin(), Complex_Selector_Obj());
 
-    LCSTable table;
+    LCSTable table(x.size(), y.size());
     lcs_table(x, y, comparator, table);
 
     return lcs_backtrace(table, x, y, static_cast<int>(x.size()) - 1, static_cast<int>(y.size()) - 1, comparator, out);
@@ -538,7 +534,7 @@ namespace Sass {
     // of the index manually.
     int toTrimIndex = 0;
 
-    for (NodeDeque::iterator seqsesIter = seqses.collection()->begin(), seqsesIterEnd = seqses.collection()->end(); seqsesIter != seqsesIterEnd; ++seqsesIter) {
+    for (NodeCollection::iterator seqsesIter = seqses.collection()->begin(), seqsesIterEnd = seqses.collection()->end(); seqsesIter != seqsesIterEnd; ++seqsesIter) {
       Node& seqs1 = *seqsesIter;
 
       DEBUG_PRINTLN(TRIM, "SEQS1: " << seqs1 << " " << toTrimIndex)
@@ -546,7 +542,7 @@ namespace Sass {
       Node tempResult = Node::createCollection();
       tempResult.got_line_feed = seqs1.got_line_feed;
 
-      for (NodeDeque::iterator seqs1Iter = seqs1.collection()->begin(), seqs1EndIter = seqs1.collection()->end(); seqs1Iter != seqs1EndIter; ++seqs1Iter) {
+      for (NodeCollection::iterator seqs1Iter = seqs1.collection()->begin(), seqs1EndIter = seqs1.collection()->end(); seqs1Iter != seqs1EndIter; ++seqs1Iter) {
         Node& seq1 = *seqs1Iter;
 
         Complex_Selector_Obj pSeq1 = nodeToComplexSelector(seq1);
@@ -576,7 +572,7 @@ namespace Sass {
 
         int resultIndex = 0;
 
-        for (NodeDeque::iterator resultIter = result.collection()->begin(), resultIterEnd = result.collection()->end(); resultIter != resultIterEnd; ++resultIter) {
+        for (NodeCollection::iterator resultIter = result.collection()->begin(), resultIterEnd = result.collection()->end(); resultIter != resultIterEnd; ++resultIter) {
           Node& seqs2 = *resultIter;
 
           DEBUG_PRINTLN(TRIM, "SEQS1: " << seqs1)
@@ -593,7 +589,7 @@ namespace Sass {
 
           bool isMoreSpecificInner = false;
 
-          for (NodeDeque::iterator seqs2Iter = seqs2.collection()->begin(), seqs2IterEnd = seqs2.collection()->end(); seqs2Iter != seqs2IterEnd; ++seqs2Iter) {
+          for (NodeCollection::iterator seqs2Iter = seqs2.collection()->begin(), seqs2IterEnd = seqs2.collection()->end(); seqs2Iter != seqs2IterEnd; ++seqs2Iter) {
             Node& seq2 = *seqs2Iter;
 
             Complex_Selector_Obj pSeq2 = nodeToComplexSelector(seq2);
@@ -783,8 +779,8 @@ namespace Sass {
 
 
   static void getAndRemoveInitialOps(Node& seq, Node& ops) {
-    NodeDeque& seqCollection = *(seq.collection());
-    NodeDeque& opsCollection = *(ops.collection());
+    NodeCollection& seqCollection = *(seq.collection());
+    NodeCollection& opsCollection = *(ops.collection());
 
     while (seqCollection.size() > 0 && seqCollection.front().isCombinator()) {
       opsCollection.push_back(seqCollection.front());
@@ -794,8 +790,8 @@ namespace Sass {
 
 
   static void getAndRemoveFinalOps(Node& seq, Node& ops) {
-    NodeDeque& seqCollection = *(seq.collection());
-    NodeDeque& opsCollection = *(ops.collection());
+    NodeCollection& seqCollection = *(seq.collection());
+    NodeCollection& opsCollection = *(ops.collection());
 
     while (seqCollection.size() > 0 && seqCollection.back().isCombinator()) {
       opsCollection.push_back(seqCollection.back()); // Purposefully reversed to match ruby code
@@ -1213,7 +1209,7 @@ namespace Sass {
     // Moving this line up since fin isn't modified between now and when it happened before
     // fin.map {|sel| sel.is_a?(Array) ? sel : [sel]}
 
-    for (NodeDeque::iterator finIter = fin.collection()->begin(), finEndIter = fin.collection()->end();
+    for (NodeCollection::iterator finIter = fin.collection()->begin(), finEndIter = fin.collection()->end();
            finIter != finEndIter; ++finIter) {
 
       Node& childNode = *finIter;
@@ -1237,16 +1233,16 @@ namespace Sass {
     DEBUG_PRINTLN(SUBWEAVE, "SEQ2: " << groupSeq2)
 
 
-    ComplexSelectorDeque groupSeq1Converted;
-    nodeToComplexSelectorDeque(groupSeq1, groupSeq1Converted);
+    ComplexSelectorVector groupSeq1Converted;
+    nodeToComplexSelectorVector(groupSeq1, groupSeq1Converted);
 
-    ComplexSelectorDeque groupSeq2Converted;
-    nodeToComplexSelectorDeque(groupSeq2, groupSeq2Converted);
+    ComplexSelectorVector groupSeq2Converted;
+    nodeToComplexSelectorVector(groupSeq2, groupSeq2Converted);
 
-    ComplexSelectorDeque out;
+    ComplexSelectorVector out;
     LcsCollectionComparator collectionComparator;
     lcs(groupSeq2Converted, groupSeq1Converted, collectionComparator, out);
-    Node seqLcs = complexSelectorDequeToNode(out);
+    Node seqLcs = complexSelectorVectorToNode(out);
 
     DEBUG_PRINTLN(SUBWEAVE, "SEQLCS: " << seqLcs)
 
@@ -1293,7 +1289,7 @@ namespace Sass {
 
     // JMA - filter out the empty nodes (use a new collection, since iterator erase() invalidates the old collection)
     Node diffFiltered = Node::createCollection();
-    for (NodeDeque::iterator diffIter = diff.collection()->begin(), diffEndIter = diff.collection()->end();
+    for (NodeCollection::iterator diffIter = diff.collection()->begin(), diffEndIter = diff.collection()->end();
            diffIter != diffEndIter; ++diffIter) {
       Node& node = *diffIter;
       if (node.collection() && !node.collection()->empty()) {
@@ -1311,7 +1307,7 @@ namespace Sass {
 
 
     // We're flattening in place
-    for (NodeDeque::iterator pathsIter = pathsResult.collection()->begin(), pathsEndIter = pathsResult.collection()->end();
+    for (NodeCollection::iterator pathsIter = pathsResult.collection()->begin(), pathsEndIter = pathsResult.collection()->end();
       pathsIter != pathsEndIter; ++pathsIter) {
 
       Node& child = *pathsIter;
@@ -1458,7 +1454,7 @@ namespace Sass {
 
       Node tempResult = Node::createCollection();
 
-      for (NodeDeque::iterator beforesIter = befores.collection()->begin(), beforesEndIter = befores.collection()->end(); beforesIter != beforesEndIter; beforesIter++) {
+      for (NodeCollection::iterator beforesIter = befores.collection()->begin(), beforesEndIter = befores.collection()->end(); beforesIter != beforesEndIter; beforesIter++) {
         Node& before = *beforesIter;
 
         Node sub = subweave(before, current);
@@ -1469,7 +1465,7 @@ namespace Sass {
           return Node::createCollection();
         }
 
-        for (NodeDeque::iterator subIter = sub.collection()->begin(), subEndIter = sub.collection()->end(); subIter != subEndIter; subIter++) {
+        for (NodeCollection::iterator subIter = sub.collection()->begin(), subEndIter = sub.collection()->end(); subIter != subEndIter; subIter++) {
           Node& seqs = *subIter;
 
           Node toPush = Node::createCollection();
@@ -1519,15 +1515,21 @@ namespace Sass {
   };
   Node Extend::extendCompoundSelector(Compound_Selector_Ptr pSelector, CompoundSelectorSet& seen, bool isReplace) {
 
-    /* this turned out to be too much overhead
-       probably due to holding a "Node" object
     // check if we already extended this selector
     // we can do this since subset_map is "static"
-    auto memoized = memoizeCompound.find(pSelector);
-    if (memoized != memoizeCompound.end()) {
-      return memoized->second.klone();
+    // the result depends on what we have seen and on
+    // the sources, only memoize it if there are none
+    bool isMemoizable = !isReplace && seen.empty() && pSelector->sources().empty();
+    if (isMemoizable) {
+      auto memoized = memoizeCompound.find(pSelector);
+      if (memoized != memoizeCompound.end()) {
+        mergeExtended(memoized->second.extended);
+        // callers modify the collection and its selectors
+        return memoized->second.result.klone();
+      }
     }
-    */
+    std::vector<uint64_t> outerExtended;
+    outerExtended.swap(extended);
 
     DEBUG_EXEC(EXTEND_COMPOUND, printCompoundSelector(pSelector, "EXTEND COMPOUND: "))
     // TODO: Ruby has another loop here to skip certain members?
@@ -1554,7 +1556,7 @@ namespace Sass {
 
       Compound_Selector_Obj pSels = SASS_MEMORY_NEW(Compound_Selector, pSelector->pstate());
       for (SubSetMapPair& pair : group) {
-        pair.second->extended(true);
+        markExtended(pair.second);
         pSels->concat(pair.second);
       }
 
@@ -1660,7 +1662,7 @@ namespace Sass {
 
       DEBUG_PRINTLN(EXTEND_COMPOUND, "RECURSING DO EXTEND RETURN: " << recurseExtendedSelectors)
 
-      for (NodeDeque::iterator iterator = recurseExtendedSelectors.collection()->begin(), endIterator = recurseExtendedSelectors.collection()->end();
+      for (NodeCollection::iterator iterator = recurseExtendedSelectors.collection()->begin(), endIterator = recurseExtendedSelectors.collection()->end();
            iterator != endIterator; ++iterator) {
         Node newSelector = *iterator;
 
@@ -1676,9 +1678,12 @@ namespace Sass {
 
     DEBUG_EXEC(EXTEND_COMPOUND, printCompoundSelector(pSelector, "EXTEND COMPOUND END: "))
 
-    // this turned out to be too much overhead
     // memory results in a map table - since extending is very expensive
-    // memoizeCompound.insert(std::pair<Compound_Selector_Obj, Node>(pSelector, results));
+    if (isMemoizable) {
+      Memoized<Node> memoized = { results.klone(), extended };
+      memoizeCompound.insert(std::make_pair(Compound_Selector_Obj(pSelector), memoized));
+    }
+    mergeExtended(outerExtended);
 
     return results;
   }
@@ -1747,8 +1752,11 @@ namespace Sass {
     // we can do this since subset_map is "static"
     auto memoized = memoizeComplex.find(selector);
     if (memoized != memoizeComplex.end()) {
-      return memoized->second;
+      mergeExtended(memoized->second.extended);
+      return memoized->second.result;
     }
+    std::vector<uint64_t> outerExtended;
+    outerExtended.swap(extended);
 
     // convert the input selector to extend node format
     Node complexSelector = complexSelectorToNode(selector);
@@ -1855,7 +1863,9 @@ namespace Sass {
     DEBUG_PRINTLN(EXTEND_COMPLEX, "EXTEND COMPLEX END: " << complexSelector)
 
     // memory results in a map table - since extending is very expensive
-    memoizeComplex.insert(std::pair<Complex_Selector_Obj, Node>(selector, flattened));
+    Memoized<Node> memoizedResult = { flattened, extended };
+    memoizeComplex.insert(std::make_pair(Complex_Selector_Obj(selector), memoizedResult));
+    mergeExtended(outerExtended);
 
     // return trim(WEAVES)
     return flattened;
@@ -1877,8 +1887,11 @@ namespace Sass {
     auto memoized = memoizeList.find(pSelectorList);
     if (memoized != memoizeList.end()) {
       extendedSomething = true;
-      return memoized->second;
+      mergeExtended(memoized->second.extended);
+      return memoized->second.result;
     }
+    std::vector<uint64_t> outerExtended;
+    outerExtended.swap(extended);
 
     extendedSomething = false;
     // process each comlplex selector in the selector list.
@@ -1996,7 +2009,9 @@ namespace Sass {
     }
 
     // memory results in a map table - since extending is very expensive
-    memoizeList.insert(std::pair<Selector_List_Obj, Selector_List_Obj>(pSelectorList, pNewSelectors));
+    Memoized<Selector_List_Obj> memoizedResult = { pNewSelectors, extended };
+    memoizeList.insert(std::make_pair(pSelectorList, memoizedResult));
+    mergeExtended(outerExtended);
 
     return pNewSelectors.detach();
 
@@ -2055,7 +2070,43 @@ namespace Sass {
     bool extendedSomething = false;
 
     CompoundSelectorSet seen;
-    Selector_List_Obj pNewSelectorList = extendSelectorList(pObject->selector(), false, extendedSomething, seen);
+    Selector_List_Obj pSelectorList = pObject->selector();
+    Selector_List_Obj pNewSelectorList;
+
+    // look for the result of another compilation
+    // only if there is something to extend at all
+    std::string key;
+    if (cache) {
+      for (Complex_Selector_Obj pSelector : pSelectorList->elements()) {
+        if (complexSelectorHasExtension(pSelector, seen)) {
+          key = cacheKey(pSelectorList);
+          break;
+        }
+      }
+    }
+
+    Extend_Cache::Result cached;
+    if (!key.empty() && cache->find(fingerprint, key, pSelectorList->pstate(), cached)) {
+      // mark the targets as if we had extended them
+      const std::vector<SubSetMapPair>& values = subset_map.values();
+      for (size_t i = 0, L = values.size(); i < L; ++i) {
+        if (i / 64 >= cached.extended.size()) break;
+        if (cached.extended[i / 64] & (uint64_t(1) << (i % 64))) {
+          values[i].second->extended(true);
+        }
+      }
+      extendedSomething = true;
+      pNewSelectorList = cached.selector;
+    }
+    else {
+      extended.clear();
+      pNewSelectorList = extendSelectorList(pSelectorList, false, extendedSomething, seen);
+      if (!key.empty() && extendedSomething && pNewSelectorList) {
+        cached.selector = pNewSelectorList;
+        cached.extended = extended;
+        cache->store(fingerprint, key, cached);
+      }
+    }
 
     if (extendedSomething && pNewSelectorList) {
       DEBUG_PRINTLN(EXTEND_OBJECT, "EXTEND ORIGINAL SELECTORS: " << pObject->selector()->to_string())
@@ -2068,13 +2119,91 @@ namespace Sass {
   }
 
   Extend::Extend(Subset_Map& ssm)
-  : subset_map(ssm), eval(NULL)
+  : subset_map(ssm), eval(NULL), cache(NULL)
   { }
 
   void Extend::setEval(Eval& e) {
     eval = &e;
   }
 
+  // append a part of a cache key (prefixed by its length)
+  static void append_extend_key(std::string& key, const std::string& part)
+  {
+    key += std::to_string(part.size());
+    key += ':';
+    key += part;
+  }
+
+  // the extension checks media queries across directives
+  static void append_extend_key(std::string& key, Media_Block_Ptr media)
+  {
+    if (!media) return;
+    key += '@';
+    if (media->media_queries()) append_extend_key(key, media->media_queries()->to_string());
+  }
+
+  static void append_extend_key(std::string& key, Compound_Selector_Ptr compound)
+  {
+    key += compound->has_line_feed() ? 'F' : '-';
+    key += compound->has_line_break() ? 'B' : '-';
+    append_extend_key(key, compound->to_string());
+    append_extend_key(key, compound->media_block());
+  }
+
+  // everything the extension looks at, not just the rendering
+  static void append_extend_key(std::string& key, Complex_Selector_Ptr complex)
+  {
+    for (; complex; complex = complex->tail()) {
+      key += complex->has_line_feed() ? 'F' : '-';
+      key += complex->has_line_break() ? 'B' : '-';
+      key += static_cast<char>('0' + complex->combinator());
+      if (complex->reference()) append_extend_key(key, complex->reference()->to_string());
+      if (complex->head()) append_extend_key(key, complex->head());
+      key += ';';
+    }
+    key += ',';
+  }
+
+  std::string Extend::cacheKey(Selector_List_Ptr pSelectorList)
+  {
+    std::string key;
+    for (Complex_Selector_Obj pSelector : pSelectorList->elements()) {
+      append_extend_key(key, pSelector);
+    }
+    return key;
+  }
+
+  void Extend::setCache(Extend_Cache& c)
+  {
+    cache = &c;
+    // subset map is complete once we extend
+    const std::vector<SubSetMapPair>& values = subset_map.values();
+    for (size_t i = 0, L = values.size(); i < L; ++i) {
+      if (values[i].first) append_extend_key(fingerprint, values[i].first);
+      if (values[i].second) append_extend_key(fingerprint, values[i].second);
+      fingerprint += '|';
+      // targets may be shared by many extenders
+      targets.insert(std::make_pair(values[i].second.ptr(), i));
+    }
+  }
+
+  void Extend::markExtended(Compound_Selector_Ptr target)
+  {
+    target->extended(true);
+    if (cache == NULL) return;
+    auto it = targets.find(target);
+    if (it == targets.end()) return;
+    size_t word = it->second / 64;
+    if (extended.size() <= word) extended.resize(word + 1, 0);
+    extended[word] |= uint64_t(1) << (it->second % 64);
+  }
+
+  void Extend::mergeExtended(const std::vector<uint64_t>& bits)
+  {
+    if (extended.size() < bits.size()) extended.resize(bits.size(), 0);
+    for (size_t i = 0, L = bits.size(); i < L; ++i) extended[i] |= bits[i];
+  }
+
   void Extend::operator()(Block_Ptr b)
   {
     for (size_t i = 0, L = b->length(); i < L; ++i) {
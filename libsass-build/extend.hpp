@@ -3,12 +3,15 @@
 
 #include <string>
 #include <set>
+#include <vector>
+#include <stdint.h>
 
 #include "ast.hpp"
 #include "node.hpp"
 #include "eval.hpp"
 #include "operation.hpp"
 #include "subset_map.hpp"
+#include "extend_cache.hpp"
 #include "ast_fwd_decl.hpp"
 
 namespace Sass {
@@ -24,29 +27,48 @@ namespace Sass {
 
   private:
 
+    // memoized result with the extenders it used
+    template <typename T>
+    struct Memoized {
+      T result;
+      std::vector<uint64_t> extended;
+    };
+
     std::unordered_map<
       Selector_List_Obj, // key
-      Selector_List_Obj, // value
+      Memoized<Selector_List_Obj>, // value
       HashNodes, // hasher
       CompareNodes // compare
     > memoizeList;
 
     std::unordered_map<
       Complex_Selector_Obj, // key
-      Node, // value
+      Memoized<Node>, // value
       HashNodes, // hasher
       CompareNodes // compare
     > memoizeComplex;
 
-    /* this turned out to be too much overhead
-       re-evaluate once we store an ast selector
+    // only holds results of compound selectors without sources
+    // extended from the top (nothing seen yet, not replacing)
     std::unordered_map<
       Compound_Selector_Obj, // key
-      Node, // value
+      Memoized<Node>, // value
       HashNodes, // hasher
       CompareNodes // compare
     > memoizeCompound;
-    */
+
+    // results shared with other compilations
+    Extend_Cache* cache;
+    // all extenders and targets of the subset map
+    std::string fingerprint;
+    // position of the targets in the subset map
+    std::unordered_map<Compound_Selector_Ptr, size_t> targets;
+    // targets used by the current extension (if cached)
+    std::vector<uint64_t> extended;
+
+    void markExtended(Compound_Selector_Ptr target);
+    void mergeExtended(const std::vector<uint64_t>& bits);
+    std::string cacheKey(Selector_List_Ptr pSelectorList);
 
     void extendObjectWithSelectorAndBlock(Ruleset_Ptr pObject);
     Node extendComplexSelector(Complex_Selector_Ptr sel, CompoundSelectorSet& seen, bool isReplace, bool isOriginal);
@@ -57,6 +79,8 @@ namespace Sass {
 
   public:
     void setEval(Eval& eval);
+    // reuse (and keep) results of other compilations
+    void setCache(Extend_Cache& cache);
     Selector_List_Ptr extendSelectorList(Selector_List_Obj pSelectorList, bool isReplace, bool& extendedSomething, CompoundSelectorSet& seen);
     Selector_List_Ptr extendSelectorList(Selector_List_Obj pSelectorList, bool isReplace = false) {
       bool extendedSomething = false;
@@ -0,0 +1,130 @@
+#include "sass.hpp"
+
+#include "ast.hpp"
+#include "extend_cache.hpp"
+
+namespace Sass {
+
+  // results of the least recently used fingerprint are dropped
+  // once we hold more tables (watchers keep editing their extends)
+  static const size_t max_extend_tables = 16;
+
+  // Makes a selector from a deep copy independent of the tree it was
+  // copied from. Values the clone still shares are copied too, the
+  // pointers back into the tree (media block, sources, schema) are
+  // dropped and everything is moved to the given position.
+  static void detach_selector(Selector_Ptr s, const ParserState& pstate)
+  {
+    if (!s) return;
+    s->pstate(pstate);
+    s->media_block(0);
+    if (Selector_List_Ptr list = Cast<Selector_List>(s)) {
+      list->schema(0);
+      for (Complex_Selector_Obj complex : list->elements()) {
+        detach_selector(complex, pstate);
+      }
+    }
+    else if (Complex_Selector_Ptr complex = Cast<Complex_Selector>(s)) {
+      if (complex->reference()) {
+        complex->reference(SASS_MEMORY_CLONE(complex->reference()));
+        complex->reference()->pstate(pstate);
+      }
+      detach_selector(complex->head(), pstate);
+      detach_selector(complex->tail(), pstate);
+    }
+    else if (Compound_Selector_Ptr compound = Cast<Compound_Selector>(s)) {
+      compound->clearSources();
+      for (Simple_Selector_Obj simple : compound->elements()) {
+        detach_selector(simple, pstate);
+      }
+    }
+    else if (Wrapped_Selector_Ptr wrapped = Cast<Wrapped_Selector>(s)) {
+      detach_selector(wrapped->selector(), pstate);
+    }
+    else if (Attribute_Selector_Ptr attribute = Cast<Attribute_Selector>(s)) {
+      if (attribute->value()) {
+        attribute->value(SASS_MEMORY_CLONE(attribute->value()));
+        attribute->value()->pstate(pstate);
+      }
+    }
+    else if (Pseudo_Selector_Ptr pseudo = Cast<Pseudo_Selector>(s)) {
+      if (pseudo->expression()) {
+        pseudo->expression(SASS_MEMORY_CLONE(pseudo->expression()));
+        pseudo->expression()->pstate(pstate);
+      }
+    }
+  }
+
+  Extend_Cache::Extend_Cache()
+  : mutex(), tables(), tick(0), hits(0), misses(0)
+  { }
+
+  Extend_Cache::~Extend_Cache()
+  { }
+
+  bool Extend_Cache::find(const std::string& fingerprint, const std::string& key, const ParserState& pstate, Result& result)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto table = tables.find(fingerprint);
+    if (table == tables.end()) { ++ misses; return false; }
+    table->second.used = ++ tick;
+    auto it = table->second.results.find(key);
+    if (it == table->second.results.end()) { ++ misses; return false; }
+    result.selector = SASS_MEMORY_CLONE(it->second.selector);
+    detach_selector(result.selector, pstate);
+    result.extended = it->second.extended;
+    ++ hits; return true;
+  }
+
+  void Extend_Cache::store(const std::string& fingerprint, const std::string& key, const Result& result)
+  {
+    // only this thread can see the tree of the result
+    Result copy;
+    copy.selector = SASS_MEMORY_CLONE(result.selector);
+    detach_selector(copy.selector, ParserState("[EXTEND]"));
+    copy.extended = result.extended;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto table = tables.find(fingerprint);
+    if (table == tables.end()) {
+      if (tables.size() >= max_extend_tables) {
+        auto oldest = tables.begin();
+        for (auto it = tables.begin(); it != tables.end(); ++it) {
+          if (it->second.used < oldest->second.used) oldest = it;
+        }
+        tables.erase(oldest);
+      }
+      table = tables.insert(std::make_pair(fingerprint, Table())).first;
+    }
+    table->second.used = ++ tick;
+    table->second.results[key] = copy;
+    // release our reference while still holding the lock
+    copy.selector = 0;
+  }
+
+  void Extend_Cache::clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tables.clear();
+  }
+
+  size_t Extend_Cache::get_hits()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+  }
+
+  size_t Extend_Cache::get_misses()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+  }
+
+  size_t Extend_Cache::get_size()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t size = 0;
+    for (auto& table : tables) size += table.second.results.size();
+    return size;
+  }
+
+}
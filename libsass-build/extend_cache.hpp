@@ -0,0 +1,61 @@
+#ifndef SASS_EXTEND_CACHE_H
+#define SASS_EXTEND_CACHE_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <unordered_map>
+
+#include "ast_fwd_decl.hpp"
+#include "position.hpp"
+
+namespace Sass {
+
+  // Keeps the extended selectors of rulesets between compilations.
+  // Results are grouped by a fingerprint of the subset map (all the
+  // extenders with their targets), so compilations sharing the same
+  // @extends share one table. Within a table a selector is keyed by
+  // its structure (see `Extend::cache_key`). Our ref-counts are not
+  // atomic, the stored selectors are deep copies only touched under
+  // the lock. Source positions are not kept, a result takes on the
+  // position of the selector it replaces.
+  class Extend_Cache {
+  public:
+    struct Result {
+      Selector_List_Obj selector;
+      // extenders used, bit set over the subset map values
+      std::vector<uint64_t> extended;
+    };
+
+  private:
+    struct Table {
+      std::unordered_map<std::string, Result> results;
+      size_t used;
+    };
+    std::mutex mutex;
+    std::unordered_map<std::string, Table> tables;
+    size_t tick;
+    size_t hits;
+    size_t misses;
+
+  public:
+    Extend_Cache();
+    ~Extend_Cache();
+
+    // copy of the cached result, placed at the given position
+    bool find(const std::string& fingerprint, const std::string& key, const ParserState& pstate, Result& result);
+    // keep a copy of the result
+    void store(const std::string& fingerprint, const std::string& key, const Result& result);
+    // drop all results
+    void clear();
+
+    size_t get_hits();
+    size_t get_misses();
+    size_t get_size();
+
+  };
+
+}
+
+#endif
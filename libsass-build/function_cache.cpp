@@ -0,0 +1,137 @@
+#include "sass.hpp"
+#include <cstring>
+
+#include "function_cache.hpp"
+
+namespace Sass {
+
+  static void key_bytes(std::string& key, const void* data, size_t size)
+  {
+    key.append(static_cast<const char*>(data), size);
+  }
+
+  static void key_string(std::string& key, const char* str)
+  {
+    size_t size = str ? std::strlen(str) : 0;
+    key_bytes(key, &size, sizeof(size));
+    if (size) key.append(str, size);
+  }
+
+  static void key_double(std::string& key, double value)
+  {
+    key_bytes(key, &value, sizeof(value));
+  }
+
+  // serialize everything the function could look at
+  static void key_value(std::string& key, const union Sass_Value* val)
+  {
+    enum Sass_Tag tag = sass_value_get_tag(val);
+    key += static_cast<char>(tag);
+    switch (tag) {
+      case SASS_BOOLEAN:
+        key += sass_boolean_get_value(val) ? '1' : '0';
+        break;
+      case SASS_NUMBER:
+        key_double(key, sass_number_get_value(val));
+        key_string(key, sass_number_get_unit(val));
+        break;
+      case SASS_COLOR:
+        key_double(key, sass_color_get_r(val));
+        key_double(key, sass_color_get_g(val));
+        key_double(key, sass_color_get_b(val));
+        key_double(key, sass_color_get_a(val));
+        break;
+      case SASS_STRING:
+        key += sass_string_is_quoted(val) ? '"' : '-';
+        key_string(key, sass_string_get_value(val));
+        break;
+      case SASS_LIST: {
+        size_t length = sass_list_get_length(val);
+        key += static_cast<char>(sass_list_get_separator(val));
+        key += sass_list_get_is_bracketed(val) ? '[' : '-';
+        key_bytes(key, &length, sizeof(length));
+        for (size_t i = 0; i < length; ++i) {
+          key_value(key, sass_list_get_value(val, i));
+        }
+      } break;
+      case SASS_MAP: {
+        size_t length = sass_map_get_length(val);
+        key_bytes(key, &length, sizeof(length));
+        for (size_t i = 0; i < length; ++i) {
+          key_value(key, sass_map_get_key(val, i));
+          key_value(key, sass_map_get_value(val, i));
+        }
+      } break;
+      case SASS_ERROR:
+        key_string(key, sass_error_get_message(val));
+        break;
+      case SASS_WARNING:
+        key_string(key, sass_warning_get_message(val));
+        break;
+      default: break;
+    }
+  }
+
+  Function_Cache::Function_Cache()
+  : results(), queued()
+  { }
+
+  Function_Cache::~Function_Cache()
+  {
+    for (auto result : results) sass_delete_value(result.second);
+    for (auto& pending : queued) {
+      for (auto& result : pending.second) sass_delete_value(result.first);
+    }
+  }
+
+  std::string Function_Cache::key(Sass_Function_Entry fn, const union Sass_Value* args)
+  {
+    std::string key;
+    key_bytes(key, &fn, sizeof(fn));
+    key_value(key, args);
+    return key;
+  }
+
+  union Sass_Value* Function_Cache::find(const std::string& key)
+  {
+    auto it = results.find(key);
+    return it == results.end() ? 0 : it->second;
+  }
+
+  void Function_Cache::store(const std::string& key, const union Sass_Value* result)
+  {
+    union Sass_Value*& cached = results[key];
+    if (cached) sass_delete_value(cached);
+    cached = sass_clone_value(result);
+  }
+
+  void Function_Cache::queue(const std::string& key, union Sass_Value* result, const void* owner)
+  {
+    queued[key].push_back(std::make_pair(result, owner));
+  }
+
+  union Sass_Value* Function_Cache::dequeue(const std::string& key)
+  {
+    auto it = queued.find(key);
+    if (it == queued.end()) return 0;
+    union Sass_Value* result = it->second.front().first;
+    it->second.pop_front();
+    if (it->second.empty()) queued.erase(it);
+    return result;
+  }
+
+  void Function_Cache::unqueue(const void* owner)
+  {
+    for (auto it = queued.begin(); it != queued.end();) {
+      auto& pending = it->second;
+      for (size_t i = 0; i < pending.size();) {
+        if (pending[i].second != owner) { ++ i; continue; }
+        sass_delete_value(pending[i].first);
+        pending.erase(pending.begin() + i);
+      }
+      if (pending.empty()) it = queued.erase(it);
+      else ++ it;
+    }
+  }
+
+}
@@ -0,0 +1,47 @@
+#ifndef SASS_FUNCTION_CACHE_H
+#define SASS_FUNCTION_CACHE_H
+
+#include <deque>
+#include <string>
+#include <utility>
+#include <unordered_map>
+
+#include "sass/values.h"
+#include "sass/functions.h"
+
+namespace Sass {
+
+  // Remembers the results of pure c functions for one context.
+  // Calls are keyed by the function and the arguments exactly as
+  // they are passed to it (numbers keep their unit, strings their
+  // quotes). Sass equality is too loose here, `1in == 96px`.
+  // Also holds the results of batched calls until the call they
+  // were prefetched for is evaluated (see `Call_Batch`).
+  class Function_Cache {
+  private:
+    std::unordered_map<std::string, union Sass_Value*> results;
+    // prefetched results with the batch that queued them
+    std::unordered_map<std::string, std::deque<std::pair<union Sass_Value*, const void*>>> queued;
+
+  public:
+    Function_Cache();
+    ~Function_Cache();
+
+    // key for a call of the function with the given arguments
+    static std::string key(Sass_Function_Entry fn, const union Sass_Value* args);
+    // cached result of the call or 0 (owned by the cache)
+    union Sass_Value* find(const std::string& key);
+    // keep a copy of the result
+    void store(const std::string& key, const union Sass_Value* result);
+    // take ownership of a prefetched result
+    void queue(const std::string& key, union Sass_Value* result, const void* owner);
+    // oldest prefetched result of the call or 0 (owned by the caller)
+    union Sass_Value* dequeue(const std::string& key);
+    // drop whatever the batch prefetched but was never asked for
+    void unqueue(const void* owner);
+
+  };
+
+}
+
+#endif
@@ -246,7 +246,7 @@ namespace Sass {
         str->quote_mark(0);
       }
       std::string exp_src = exp->to_string(ctx.c_options);
-      return Parser::parse_selector(exp_src.c_str(), ctx, traces);
+      return ctx.parse_cache.parse_selector(ctx, traces, exp_src);
     }
 
     template <>
@@ -261,7 +261,7 @@ namespace Sass {
         str->quote_mark(0);
       }
       std::string exp_src = exp->to_string(ctx.c_options);
-      Selector_List_Obj sel_list = Parser::parse_selector(exp_src.c_str(), ctx, traces);
+      Selector_List_Obj sel_list = ctx.parse_cache.parse_selector(ctx, traces, exp_src);
       if (sel_list->length() == 0) return NULL;
       Complex_Selector_Obj first = sel_list->first();
       if (!first->tail()) return first->head();
@@ -294,7 +294,8 @@ namespace Sass {
     // random_device degrades sharply once the entropy pool
     // is exhausted. For practical use, random_device is
     // generally only used to seed a PRNG such as mt19937.
-    static std::mt19937 rand(static_cast<unsigned int>(GetSeed()));
+    // one generator per thread, so compilers may run in parallel
+    static thread_local std::mt19937 rand(static_cast<unsigned int>(GetSeed()));
 
     // features
     static std::set<std::string> features {
@@ -1807,7 +1808,8 @@ namespace Sass {
 
       std::string name = Util::normalize_underscores(unquote(ss->value()));
 
-      if(d_env.has_global(name+"[f]")) {
+      Symbol symbol = find_function_symbol(name);
+      if(symbol && d_env.has_global(symbol)) {
         return SASS_MEMORY_NEW(Boolean, pstate, true);
       }
       else {
@@ -1820,7 +1822,8 @@ namespace Sass {
     {
       std::string s = Util::normalize_underscores(unquote(ARG("$name", String_Constant)->value()));
 
-      if(d_env.has_global(s+"[m]")) {
+      Symbol symbol = find_mixin_symbol(s);
+      if(symbol && d_env.has_global(symbol)) {
         return SASS_MEMORY_NEW(Boolean, pstate, true);
       }
       else {
@@ -1970,7 +1973,7 @@ namespace Sass {
           str->quote_mark(0);
         }
         std::string exp_src = exp->to_string(ctx.c_options);
-        Selector_List_Obj sel = Parser::parse_selector(exp_src.c_str(), ctx, traces);
+        Selector_List_Obj sel = ctx.parse_cache.parse_selector(ctx, traces, exp_src);
         parsedSelectors.push_back(sel);
       }
 
@@ -2023,7 +2026,7 @@ namespace Sass {
           str->quote_mark(0);
         }
         std::string exp_src = exp->to_string();
-        Selector_List_Obj sel = Parser::parse_selector(exp_src.c_str(), ctx, traces);
+        Selector_List_Obj sel = ctx.parse_cache.parse_selector(ctx, traces, exp_src);
         parsedSelectors.push_back(sel);
       }
 
@@ -2197,7 +2200,7 @@ namespace Sass {
       if (!d_env.has_global("is_in_mixin")) {
         error("Cannot call content-exists() except within a mixin.", pstate, traces);
       }
-      return SASS_MEMORY_NEW(Boolean, pstate, d_env.has_lexical("@content[m]"));
+      return SASS_MEMORY_NEW(Boolean, pstate, d_env.has_lexical(mixin_symbol("@content")));
     }
 
     Signature get_function_sig = "get-function($name, $css: false)";
@@ -2209,7 +2212,7 @@ namespace Sass {
       }
 
       std::string name = Util::normalize_underscores(unquote(ss->value()));
-      std::string full_name = name + "[f]";
+      Symbol full_name = find_function_symbol(name);
 
       Boolean_Obj css = ARG("$css", Boolean);
       if (!css->is_false()) {
@@ -2223,7 +2226,7 @@ namespace Sass {
       }
 
 
-      if (!d_env.has_global(full_name)) {
+      if (!full_name || !d_env.has_global(full_name)) {
         error("Function not found: " + name, pstate, traces);
       }
 
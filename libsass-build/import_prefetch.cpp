@@ -0,0 +1,179 @@
+#include "sass.hpp"
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include <system_error>
+
+#include "ast.hpp"
+#include "util.hpp"
+#include "parser.hpp"
+#include "context.hpp"
+#include "prelexer.hpp"
+#include "import_prefetch.hpp"
+
+namespace Sass {
+
+  // quick scan for the quoted locations of all top-level imports
+  // this is only a hint, the parser still decides what to load
+  static void scan_imports(const char* src, std::vector<std::string>& locations)
+  {
+    size_t depth = 0;
+    while (*src) {
+      if (src[0] == '/' && src[1] == '/') {
+        while (*src && *src != '\n') ++ src;
+      }
+      else if (src[0] == '/' && src[1] == '*') {
+        const char* end = std::strstr(src + 2, "*/");
+        src = end ? end + 2 : src + std::strlen(src);
+      }
+      else if (*src == '"' || *src == '\'') {
+        char quote = *src ++;
+        while (*src && *src != quote) if (*src ++ == '\\' && *src) ++ src;
+        if (*src) ++ src;
+      }
+      else if (*src == '{') { ++ depth; ++ src; }
+      else if (*src == '}') { if (depth) -- depth; ++ src; }
+      else if (depth == 0 && std::strncmp(src, "@import", 7) == 0) {
+        src += 7;
+        while (true) {
+          while (*src && std::isspace(static_cast<unsigned char>(*src))) ++ src;
+          if (*src != '"' && *src != '\'') break;
+          const char* beg = src;
+          char quote = *src ++;
+          while (*src && *src != quote) if (*src ++ == '\\' && *src) ++ src;
+          if (!*src) break;
+          locations.push_back(std::string(beg, ++ src));
+          while (*src && std::isspace(static_cast<unsigned char>(*src))) ++ src;
+          if (*src != ',') break;
+          ++ src;
+        }
+      }
+      else ++ src;
+    }
+  }
+
+  Import_Prefetch::Sheet::Sheet(const std::string& abs_path, size_t file_id)
+  : abs_path(abs_path),
+    path(sass_copy_c_string(abs_path.c_str())),
+    contents(0),
+    file_id(file_id),
+    root(),
+    imports(),
+    state(QUEUED)
+  { }
+
+  Import_Prefetch::Sheet::~Sheet()
+  {
+    // the tree points into both buffers
+    imports.clear();
+    root = 0;
+    free(contents);
+    free(path);
+  }
+
+  Import_Prefetch::Import_Prefetch(Context& ctx, const char* contents, const std::string& ctx_path)
+  : ctx(ctx), mutex(), parsed(), sheets(), workers(), stopped(false)
+  {
+    size_t threads = ctx.c_options.import_threads > 0 ? ctx.c_options.import_threads : 0;
+    // cached sheets are not parsed again anyway
+    if (threads == 0 || ctx.sheet_cache || contents == 0) return;
+
+    std::vector<std::string> locations;
+    scan_imports(contents, locations);
+    for (const std::string& location : locations) {
+      std::string imp_path(unquote(location));
+      // urls and css files are not loaded (see `import_url`)
+      using namespace Prelexer;
+      if (sequence< identifier, exactly<':'>, exactly<'/'>, exactly<'/'> >(imp_path.c_str())) continue;
+      if (imp_path.substr(0, 2) == "//") continue;
+      if (imp_path.length() > 4 && imp_path.substr(imp_path.length() - 4, 4) == ".css") continue;
+      // resolved the same way as the parser will do it later
+      const std::vector<Include> resolved(ctx.find_includes(Importer(imp_path, ctx_path)));
+      if (resolved.size() != 1) continue;
+      bool queued = false;
+      for (Sheet* sheet : sheets) queued = queued || sheet->abs_path == resolved[0].abs_path;
+      // must not collide with any resource index
+      if (!queued) sheets.push_back(new Sheet(resolved[0].abs_path, std::string::npos / 4 + sheets.size()));
+    }
+    if (sheets.empty()) return;
+
+    ctx.prefetch = this;
+    if (threads > sheets.size()) threads = sheets.size();
+    // the caller parses whatever no worker picked up
+    try { while (workers.size() < threads) workers.push_back(std::thread(&Import_Prefetch::work, this)); }
+    catch (std::system_error&) { }
+  }
+
+  Import_Prefetch::~Import_Prefetch()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopped = true;
+    }
+    for (std::thread& worker : workers) worker.join();
+    for (Sheet* sheet : sheets) delete sheet;
+    if (ctx.prefetch == this) ctx.prefetch = 0;
+  }
+
+  void Import_Prefetch::work()
+  {
+    while (true) {
+      Sheet* next = 0;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopped) return;
+        for (Sheet* sheet : sheets) {
+          if (sheet->state == Sheet::QUEUED) { next = sheet; break; }
+        }
+        if (next == 0) return;
+        next->state = Sheet::PARSING;
+      }
+      parse(next);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        next->state = Sheet::DONE;
+      }
+      parsed.notify_all();
+    }
+  }
+
+  // must not access the context (except for the parser)
+  void Import_Prefetch::parse(Sheet* sheet)
+  {
+    sheet->contents = File::read_file(sheet->abs_path);
+    if (sheet->contents == 0) return;
+    ParserState pstate(sheet->path, sheet->contents, sheet->file_id);
+    try {
+      Parser p(Parser::from_c_str(sheet->contents, ctx, Backtraces(), pstate));
+      p.deferred_imports = &sheet->imports;
+      sheet->root = p.parse();
+    }
+    // parsed again to report the error
+    catch (...) {
+      sheet->imports.clear();
+      sheet->root = 0;
+    }
+  }
+
+  Import_Prefetch::Sheet* Import_Prefetch::take(const std::string& abs_path)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (size_t i = 0, S = sheets.size(); i < S; ++i) {
+      Sheet* sheet = sheets[i];
+      if (sheet->abs_path != abs_path) continue;
+      // no worker got to it yet
+      if (sheet->state == Sheet::QUEUED) {
+        sheet->state = Sheet::TAKEN;
+        return 0;
+      }
+      while (sheet->state == Sheet::PARSING) parsed.wait(lock);
+      if (sheet->state != Sheet::DONE) return 0;
+      sheet->state = Sheet::TAKEN;
+      if (!sheet->root) return 0;
+      sheets.erase(sheets.begin() + i);
+      return sheet;
+    }
+    return 0;
+  }
+
+}
@@ -0,0 +1,82 @@
+#ifndef SASS_IMPORT_PREFETCH_H
+#define SASS_IMPORT_PREFETCH_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "ast_fwd_decl.hpp"
+#include "position.hpp"
+
+namespace Sass {
+
+  class Context;
+
+  // an import statement of a sheet parsed ahead of time
+  // the parser leaves the import node as a placeholder
+  // in the block, its locations are loaded later
+  struct Deferred_Import {
+    Import_Obj imp;
+    Block_Obj block;
+    std::vector<std::pair<std::string, Function_Call_Obj>> locations;
+    ParserState pstate;
+  };
+
+  // Parses the files imported by the entry sheet on worker threads
+  // while the entry itself is still being parsed. Workers never touch
+  // the context, the imports of the prefetched sheets are deferred and
+  // only loaded once the main parser reaches that sheet. Resources are
+  // therefore registered in the very same order as without prefetch.
+  // Our ref-counts are not atomic, a sheet is only handed over once
+  // its worker is done with it.
+  class Import_Prefetch {
+  public:
+    class Sheet {
+    public:
+      enum State { QUEUED, PARSING, DONE, TAKEN };
+    public:
+      // resolved absolute path
+      std::string abs_path;
+      // path used by all parser states
+      char* path;
+      // the file contents
+      char* contents;
+      // source id used by all parser states
+      // translated back in the source map
+      size_t file_id;
+      // parsed root block (null on errors)
+      Block_Obj root;
+      // imports to load once the sheet is registered
+      std::vector<Deferred_Import> imports;
+      State state;
+    public:
+      Sheet(const std::string& abs_path, size_t file_id);
+      ~Sheet();
+    };
+
+  private:
+    Context& ctx;
+    std::mutex mutex;
+    std::condition_variable parsed;
+    std::vector<Sheet*> sheets;
+    std::vector<std::thread> workers;
+    bool stopped;
+    void work();
+    void parse(Sheet* sheet);
+
+  public:
+    // scans the entry for static imports and starts the workers
+    Import_Prefetch(Context& ctx, const char* contents, const std::string& ctx_path);
+    ~Import_Prefetch();
+
+    // hand over the parsed sheet (caller must delete it)
+    // returns 0 if the sheet has to be parsed by the caller
+    Sheet* take(const std::string& abs_path);
+
+  };
+
+}
+
+#endif
@@ -11,16 +11,45 @@
 extern "C" {
 #endif
 
+// Threading: any number of contexts may be compiled at the same time,
+// each on its own thread. A context (with its options and compiler)
+// must only be used by one thread at a time. Sheet caches are the only
+// objects meant to be shared. Custom functions and importers may be
+// called from several threads at once. With `import_threads` set, a
+// compile parses the imports of its entry file on extra threads, but
+// importers are still only called from the compiling thread.
 
 // Forward declaration
 struct Sass_Compiler;
 
+// Forward declaration
+struct Sass_Sheet_Cache;
+
+// Forward declaration
+struct Sass_Batch;
+
 // Forward declaration
 struct Sass_Options; // base struct
 struct Sass_Context; // : Sass_Options
 struct Sass_File_Context; // : Sass_Context
 struct Sass_Data_Context; // : Sass_Context
 
+// Receives the compiled css in chunks while it is rendered, the output
+// string stays empty then; return false to abort the compilation
+typedef bool (*Sass_Output_Sink_Fn)
+  (const char* chunk, size_t length, void* cookie);
+
+// Mapping of a position in the compiled css to its source (all zero
+// based, columns in characters), as encoded in the source map json
+struct Sass_Source_Mapping {
+  size_t generated_line;
+  size_t generated_column;
+  // index into the sources of the map
+  size_t source;
+  size_t source_line;
+  size_t source_column;
+};
+
 // Compiler states
 enum Sass_Compiler_State {
   SASS_COMPILER_CREATED,
@@ -30,6 +59,20 @@ enum Sass_Compiler_State {
 
 // Create and initialize an option struct
 ADDAPI struct Sass_Options* ADDCALL sass_make_options (void);
+// Create a cache for parsed sheets that can be shared between
+// compilations (set via option); must outlive all of them
+ADDAPI struct Sass_Sheet_Cache* ADDCALL sass_make_sheet_cache (void);
+ADDAPI void ADDCALL sass_delete_sheet_cache (struct Sass_Sheet_Cache* cache);
+ADDAPI void ADDCALL sass_sheet_cache_clear (struct Sass_Sheet_Cache* cache);
+ADDAPI void ADDCALL sass_sheet_cache_invalidate (struct Sass_Sheet_Cache* cache, const char* path);
+ADDAPI size_t ADDCALL sass_sheet_cache_get_hits (struct Sass_Sheet_Cache* cache);
+ADDAPI size_t ADDCALL sass_sheet_cache_get_misses (struct Sass_Sheet_Cache* cache);
+ADDAPI size_t ADDCALL sass_sheet_cache_get_size (struct Sass_Sheet_Cache* cache);
+// Extended selectors of rulesets are kept by the sheet cache as well
+// (unless the compilation creates a source map)
+ADDAPI size_t ADDCALL sass_sheet_cache_get_extend_hits (struct Sass_Sheet_Cache* cache);
+ADDAPI size_t ADDCALL sass_sheet_cache_get_extend_misses (struct Sass_Sheet_Cache* cache);
+ADDAPI size_t ADDCALL sass_sheet_cache_get_extend_size (struct Sass_Sheet_Cache* cache);
 // Create and initialize a specific context
 ADDAPI struct Sass_File_Context* ADDCALL sass_make_file_context (const char* input_path);
 ADDAPI struct Sass_Data_Context* ADDCALL sass_make_data_context (char* source_string);
@@ -56,6 +99,26 @@ ADDAPI void ADDCALL sass_delete_options(struct Sass_Options* options);
 ADDAPI void ADDCALL sass_delete_file_context (struct Sass_File_Context* ctx);
 ADDAPI void ADDCALL sass_delete_data_context (struct Sass_Data_Context* ctx);
 
+// Compile many entry files with the same options (incl. importers and
+// functions). Entries only set their input, output and source map file
+// paths (and output sink), the rest is taken from the batch options. Unless the options
+// have one, a sheet cache is used to share partials between entries.
+// Compiles all entries on up to `threads` threads (incl. the caller)
+// and returns the number of failed entries. Results are read from the
+// file contexts, which are freed with the batch. Recompile only compiles
+// the entries depending on the changed files (null terminated paths),
+// plus the ones that failed before. Their indexes are listed by compiled.
+ADDAPI struct Sass_Batch* ADDCALL sass_make_batch (void);
+ADDAPI struct Sass_Options* ADDCALL sass_batch_get_options (struct Sass_Batch* batch);
+ADDAPI struct Sass_File_Context* ADDCALL sass_batch_add_file (struct Sass_Batch* batch, const char* input_path);
+ADDAPI struct Sass_File_Context* ADDCALL sass_batch_get_file_context (struct Sass_Batch* batch, size_t idx);
+ADDAPI size_t ADDCALL sass_batch_get_size (struct Sass_Batch* batch);
+ADDAPI size_t ADDCALL sass_batch_get_compiled_size (struct Sass_Batch* batch);
+ADDAPI size_t ADDCALL sass_batch_get_compiled (struct Sass_Batch* batch, size_t idx);
+ADDAPI int ADDCALL sass_compile_batch (struct Sass_Batch* batch, int threads);
+ADDAPI int ADDCALL sass_batch_recompile (struct Sass_Batch* batch, const char** changed, int threads);
+ADDAPI void ADDCALL sass_delete_batch (struct Sass_Batch* batch);
+
 // Getters for context from specific implementation
 ADDAPI struct Sass_Context* ADDCALL sass_file_context_get_context (struct Sass_File_Context* file_ctx);
 ADDAPI struct Sass_Context* ADDCALL sass_data_context_get_context (struct Sass_Data_Context* data_ctx);
@@ -86,6 +149,10 @@ ADDAPI const char* ADDCALL sass_option_get_source_map_root (struct Sass_Options*
 ADDAPI Sass_Importer_List ADDCALL sass_option_get_c_headers (struct Sass_Options* options);
 ADDAPI Sass_Importer_List ADDCALL sass_option_get_c_importers (struct Sass_Options* options);
 ADDAPI Sass_Function_List ADDCALL sass_option_get_c_functions (struct Sass_Options* options);
+ADDAPI struct Sass_Sheet_Cache* ADDCALL sass_option_get_sheet_cache (struct Sass_Options* options);
+ADDAPI int ADDCALL sass_option_get_import_threads (struct Sass_Options* options);
+ADDAPI Sass_Output_Sink_Fn ADDCALL sass_option_get_output_sink (struct Sass_Options* options);
+ADDAPI void* ADDCALL sass_option_get_output_sink_cookie (struct Sass_Options* options);
 
 // Setters for Context_Option values
 ADDAPI void ADDCALL sass_option_set_precision (struct Sass_Options* options, int precision);
@@ -107,6 +174,10 @@ ADDAPI void ADDCALL sass_option_set_source_map_root (struct Sass_Options* option
 ADDAPI void ADDCALL sass_option_set_c_headers (struct Sass_Options* options, Sass_Importer_List c_headers);
 ADDAPI void ADDCALL sass_option_set_c_importers (struct Sass_Options* options, Sass_Importer_List c_importers);
 ADDAPI void ADDCALL sass_option_set_c_functions (struct Sass_Options* options, Sass_Function_List c_functions);
+ADDAPI void ADDCALL sass_option_set_sheet_cache (struct Sass_Options* options, struct Sass_Sheet_Cache* sheet_cache);
+ADDAPI void ADDCALL sass_option_set_import_threads (struct Sass_Options* options, int import_threads);
+ADDAPI void ADDCALL sass_option_set_output_sink (struct Sass_Options* options, Sass_Output_Sink_Fn output_sink);
+ADDAPI void ADDCALL sass_option_set_output_sink_cookie (struct Sass_Options* options, void* output_sink_cookie);
 
 
 // Getters for Sass_Context values
@@ -129,6 +200,22 @@ ADDAPI const char* ADDCALL sass_option_get_include_path(struct Sass_Options* opt
 // Calculate the size of the stored null terminated array
 ADDAPI size_t ADDCALL sass_context_get_included_files_size (struct Sass_Context* ctx);
 
+// Find the origin of a position in the generated css (all zero based, columns
+// in characters). Uses the closest mapping at or before it on the same line.
+// Only works for compilations with a source map, the source is the link used
+// in the map and is owned by the context.
+ADDAPI bool ADDCALL sass_context_find_source_position (struct Sass_Context* ctx, size_t line, size_t column, const char** source, size_t* source_line, size_t* source_column);
+// Copy the mappings of the source map (in the order of the css) to merge
+// maps without parsing the json. Copies at most `size` mappings and returns
+// how many there are; sources are looked up by index (null when invalid).
+ADDAPI size_t ADDCALL sass_context_get_source_mappings (struct Sass_Context* ctx, struct Sass_Source_Mapping* mappings, size_t size);
+ADDAPI const char* ADDCALL sass_context_get_source_map_source (struct Sass_Context* ctx, size_t index);
+// Generated selectors (interpolated or passed to selector functions) and
+// media queries parsed by the compilation are cached by their text; these
+// count the reused and the newly parsed ones.
+ADDAPI size_t ADDCALL sass_context_get_parse_cache_hits (struct Sass_Context* ctx);
+ADDAPI size_t ADDCALL sass_context_get_parse_cache_misses (struct Sass_Context* ctx);
+
 // Take ownership of memory (value on context is set to 0)
 ADDAPI char* ADDCALL sass_context_take_error_json (struct Sass_Context* ctx);
 ADDAPI char* ADDCALL sass_context_take_error_text (struct Sass_Context* ctx);
@@ -130,6 +130,18 @@ ADDAPI void ADDCALL sass_function_set_list_entry(Sass_Function_List list, size_t
 ADDAPI const char* ADDCALL sass_function_get_signature (Sass_Function_Entry cb);
 ADDAPI Sass_Function_Fn ADDCALL sass_function_get_function (Sass_Function_Entry cb);
 ADDAPI void* ADDCALL sass_function_get_cookie (Sass_Function_Entry cb);
+ADDAPI bool ADDCALL sass_function_get_pure (Sass_Function_Entry cb);
+ADDAPI bool ADDCALL sass_function_get_batched (Sass_Function_Entry cb);
+
+// Pure functions only depend on their arguments, each compilation
+// calls them once per distinct arguments and reuses the result
+ADDAPI void ADDCALL sass_function_set_pure (Sass_Function_Entry cb, bool pure);
+
+// Batched functions get a list of argument lists (one per call) and
+// return a list with one result per call, in the same order. Calls in
+// a loop body are collected for all iterations and passed at once,
+// so results must not depend on the order of the calls.
+ADDAPI void ADDCALL sass_function_set_batched (Sass_Function_Entry cb, bool batched);
 
 
 #ifdef __cplusplus
@@ -9,13 +9,13 @@ namespace Sass {
 
 
   Node Node::createCombinator(const Complex_Selector::Combinator& combinator) {
-    NodeDequePtr null;
+    NodeCollectionPtr null;
     return Node(COMBINATOR, combinator, NULL /*pSelector*/, null /*pCollection*/);
   }
 
 
   Node Node::createSelector(const Complex_Selector& pSelector) {
-    NodeDequePtr null;
+    NodeCollectionPtr null;
 
     Complex_Selector_Ptr pStripped = SASS_MEMORY_COPY(&pSelector);
     pStripped->tail(NULL);
@@ -28,32 +28,33 @@ namespace Sass {
 
 
   Node Node::createCollection() {
-    NodeDequePtr pEmptyCollection = std::make_shared<NodeDeque>();
+    NodeCollectionPtr pEmptyCollection = NodeCollectionPtr::create();
     return Node(COLLECTION, Complex_Selector::ANCESTOR_OF, NULL /*pSelector*/, pEmptyCollection);
   }
 
 
-  Node Node::createCollection(const NodeDeque& values) {
-    NodeDequePtr pShallowCopiedCollection = std::make_shared<NodeDeque>(values);
+  Node Node::createCollection(const NodeCollection& values) {
+    NodeCollectionPtr pShallowCopiedCollection = NodeCollectionPtr::create(values);
     return Node(COLLECTION, Complex_Selector::ANCESTOR_OF, NULL /*pSelector*/, pShallowCopiedCollection);
   }
 
 
   Node Node::createNil() {
-    NodeDequePtr null;
+    NodeCollectionPtr null;
     return Node(NIL, Complex_Selector::ANCESTOR_OF, NULL /*pSelector*/, null /*pCollection*/);
   }
 
 
-  Node::Node(const TYPE& type, Complex_Selector::Combinator combinator, Complex_Selector_Ptr pSelector, NodeDequePtr& pCollection)
+  Node::Node(const TYPE& type, Complex_Selector::Combinator combinator, Complex_Selector_Ptr pSelector, const NodeCollectionPtr& pCollection)
   : got_line_feed(false), mType(type), mCombinator(combinator), mpSelector(pSelector), mpCollection(pCollection)
   { if (pSelector) got_line_feed = pSelector->has_line_feed(); }
 
 
   Node Node::klone() const {
-    NodeDequePtr pNewCollection = std::make_shared<NodeDeque>();
+    NodeCollectionPtr pNewCollection = NodeCollectionPtr::create();
     if (mpCollection) {
-      for (NodeDeque::iterator iter = mpCollection->begin(), iterEnd = mpCollection->end(); iter != iterEnd; iter++) {
+      pNewCollection->reserve(mpCollection->size());
+      for (NodeCollection::iterator iter = mpCollection->begin(), iterEnd = mpCollection->end(); iter != iterEnd; iter++) {
         Node& toClone = *iter;
         pNewCollection->push_back(toClone.klone());
       }
@@ -68,7 +69,7 @@ namespace Sass {
   bool Node::contains(const Node& potentialChild) const {
     bool found = false;
 
-    for (NodeDeque::iterator iter = mpCollection->begin(), iterEnd = mpCollection->end(); iter != iterEnd; iter++) {
+    for (NodeCollection::iterator iter = mpCollection->begin(), iterEnd = mpCollection->end(); iter != iterEnd; iter++) {
       Node& toTest = *iter;
 
       if (toTest == potentialChild) {
@@ -104,7 +105,7 @@ namespace Sass {
         return false;
       }
 
-      for (NodeDeque::iterator lhsIter = this->collection()->begin(), lhsIterEnd = this->collection()->end(),
+      for (NodeCollection::iterator lhsIter = this->collection()->begin(), lhsIterEnd = this->collection()->end(),
            rhsIter = rhs.collection()->begin(); lhsIter != lhsIterEnd; lhsIter++, rhsIter++) {
 
         if (*lhsIter != *rhsIter) {
@@ -154,7 +155,7 @@ namespace Sass {
 
       os << "[";
 
-      for (NodeDeque::iterator iter = node.collection()->begin(), iterBegin = node.collection()->begin(), iterEnd = node.collection()->end(); iter != iterEnd; iter++) {
+      for (NodeCollection::iterator iter = node.collection()->begin(), iterBegin = node.collection()->begin(), iterEnd = node.collection()->end(); iter != iterEnd; iter++) {
         if (iter != iterBegin) {
           os << ", ";
         }
@@ -231,7 +232,7 @@ namespace Sass {
     }
 
 
-    NodeDeque& childNodes = *toConvert.collection();
+    NodeCollection& childNodes = *toConvert.collection();
 
     std::string noPath("");
     Complex_Selector_Obj pFirst = SASS_MEMORY_NEW(Complex_Selector, ParserState("[NODE]"), Complex_Selector::ANCESTOR_OF, NULL, NULL);
@@ -241,7 +242,7 @@ namespace Sass {
     if (toConvert.isSelector()) pFirst->has_line_feed(toConvert.got_line_feed);
     if (toConvert.isCombinator()) pFirst->has_line_feed(toConvert.got_line_feed);
 
-    for (NodeDeque::iterator childIter = childNodes.begin(), childIterEnd = childNodes.end(); childIter != childIterEnd; childIter++) {
+    for (NodeCollection::iterator childIter = childNodes.begin(), childIterEnd = childNodes.end(); childIter != childIterEnd; childIter++) {
 
       Node& child = *childIter;
 
@@ -286,7 +287,7 @@ namespace Sass {
     std::vector<Node*> res;
     std::vector<Complex_Selector_Obj> known;
 
-    NodeDeque::reverse_iterator seqsesIter = seqses.collection()->rbegin(),
+    NodeCollection::reverse_iterator seqsesIter = seqses.collection()->rbegin(),
                                 seqsesIterEnd = seqses.collection()->rend();
 
     for (; seqsesIter != seqsesIterEnd; ++seqsesIter)
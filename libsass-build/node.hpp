@@ -1,8 +1,8 @@
 #ifndef SASS_NODE_H
 #define SASS_NODE_H
 
-#include <deque>
-#include <memory>
+#include <vector>
+#include <cstddef>
 
 #include "ast.hpp"
 
@@ -31,8 +31,35 @@ namespace Sass {
    */
 
   class Node;
-  typedef std::deque<Node> NodeDeque;
-  typedef std::shared_ptr<NodeDeque> NodeDequePtr;
+  class NodeCollection;
+
+  // Shared handle to a node collection. Collections never leave
+  // the thread running the extend, so the count is not atomic.
+  class NodeCollectionPtr {
+  public:
+    NodeCollectionPtr() : mpCollection(NULL) {}
+    NodeCollectionPtr(const NodeCollectionPtr& other) : mpCollection(other.mpCollection) { retain(); }
+    NodeCollectionPtr(NodeCollectionPtr&& other) : mpCollection(other.mpCollection) { other.mpCollection = NULL; }
+    ~NodeCollectionPtr() { release(); }
+    NodeCollectionPtr& operator=(const NodeCollectionPtr& other);
+    NodeCollectionPtr& operator=(NodeCollectionPtr&& other);
+
+    // new empty collection or a shallow copy of the given one
+    static NodeCollectionPtr create();
+    static NodeCollectionPtr create(const NodeCollection& values);
+
+    NodeCollection* operator->() const { return mpCollection; }
+    NodeCollection& operator*() const { return *mpCollection; }
+    explicit operator bool() const { return mpCollection != NULL; }
+    bool operator==(const NodeCollectionPtr& rhs) const { return mpCollection == rhs.mpCollection; }
+    bool operator!=(const NodeCollectionPtr& rhs) const { return mpCollection != rhs.mpCollection; }
+
+  private:
+    explicit NodeCollectionPtr(NodeCollection* pCollection) : mpCollection(pCollection) {}
+    inline void retain();
+    inline void release();
+    NodeCollection* mpCollection;
+  };
 
   class Node {
   public:
@@ -55,8 +82,7 @@ namespace Sass {
     Complex_Selector_Obj selector() { return mpSelector; }
     Complex_Selector_Obj selector() const { return mpSelector; }
 
-    NodeDequePtr collection() { return mpCollection; }
-    const NodeDequePtr collection() const { return mpCollection; }
+    const NodeCollectionPtr& collection() const { return mpCollection; }
 
     static Node createCombinator(const Complex_Selector::Combinator& combinator);
 
@@ -64,7 +90,7 @@ namespace Sass {
     static Node createSelector(const Complex_Selector& pSelector);
 
     static Node createCollection();
-    static Node createCollection(const NodeDeque& values);
+    static Node createCollection(const NodeCollection& values);
 
     static Node createNil();
     static Node naiveTrim(Node& seqses);
@@ -97,16 +123,104 @@ namespace Sass {
     // Private constructor; Use the static methods (like createCombinator and createSelector)
     // to instantiate this object. This is more expressive, and it allows us to break apart each
     // case into separate functions.
-    Node(const TYPE& type, Complex_Selector::Combinator combinator, Complex_Selector_Ptr pSelector, NodeDequePtr& pCollection);
+    Node(const TYPE& type, Complex_Selector::Combinator combinator, Complex_Selector_Ptr pSelector, const NodeCollectionPtr& pCollection);
 
     TYPE mType;
 
     // TODO: can we union these to save on memory?
     Complex_Selector::Combinator mCombinator;
     Complex_Selector_Obj mpSelector;
-    NodeDequePtr mpCollection;
+    NodeCollectionPtr mpCollection;
   };
 
+  // Flat, contiguous collection of nodes. The ruby code mostly
+  // appends, the collections we prepend to are only a few items.
+  class NodeCollection {
+  public:
+    typedef std::vector<Node> Nodes;
+    typedef Nodes::iterator iterator;
+    typedef Nodes::const_iterator const_iterator;
+    typedef Nodes::reverse_iterator reverse_iterator;
+
+    NodeCollection() : mRefs(0), mNodes() {}
+    NodeCollection(const NodeCollection& other) : mRefs(0), mNodes(other.mNodes) {}
+
+    iterator begin() { return mNodes.begin(); }
+    iterator end() { return mNodes.end(); }
+    const_iterator begin() const { return mNodes.begin(); }
+    const_iterator end() const { return mNodes.end(); }
+    reverse_iterator rbegin() { return mNodes.rbegin(); }
+    reverse_iterator rend() { return mNodes.rend(); }
+
+    size_t size() const { return mNodes.size(); }
+    bool empty() const { return mNodes.empty(); }
+    void reserve(size_t size) { mNodes.reserve(size); }
+
+    Node& operator[](size_t i) { return mNodes[i]; }
+    const Node& operator[](size_t i) const { return mNodes[i]; }
+    Node& front() { return mNodes.front(); }
+    Node& back() { return mNodes.back(); }
+
+    void push_back(const Node& node) { mNodes.push_back(node); }
+    void push_front(const Node& node) { mNodes.insert(mNodes.begin(), node); }
+    void pop_back() { mNodes.pop_back(); }
+    void pop_front() { mNodes.erase(mNodes.begin()); }
+    template <typename InputIterator>
+    void insert(iterator pos, InputIterator first, InputIterator last) { mNodes.insert(pos, first, last); }
+
+  private:
+    friend class NodeCollectionPtr;
+    size_t mRefs;
+    Nodes mNodes;
+  };
+
+  inline void NodeCollectionPtr::retain()
+  {
+    if (mpCollection) ++ mpCollection->mRefs;
+  }
+
+  inline void NodeCollectionPtr::release()
+  {
+    NodeCollection* pCollection = mpCollection;
+    mpCollection = NULL;
+    if (pCollection && -- pCollection->mRefs == 0) delete pCollection;
+  }
+
+  inline NodeCollectionPtr& NodeCollectionPtr::operator=(const NodeCollectionPtr& other)
+  {
+    // the other handle may live in our collection
+    NodeCollection* pCollection = other.mpCollection;
+    if (pCollection) ++ pCollection->mRefs;
+    release();
+    mpCollection = pCollection;
+    return *this;
+  }
+
+  inline NodeCollectionPtr& NodeCollectionPtr::operator=(NodeCollectionPtr&& other)
+  {
+    if (this != &other) {
+      NodeCollection* pCollection = other.mpCollection;
+      other.mpCollection = NULL;
+      release();
+      mpCollection = pCollection;
+    }
+    return *this;
+  }
+
+  inline NodeCollectionPtr NodeCollectionPtr::create()
+  {
+    NodeCollection* pCollection = new NodeCollection();
+    ++ pCollection->mRefs;
+    return NodeCollectionPtr(pCollection);
+  }
+
+  inline NodeCollectionPtr NodeCollectionPtr::create(const NodeCollection& values)
+  {
+    NodeCollection* pCollection = new NodeCollection(values);
+    ++ pCollection->mRefs;
+    return NodeCollectionPtr(pCollection);
+  }
+
 #ifdef DEBUG
   std::ostream& operator<<(std::ostream& os, const Node& node);
 #endif
@@ -182,22 +182,14 @@ namespace Sass {
 
       if (op == Sass_OP::MUL) {
         v->value(ops[op](lval, rval));
-        v->numerators.insert(v->numerators.end(),
-          rhs.numerators.begin(), rhs.numerators.end()
-        );
-        v->denominators.insert(v->denominators.end(),
-          rhs.denominators.begin(), rhs.denominators.end()
-        );
+        v->numerators.append(rhs.numerators);
+        v->denominators.append(rhs.denominators);
         v->reduce();
       }
       else if (op == Sass_OP::DIV) {
         v->value(ops[op](lval, rval));
-        v->numerators.insert(v->numerators.end(),
-          rhs.denominators.begin(), rhs.denominators.end()
-        );
-        v->denominators.insert(v->denominators.end(),
-          rhs.numerators.begin(), rhs.numerators.end()
-        );
+        v->numerators.append(rhs.denominators);
+        v->denominators.append(rhs.numerators);
         v->reduce();
       }
       else {
@@ -7,7 +7,8 @@ namespace Sass {
   Output::Output(Sass_Output_Options& opt)
   : Inspect(Emitter(opt)),
     charset(""),
-    top_nodes(0)
+    top_nodes(0),
+    prefix_size(0)
   {}
 
   Output::~Output() { }
@@ -42,10 +43,11 @@ namespace Sass {
     throw Exception::InvalidValue({}, *m);
   }
 
-  OutputBuffer Output::get_buffer(void)
+  const OutputBuffer& Output::get_buffer(void)
   {
 
     Emitter emitter(opt);
+    emitter.source_mapping = source_mapping;
     Inspect inspect(emitter);
 
     size_t size_nodes = top_nodes.size();
@@ -86,13 +88,76 @@ namespace Sass {
 
   }
 
+  // only looks for unicode chars
+  class Unicode_Probe : public Output_Sink {
+    public:
+      bool found;
+      Unicode_Probe() : found(false) { }
+      void write(const char* chunk, size_t length)
+      {
+        for (size_t i = 0; i < length && !found; ++i)
+          found = static_cast<unsigned char>(chunk[i]) >= 128;
+      }
+  };
+
+  // same output as `get_buffer`, but the nodes hoisted to the
+  // top and the charset must be known before the first chunk
+  // is written, a dry run without any buffer finds them first
+  void Output::stream(Block_Ptr root, Output_Sink* out)
+  {
+    Unicode_Probe probe;
+    Output dry(opt);
+    dry.sink = &probe;
+    root->perform(&dry);
+    dry.finalize();
+    dry.flush_buffer(true);
+
+    Emitter emitter(opt);
+    emitter.source_mapping = source_mapping;
+    Inspect inspect(emitter);
+
+    size_t size_nodes = dry.top_nodes.size();
+    for (size_t i = 0; i < size_nodes; i++) {
+      dry.top_nodes[i]->perform(&inspect);
+      inspect.append_mandatory_linefeed();
+    }
+
+    // maybe omit semicolon if possible
+    inspect.finalize(dry.output_size() == 0);
+    probe.write(inspect.buffer().data(), inspect.buffer().size());
+    // start with the nodes on top
+    prepend_output(inspect.output());
+
+    // declare the charset
+    if (probe.found) {
+      if (output_style() != COMPRESSED)
+        charset = "@charset \"UTF-8\";"
+                + std::string(opt.linefeed);
+      else charset = "\xEF\xBB\xBF";
+      prepend_string(charset);
+    }
+
+    // nodes seen before this are already on top
+    prefix_size = output_size();
+    sink = out;
+    root->perform(this);
+    finalize();
+
+    // make sure we end with a linefeed
+    if (!ends_with(wbuf.buffer, opt.linefeed)) {
+      // if the output is not completely empty
+      if (output_size() != 0) append_string(opt.linefeed);
+    }
+
+  }
+
   void Output::operator()(Comment_Ptr c)
   {
     std::string txt = c->text()->to_string(opt);
     // if (indentation && txt == "/**/") return;
     bool important = c->is_important();
     if (output_style() != COMPRESSED || important) {
-      if (buffer().size() == 0) {
+      if (output_size() == prefix_size) {
         top_nodes.push_back(c);
       } else {
         in_comment = true;
@@ -29,9 +29,13 @@ namespace Sass {
   protected:
     std::string charset;
     std::vector<AST_Node_Ptr> top_nodes;
+    // size of the hoisted nodes when streaming
+    size_t prefix_size;
 
   public:
-    OutputBuffer get_buffer(void);
+    const OutputBuffer& get_buffer(void);
+    // render the tree straight into the sink
+    void stream(Block_Ptr root, Output_Sink* out);
 
     virtual void operator()(Map_Ptr);
     virtual void operator()(Ruleset_Ptr);
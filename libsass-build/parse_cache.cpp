@@ -0,0 +1,180 @@
+#include "sass.hpp"
+
+#include "ast.hpp"
+#include "parser.hpp"
+#include "prelexer.hpp"
+#include "parse_cache.hpp"
+
+namespace Sass {
+
+  // moves a node parsed at one position into the given source,
+  // nodes made before anything was lexed have the outer token
+  static void place_node(AST_Node_Ptr node, const ParserState& from, const ParserState& to)
+  {
+    const ParserState& pstate(node->pstate());
+    bool outer = pstate.token.begin == from.token.begin && pstate.token.end == from.token.end;
+    const Token& token(outer ? to.token : pstate.token);
+    node->pstate(ParserState(to.path, to.src, token, to + (pstate - from), pstate.offset));
+  }
+
+  // Moves every node of a deep copy, the nodes the parser put into
+  // a media block go into the given one. Values the copy still shares
+  // with the cached selector are copied first.
+  static void place_selector(Selector_Ptr s, const ParserState& from, const ParserState& to, Media_Block_Ptr media_block)
+  {
+    if (!s) return;
+    place_node(s, from, to);
+    if (s->media_block()) s->media_block(media_block);
+    if (Selector_List_Ptr list = Cast<Selector_List>(s)) {
+      for (Complex_Selector_Obj complex : list->elements()) {
+        place_selector(complex, from, to, media_block);
+      }
+    }
+    else if (Complex_Selector_Ptr complex = Cast<Complex_Selector>(s)) {
+      if (complex->reference()) {
+        complex->reference(SASS_MEMORY_CLONE(complex->reference()));
+        place_node(complex->reference(), from, to);
+      }
+      place_selector(complex->head(), from, to, media_block);
+      place_selector(complex->tail(), from, to, media_block);
+    }
+    else if (Compound_Selector_Ptr compound = Cast<Compound_Selector>(s)) {
+      for (Simple_Selector_Obj simple : compound->elements()) {
+        place_selector(simple, from, to, media_block);
+      }
+    }
+    else if (Wrapped_Selector_Ptr wrapped = Cast<Wrapped_Selector>(s)) {
+      place_selector(wrapped->selector(), from, to, media_block);
+    }
+    else if (Attribute_Selector_Ptr attribute = Cast<Attribute_Selector>(s)) {
+      if (attribute->value()) {
+        attribute->value(SASS_MEMORY_CLONE(attribute->value()));
+        place_node(attribute->value(), from, to);
+      }
+    }
+    else if (Pseudo_Selector_Ptr pseudo = Cast<Pseudo_Selector>(s)) {
+      if (pseudo->expression()) {
+        pseudo->expression(SASS_MEMORY_CLONE(pseudo->expression()));
+        place_node(pseudo->expression(), from, to);
+      }
+    }
+  }
+
+  // A single class (like `.block__element` from a BEM mixin) is put
+  // together directly, with the same nodes, flags and positions the
+  // parser would give it. Returns null for anything else.
+  static Selector_List_Obj parse_class_selector(const std::string& text, ParserState pstate, Media_Block_Ptr media_block, bool chroot)
+  {
+    const char* beg = text.c_str();
+    const char* end = beg + text.size();
+    if (Prelexer::class_name(beg) != end) return 0;
+    pstate.offset = Offset(0, 0);
+    Position after(pstate);
+    after.add(beg, end);
+    Token token(beg, beg, end);
+    ParserState lexed(pstate.path, beg, token, pstate, after - pstate);
+    // where the parser stops
+    ParserState last(pstate.path, beg, token, after);
+
+    Compound_Selector_Obj compound = SASS_MEMORY_NEW(Compound_Selector, pstate);
+    compound->media_block(media_block);
+    compound->append(SASS_MEMORY_NEW(Class_Selector, lexed, text));
+    Complex_Selector_Obj complex = SASS_MEMORY_NEW(Complex_Selector, pstate, Complex_Selector::ANCESTOR_OF, compound);
+    complex->media_block(media_block);
+    // add the implicit parent reference
+    if (!chroot) {
+      Compound_Selector_Obj head = SASS_MEMORY_NEW(Compound_Selector, last);
+      Parent_Selector_Ptr parent = SASS_MEMORY_NEW(Parent_Selector, last, false);
+      parent->media_block(media_block);
+      head->media_block(media_block);
+      head->append(parent);
+      complex = SASS_MEMORY_NEW(Complex_Selector, last, Complex_Selector::ANCESTOR_OF, head, complex);
+      complex->media_block(media_block);
+    }
+    complex->update_pstate(last);
+
+    Selector_List_Obj list = SASS_MEMORY_NEW(Selector_List, pstate);
+    list->media_block(media_block);
+    list->append(complex);
+    list->update_pstate(last);
+    return list;
+  }
+
+  Parse_Cache::Parse_Cache()
+  : selectors(), media_queries(), hits(0), misses(0)
+  { }
+
+  Parse_Cache::~Parse_Cache()
+  { }
+
+  Selector_List_Obj Parse_Cache::parse_selector_list(Context& ctx, const Backtraces& traces, const std::string& text, ParserState pstate, Media_Block_Ptr media_block, bool chroot)
+  {
+    auto it = selectors.find(text);
+    if (it == selectors.end()) {
+      it = selectors.insert(std::make_pair(text, std::vector<Parsed>())).first;
+    }
+    // at most one per combination of the flags
+    bool in_media = media_block != 0;
+    Parsed* parsed = 0;
+    for (Parsed& variant : it->second) {
+      if (variant.in_media == in_media && variant.chroot == chroot) {
+        parsed = &variant;
+        break;
+      }
+    }
+    if (parsed) ++ hits;
+    else {
+      ++ misses;
+      // parse our own copy of the text
+      const std::string& source(it->first);
+      Selector_List_Obj sl = parse_class_selector(source, pstate, media_block, chroot);
+      if (!sl) {
+        Parser p = Parser::from_c_str(source.c_str(), ctx, traces, pstate);
+        p.last_media_block = media_block;
+        sl = p.parse_selector_list(chroot);
+      }
+      Parsed variant = { in_media, chroot, pstate, sl };
+      it->second.push_back(variant);
+      parsed = &it->second.back();
+    }
+    Selector_List_Obj copy = SASS_MEMORY_CLONE(parsed->selector);
+    place_selector(copy, parsed->pstate, pstate, media_block);
+    return copy;
+  }
+
+  Selector_List_Obj Parse_Cache::parse_selector(Context& ctx, const Backtraces& traces, const std::string& text)
+  {
+    return parse_selector_list(ctx, traces, text, ParserState("[SELECTOR]"), 0, false);
+  }
+
+  List_Obj Parse_Cache::parse_media_queries(Context& ctx, const Backtraces& traces, const std::string& text, const ParserState& pstate)
+  {
+    auto it = media_queries.find(text);
+    if (it == media_queries.end()) {
+      it = media_queries.insert(std::make_pair(text, std::vector<Queries>())).first;
+    }
+    for (const Queries& variant : it->second) {
+      const ParserState& parsed(variant.pstate);
+      if (parsed == pstate && parsed.path == pstate.path && parsed.src == pstate.src) {
+        ++ hits;
+        return variant.queries;
+      }
+    }
+    ++ misses;
+    Parser p(Parser::from_c_str(it->first.c_str(), ctx, traces, pstate));
+    Queries variant = { pstate, p.parse_media_queries() };
+    it->second.push_back(variant);
+    return variant.queries;
+  }
+
+  size_t Parse_Cache::get_hits() const
+  {
+    return hits;
+  }
+
+  size_t Parse_Cache::get_misses() const
+  {
+    return misses;
+  }
+
+}
@@ -0,0 +1,61 @@
+#ifndef SASS_PARSE_CACHE_H
+#define SASS_PARSE_CACHE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "ast_fwd_decl.hpp"
+#include "backtrace.hpp"
+#include "position.hpp"
+
+namespace Sass {
+
+  // Selectors and media queries parsed from generated text (after
+  // interpolation or passed to selector functions), kept for one
+  // context. The cache owns the texts (the tokens of the parsed
+  // nodes point into them). The same selector parses differently
+  // within a media block or when it is not connected to its parent,
+  // so these are part of the key. Every selector lookup returns a
+  // copy moved to the position and into the media block of the
+  // requested source, callers may change it freely. Media queries
+  // are shared instead and must not be changed, they are only reused
+  // for the position they were parsed at (media blocks in mixins
+  // and loops).
+  class Parse_Cache {
+  private:
+    struct Parsed {
+      bool in_media;
+      bool chroot;
+      // where the text was parsed
+      ParserState pstate;
+      Selector_List_Obj selector;
+    };
+    struct Queries {
+      ParserState pstate;
+      List_Obj queries;
+    };
+    std::unordered_map<std::string, std::vector<Parsed>> selectors;
+    std::unordered_map<std::string, std::vector<Queries>> media_queries;
+    size_t hits;
+    size_t misses;
+
+  public:
+    Parse_Cache();
+    ~Parse_Cache();
+
+    // same result as `Parser::parse_selector_list` on the text
+    Selector_List_Obj parse_selector_list(Context& ctx, const Backtraces& traces, const std::string& text, ParserState pstate, Media_Block_Ptr media_block, bool chroot);
+    // same result as `Parser::parse_selector` on the text
+    Selector_List_Obj parse_selector(Context& ctx, const Backtraces& traces, const std::string& text);
+    // same result as `Parser::parse_media_queries` on the text
+    List_Obj parse_media_queries(Context& ctx, const Backtraces& traces, const std::string& text, const ParserState& pstate);
+
+    size_t get_hits() const;
+    size_t get_misses() const;
+
+  };
+
+}
+
+#endif
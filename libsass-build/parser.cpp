@@ -113,7 +113,7 @@ namespace Sass {
     Block_Obj root = SASS_MEMORY_NEW(Block, pstate, 0, true);
 
     // check seems a bit esoteric but works
-    if (ctx.resources.size() == 1) {
+    if (!deferred_imports && ctx.resources.size() == 1) {
       // apply headers only on very first include
       ctx.apply_custom_headers(root, path, pstate);
     }
@@ -247,8 +247,10 @@ namespace Sass {
       // this puts the parsed doc into sheets
       // import stub will fetch this in expand
       Import_Obj imp = parse_import();
+      // placeholder until the context loads the imports
+      if (deferred_imports) block->append(imp);
       // if it is a url, we only add the statement
-      if (!imp->urls().empty()) block->append(imp);
+      else if (!imp->urls().empty()) block->append(imp);
       // process all resources now (add Import_Stub nodes)
       for (size_t i = 0, S = imp->incs().size(); i < S; ++i) {
         block->append(SASS_MEMORY_NEW(Import_Stub, pstate, imp->incs()[i]));
@@ -368,16 +370,11 @@ namespace Sass {
       imp->import_queries(import_queries);
     }
 
-    for(auto location : to_import) {
-      if (location.second) {
-        imp->urls().push_back(location.second);
-      }
-      // check if custom importers want to take over the handling
-      else if (!ctx.call_importers(unquote(location.first), path, pstate, imp)) {
-        // nobody wants it, so we do our import
-        ctx.import_url(imp, location.first, path);
-      }
+    // imports of sheets parsed ahead of time are loaded later
+    if (deferred_imports) {
+      deferred_imports->push_back({ imp, block_stack.back(), to_import, pstate });
     }
+    else ctx.import_locations(imp, to_import, path, pstate);
 
     return imp;
   }
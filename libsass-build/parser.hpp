@@ -48,13 +48,16 @@ namespace Sass {
     Backtraces traces;
     size_t indentation;
     size_t nestings;
+    // set when parsing ahead of time (see Import_Prefetch)
+    // imports are only collected and loaded by the context
+    std::vector<Deferred_Import>* deferred_imports;
 
     Token lexed;
 
     Parser(Context& ctx, const ParserState& pstate, Backtraces traces)
     : ParserState(pstate), ctx(ctx), block_stack(), stack(0), last_media_block(),
       source(0), position(0), end(0), before_token(pstate), after_token(pstate),
-      pstate(pstate), traces(traces), indentation(0), nestings(0)
+      pstate(pstate), traces(traces), indentation(0), nestings(0), deferred_imports(0)
     { 
       stack.push_back(Scope::Root);
     }
@@ -1,8 +1,11 @@
 #include "sass.hpp"
+#include <atomic>
 #include <cstring>
 #include <stdexcept>
 #include <sstream>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <vector>
 
 #include "sass.h"
@@ -396,7 +399,10 @@ extern "C" {
 
   Sass_File_Context* ADDCALL sass_make_file_context(const char* input_path)
   {
+    // only read by the (single threaded) leak tracker
+    #ifdef DEBUG_SHARED_PTR
     SharedObj::setTaint(true); // needed for static colors
+    #endif
     struct Sass_File_Context* ctx = (struct Sass_File_Context*) calloc(1, sizeof(struct Sass_File_Context));
     if (ctx == 0) { std::cerr << "Error allocating memory for file context" << std::endl; return 0; }
     ctx->type = SASS_CONTEXT_FILE;
@@ -504,6 +510,11 @@ extern "C" {
     catch (...) { return handle_errors(compiler->c_ctx) | 1; }
     // generate source map json and store on context
     compiler->c_ctx->source_map_string = cpp_ctx->render_srcmap();
+    // keep the mappings to query them later on
+    delete compiler->c_ctx->source_map;
+    compiler->c_ctx->source_map = cpp_ctx->take_source_map();
+    compiler->c_ctx->parse_cache_hits = cpp_ctx->parse_cache.get_hits();
+    compiler->c_ctx->parse_cache_misses = cpp_ctx->parse_cache.get_misses();
     // success
     return 0;
   }
@@ -524,6 +535,7 @@ extern "C" {
     options->c_headers = 0;
     options->plugin_paths = 0;
     options->include_paths = 0;
+    options->sheet_cache = 0;
   }
 
   // helper function, not exported, only accessible locally
@@ -577,13 +589,13 @@ extern "C" {
     options->c_headers = 0;
     options->plugin_paths = 0;
     options->include_paths = 0;
+    options->sheet_cache = 0;
   }
 
   // helper function, not exported, only accessible locally
   // sass_free_context is also defined in old sass_interface
-  static void sass_clear_context (struct Sass_Context* ctx)
+  static void sass_clear_results (struct Sass_Context* ctx)
   {
-    if (ctx == 0) return;
     // release the allocated memory (mostly via sass_copy_c_string)
     if (ctx->output_string)     free(ctx->output_string);
     if (ctx->source_map_string) free(ctx->source_map_string);
@@ -592,6 +604,7 @@ extern "C" {
     if (ctx->error_json)        free(ctx->error_json);
     if (ctx->error_file)        free(ctx->error_file);
     free_string_array(ctx->included_files);
+    delete ctx->source_map;
     // play safe and reset properties
     ctx->output_string = 0;
     ctx->source_map_string = 0;
@@ -600,6 +613,18 @@ extern "C" {
     ctx->error_json = 0;
     ctx->error_file = 0;
     ctx->included_files = 0;
+    ctx->source_map = 0;
+    ctx->parse_cache_hits = 0;
+    ctx->parse_cache_misses = 0;
+    ctx->error_status = 0;
+  }
+
+  // helper function, not exported, only accessible locally
+  // sass_free_context is also defined in old sass_interface
+  static void sass_clear_context (struct Sass_Context* ctx)
+  {
+    if (ctx == 0) return;
+    sass_clear_results(ctx);
     // debug leaked memory
     #ifdef DEBUG_SHARED_PTR
       SharedObj::dumpMemLeaks();
@@ -614,10 +639,11 @@ extern "C" {
       return;
     }
     Context* cpp_ctx = compiler->cpp_ctx;
+    // must be gone before cached sheets are released
+    compiler->root = NULL;
     if (cpp_ctx) delete(cpp_ctx);
     compiler->cpp_ctx = NULL;
     compiler->c_ctx = NULL;
-    compiler->root = NULL;
     free(compiler);
   }
 
@@ -642,6 +668,142 @@ extern "C" {
     sass_clear_context(ctx); free(ctx);
   }
 
+  // entries keep their own paths and sink, the rest is
+  // borrowed from the batch options while compiling
+  static void sass_share_options (struct Sass_Options* to, struct Sass_Options* from)
+  {
+    char* input_path = to->input_path;
+    char* output_path = to->output_path;
+    char* source_map_file = to->source_map_file;
+    Sass_Output_Sink_Fn output_sink = to->output_sink;
+    void* output_sink_cookie = to->output_sink_cookie;
+    *to = *from;
+    to->input_path = input_path;
+    to->output_path = output_path;
+    to->source_map_file = source_map_file;
+    to->output_sink = output_sink;
+    to->output_sink_cookie = output_sink_cookie;
+  }
+
+  // forget the borrowed pointers again (not freed by us)
+  static void sass_unshare_options (struct Sass_Options* options)
+  {
+    char* input_path = options->input_path;
+    char* output_path = options->output_path;
+    char* source_map_file = options->source_map_file;
+    sass_reset_options(options);
+    options->input_path = input_path;
+    options->output_path = output_path;
+    options->source_map_file = source_map_file;
+  }
+
+  // compile queued entries until none is left
+  static void sass_compile_batch_entries (struct Sass_Batch* batch, std::atomic<size_t>* next)
+  {
+    for (size_t i = (*next)++; i < batch->compiled.size(); i = (*next)++) {
+      struct Sass_File_Context* entry = batch->entries[batch->compiled[i]];
+      // forget results of an earlier run
+      sass_clear_results(entry);
+      sass_share_options(entry, batch->options);
+      if (!entry->sheet_cache) entry->sheet_cache = batch->sheet_cache;
+      sass_compile_file_context(entry);
+      sass_unshare_options(entry);
+    }
+  }
+
+  // compile all entries queued in `compiled`
+  static int sass_compile_batch_queue (struct Sass_Batch* batch, int threads)
+  {
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    size_t S = batch->compiled.size();
+    // the caller compiles too, go on with less threads if we must
+    try {
+      while (workers.size() + 1 < S && static_cast<int>(workers.size()) + 1 < threads) {
+        workers.push_back(std::thread(sass_compile_batch_entries, batch, &next));
+      }
+    }
+    catch (std::system_error&) { }
+    sass_compile_batch_entries(batch, &next);
+    for (std::thread& worker : workers) worker.join();
+    // rebuild the graph from all included files
+    batch->dependents.clear();
+    for (size_t i = 0, L = batch->entries.size(); i < L; ++i) {
+      char** files = batch->entries[i]->included_files;
+      while (files && *files) batch->dependents[*files++].insert(i);
+    }
+    int failed = 0;
+    for (size_t idx : batch->compiled) {
+      if (batch->entries[idx]->error_status) ++ failed;
+    }
+    return failed;
+  }
+
+  struct Sass_Batch* ADDCALL sass_make_batch (void)
+  {
+    struct Sass_Batch* batch = new Sass_Batch();
+    batch->options = sass_make_options();
+    batch->sheet_cache = sass_make_sheet_cache();
+    return batch;
+  }
+
+  struct Sass_Options* ADDCALL sass_batch_get_options (struct Sass_Batch* batch) { return batch->options; }
+  struct Sass_File_Context* ADDCALL sass_batch_get_file_context (struct Sass_Batch* batch, size_t idx) { return batch->entries[idx]; }
+  size_t ADDCALL sass_batch_get_size (struct Sass_Batch* batch) { return batch->entries.size(); }
+  size_t ADDCALL sass_batch_get_compiled_size (struct Sass_Batch* batch) { return batch->compiled.size(); }
+  size_t ADDCALL sass_batch_get_compiled (struct Sass_Batch* batch, size_t idx) { return batch->compiled[idx]; }
+
+  struct Sass_File_Context* ADDCALL sass_batch_add_file (struct Sass_Batch* batch, const char* input_path)
+  {
+    struct Sass_File_Context* entry = sass_make_file_context(input_path);
+    if (entry) batch->entries.push_back(entry);
+    return entry;
+  }
+
+  int ADDCALL sass_compile_batch (struct Sass_Batch* batch, int threads)
+  {
+    if (batch == 0) return 1;
+    batch->compiled.clear();
+    for (size_t i = 0, S = batch->entries.size(); i < S; ++i) {
+      batch->compiled.push_back(i);
+    }
+    return sass_compile_batch_queue(batch, threads);
+  }
+
+  int ADDCALL sass_batch_recompile (struct Sass_Batch* batch, const char** changed, int threads)
+  {
+    if (batch == 0) return 1;
+    std::set<size_t> affected;
+    // failed (or new) entries may depend on anything
+    for (size_t i = 0, S = batch->entries.size(); i < S; ++i) {
+      struct Sass_File_Context* entry = batch->entries[i];
+      if (entry->error_status || entry->included_files == 0) affected.insert(i);
+    }
+    // cache entries may not notice changes within the mtime resolution
+    struct Sass_Sheet_Cache* cache = batch->options->sheet_cache ?
+      batch->options->sheet_cache : batch->sheet_cache;
+    while (changed && *changed) {
+      std::string abs_path(File::rel2abs(*changed++));
+      cache->cpp_cache.invalidate(abs_path);
+      auto it = batch->dependents.find(abs_path);
+      if (it == batch->dependents.end()) continue;
+      affected.insert(it->second.begin(), it->second.end());
+    }
+    batch->compiled.assign(affected.begin(), affected.end());
+    return sass_compile_batch_queue(batch, threads);
+  }
+
+  void ADDCALL sass_delete_batch (struct Sass_Batch* batch)
+  {
+    if (batch == 0) return;
+    for (struct Sass_File_Context* entry : batch->entries) {
+      sass_delete_file_context(entry);
+    }
+    sass_delete_options(batch->options);
+    sass_delete_sheet_cache(batch->sheet_cache);
+    delete batch;
+  }
+
   // Getters for sass context from specific implementations
   struct Sass_Context* ADDCALL sass_file_context_get_context(struct Sass_File_Context* ctx) { return ctx; }
   struct Sass_Context* ADDCALL sass_data_context_get_context(struct Sass_Data_Context* ctx) { return ctx; }
@@ -670,6 +832,42 @@ extern "C" {
   size_t ADDCALL sass_context_get_included_files_size (struct Sass_Context* ctx)
   { size_t l = 0; auto i = ctx->included_files; while (i && *i) { ++i; ++l; } return l; }
 
+  bool ADDCALL sass_context_find_source_position (struct Sass_Context* ctx, size_t line, size_t column, const char** source, size_t* source_line, size_t* source_column)
+  {
+    if (ctx == 0 || ctx->source_map == 0) return false;
+    Mapping mapping(Position(0, 0), Position(0, 0));
+    if (!ctx->source_map->find(Offset(line, column), mapping)) return false;
+    const Position& original(mapping.original_position);
+    if (original.file >= ctx->source_map->sources.size()) return false;
+    if (source) *source = ctx->source_map->sources[original.file].c_str();
+    if (source_line) *source_line = original.line;
+    if (source_column) *source_column = original.column;
+    return true;
+  }
+
+  size_t ADDCALL sass_context_get_source_mappings (struct Sass_Context* ctx, struct Sass_Source_Mapping* mappings, size_t size)
+  {
+    if (ctx == 0 || ctx->source_map == 0) return 0;
+    return ctx->source_map->copy_mappings(mappings, size);
+  }
+
+  size_t ADDCALL sass_context_get_parse_cache_hits (struct Sass_Context* ctx)
+  {
+    return ctx ? ctx->parse_cache_hits : 0;
+  }
+
+  size_t ADDCALL sass_context_get_parse_cache_misses (struct Sass_Context* ctx)
+  {
+    return ctx ? ctx->parse_cache_misses : 0;
+  }
+
+  const char* ADDCALL sass_context_get_source_map_source (struct Sass_Context* ctx, size_t index)
+  {
+    if (ctx == 0 || ctx->source_map == 0) return 0;
+    if (index >= ctx->source_map->sources.size()) return 0;
+    return ctx->source_map->sources[index].c_str();
+  }
+
   // Create getter and setters for options
   IMPLEMENT_SASS_OPTION_ACCESSOR(int, precision);
   IMPLEMENT_SASS_OPTION_ACCESSOR(enum Sass_Output_Style, output_style);
@@ -682,6 +880,10 @@ extern "C" {
   IMPLEMENT_SASS_OPTION_ACCESSOR(Sass_Function_List, c_functions);
   IMPLEMENT_SASS_OPTION_ACCESSOR(Sass_Importer_List, c_importers);
   IMPLEMENT_SASS_OPTION_ACCESSOR(Sass_Importer_List, c_headers);
+  IMPLEMENT_SASS_OPTION_ACCESSOR(struct Sass_Sheet_Cache*, sheet_cache);
+  IMPLEMENT_SASS_OPTION_ACCESSOR(int, import_threads);
+  IMPLEMENT_SASS_OPTION_ACCESSOR(Sass_Output_Sink_Fn, output_sink);
+  IMPLEMENT_SASS_OPTION_ACCESSOR(void*, output_sink_cookie);
   IMPLEMENT_SASS_OPTION_ACCESSOR(const char*, indent);
   IMPLEMENT_SASS_OPTION_ACCESSOR(const char*, linefeed);
   IMPLEMENT_SASS_OPTION_STRING_SETTER(const char*, plugin_path, 0);
@@ -1,10 +1,18 @@
 #ifndef SASS_SASS_CONTEXT_H
 #define SASS_SASS_CONTEXT_H
 
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
 #include "sass/base.h"
 #include "sass/context.h"
 #include "ast_fwd_decl.hpp"
 
+namespace Sass {
+  class SourceMap;
+}
+
 // sass config options structure
 struct Sass_Options : Sass_Output_Options {
 
@@ -65,6 +73,19 @@ struct Sass_Options : Sass_Output_Options {
   // List of custom headers
   Sass_Importer_List c_headers;
 
+  // Parsed sheets shared between contexts
+  // Not owned by the options (may be null)
+  struct Sass_Sheet_Cache* sheet_cache;
+
+  // Worker threads parsing the imports of
+  // the entry file ahead of time (0 = off)
+  int import_threads;
+
+  // Receives the css in chunks instead
+  // of the output string (may be null)
+  Sass_Output_Sink_Fn output_sink;
+  void* output_sink_cookie;
+
 };
 
 
@@ -80,6 +101,12 @@ struct Sass_Context : Sass_Options
 
   // generated source map json
   char* source_map_string;
+  // mappings kept for position queries
+  Sass::SourceMap* source_map;
+
+  // reused and newly parsed generated selectors and media queries
+  size_t parse_cache_hits;
+  size_t parse_cache_misses;
 
   // error status
   int error_status;
@@ -114,6 +141,20 @@ struct Sass_Data_Context : Sass_Context {
 
 };
 
+// file contexts compiled with shared options
+struct Sass_Batch {
+  // options used by all entries
+  struct Sass_Options* options;
+  // one context per entry file
+  std::vector<struct Sass_File_Context*> entries;
+  // shares partials between entries
+  struct Sass_Sheet_Cache* sheet_cache;
+  // entries (by index) depending on a file
+  std::map<std::string, std::set<size_t>> dependents;
+  // entries compiled by the last call
+  std::vector<size_t> compiled;
+};
+
 // link c and cpp context
 struct Sass_Compiler {
   // progress status
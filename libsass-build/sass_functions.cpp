@@ -49,6 +49,10 @@ extern "C" {
   const char* ADDCALL sass_function_get_signature(Sass_Function_Entry cb) { return cb->signature; }
   Sass_Function_Fn ADDCALL sass_function_get_function(Sass_Function_Entry cb) { return cb->function; }
   void* ADDCALL sass_function_get_cookie(Sass_Function_Entry cb) { return cb->cookie; }
+  bool ADDCALL sass_function_get_pure(Sass_Function_Entry cb) { return cb->pure; }
+  void ADDCALL sass_function_set_pure(Sass_Function_Entry cb, bool pure) { cb->pure = pure; }
+  bool ADDCALL sass_function_get_batched(Sass_Function_Entry cb) { return cb->batched; }
+  void ADDCALL sass_function_set_batched(Sass_Function_Entry cb, bool batched) { cb->batched = batched; }
 
   Sass_Importer_Entry ADDCALL sass_make_importer(Sass_Importer_Fn importer, double priority, void* cookie)
   {
@@ -10,6 +10,10 @@ struct Sass_Function {
   char*            signature;
   Sass_Function_Fn function;
   void*            cookie;
+  // same result for the same arguments
+  bool             pure;
+  // called with the arguments of many calls at once
+  bool             batched;
 };
 
 // External import entry
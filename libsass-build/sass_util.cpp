@@ -42,19 +42,19 @@ namespace Sass {
     Node loopStart = Node::createCollection();
     loopStart.collection()->push_back(Node::createCollection());
 
-    for (NodeDeque::iterator arrsIter = arrs.collection()->begin(), arrsEndIter = arrs.collection()->end();
+    for (NodeCollection::iterator arrsIter = arrs.collection()->begin(), arrsEndIter = arrs.collection()->end();
     	arrsIter != arrsEndIter; ++arrsIter) {
 
       Node& arr = *arrsIter;
 
       Node permutations = Node::createCollection();
 
-      for (NodeDeque::iterator arrIter = arr.collection()->begin(), arrIterEnd = arr.collection()->end();
+      for (NodeCollection::iterator arrIter = arr.collection()->begin(), arrIterEnd = arr.collection()->end();
       	arrIter != arrIterEnd; ++arrIter) {
 
         Node& e = *arrIter;
 
-        for (NodeDeque::iterator loopStartIter = loopStart.collection()->begin(), loopStartIterEnd = loopStart.collection()->end();
+        for (NodeCollection::iterator loopStartIter = loopStart.collection()->begin(), loopStartIterEnd = loopStart.collection()->end();
           loopStartIter != loopStartIterEnd; ++loopStartIter) {
 
           Node& path = *loopStartIter;
@@ -116,7 +116,7 @@ namespace Sass {
     Node flattened = Node::createCollection();
     if (arr.got_line_feed) flattened.got_line_feed = true;
 
-    for (NodeDeque::iterator iter = arr.collection()->begin(), iterEnd = arr.collection()->end();
+    for (NodeCollection::iterator iter = arr.collection()->begin(), iterEnd = arr.collection()->end();
     	iter != iterEnd; iter++) {
     	Node& e = *iter;
 
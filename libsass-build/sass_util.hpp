@@ -50,7 +50,19 @@ namespace Sass {
   };
 
 
-  typedef std::vector<std::vector<int> > LCSTable;
+  // Lengths of the longest common subsequences of all prefixes of
+  // two collections, in one flat buffer (row by row).
+  class LCSTable {
+  public:
+    LCSTable(size_t rows, size_t cols)
+    : mCols(cols), mCells(rows * cols, 0)
+    { }
+    int& at(size_t i, size_t j) { return mCells[i * mCols + j]; }
+    int at(size_t i, size_t j) const { return mCells[i * mCols + j]; }
+  private:
+    size_t mCols;
+    std::vector<int> mCells;
+  };
 
 
   /*
@@ -68,8 +80,8 @@ namespace Sass {
       return Node::createCollection();
     }
 
-    NodeDeque& xChildren = *(x.collection());
-    NodeDeque& yChildren = *(y.collection());
+    NodeCollection& xChildren = *(x.collection());
+    NodeCollection& yChildren = *(y.collection());
 
     Node compareOut = Node::createNil();
     if (comparator(xChildren[i], yChildren[j], compareOut)) {
@@ -79,7 +91,7 @@ namespace Sass {
       return result;
     }
 
-    if (c[i][j - 1] > c[i - 1][j]) {
+    if (c.at(i, j - 1) > c.at(i - 1, j)) {
       DEBUG_PRINTLN(LCS, "RETURNING AFTER TABLE COMPARE")
       return lcs_backtrace(c, x, y, i, j - 1, comparator);
     }
@@ -96,15 +108,13 @@ namespace Sass {
   # Algorithm from http://en.wikipedia.org/wiki/Longest_common_subsequence_problem#Computing_the_length_of_the_LCS
   */
   template<typename ComparatorType>
-  void lcs_table(const Node& x, const Node& y, const ComparatorType& comparator, LCSTable& out) {
+  void lcs_table(const Node& x, const Node& y, const ComparatorType& comparator, LCSTable& c) {
     DEBUG_PRINTLN(LCS, "LCSTABLE: X=" << x << " Y=" << y)
 
-    NodeDeque& xChildren = *(x.collection());
-    NodeDeque& yChildren = *(y.collection());
+    NodeCollection& xChildren = *(x.collection());
+    NodeCollection& yChildren = *(y.collection());
 
-    LCSTable c(xChildren.size(), std::vector<int>(yChildren.size()));
-
-    // These shouldn't be necessary since the vector will be initialized to 0 already.
+    // These shouldn't be necessary since the table is initialized to 0 already.
     // x.size.times {|i| c[i][0] = 0}
     // y.size.times {|j| c[0][j] = 0}
 
@@ -113,14 +123,12 @@ namespace Sass {
         Node compareOut = Node::createNil();
 
         if (comparator(xChildren[i], yChildren[j], compareOut)) {
-          c[i][j] = c[i - 1][j - 1] + 1;
+          c.at(i, j) = c.at(i - 1, j - 1) + 1;
         } else {
-          c[i][j] = std::max(c[i][j - 1], c[i - 1][j]);
+          c.at(i, j) = std::max(c.at(i, j - 1), c.at(i - 1, j));
         }
       }
     }
-
-    out = c;
   }
 
 
@@ -150,7 +158,7 @@ namespace Sass {
     newY.collection()->push_back(Node::createNil());
     newY.plus(y);
 
-    LCSTable table;
+    LCSTable table(newX.collection()->size(), newY.collection()->size());
     lcs_table(newX, newY, comparator, table);
 
     return lcs_backtrace(table, newX, newY, static_cast<int>(newX.collection()->size()) - 1, static_cast<int>(newY.collection()->size()) - 1, comparator);
@@ -0,0 +1,264 @@
+#include "sass.hpp"
+#include <cstring>
+#include <sys/stat.h>
+
+#include "ast.hpp"
+#include "sass/context.h"
+#include "sheet_cache.hpp"
+
+namespace Sass {
+
+  // FNV-1a over the (null terminated) source buffer
+  static size_t hash_contents(const char* contents)
+  {
+    size_t hash = static_cast<size_t>(2166136261UL);
+    if (contents == 0) return hash;
+    while (*contents) {
+      hash ^= static_cast<unsigned char>(*contents++);
+      hash *= static_cast<size_t>(16777619UL);
+    }
+    return hash;
+  }
+
+  // query modification time and size of a file
+  static bool stat_file(const std::string& path, time_t& mtime, size_t& size)
+  {
+    struct stat st;
+    if (stat(path.c_str(), &st) == -1) return false;
+    mtime = st.st_mtime;
+    size = static_cast<size_t>(st.st_size);
+    return true;
+  }
+
+  Sheet_Cache::Request::Request(const std::string& load_path, Sass_Import_Entry prev, Sass_Import_List includes)
+  : load_path(load_path),
+    prev_imp_path(),
+    prev_abs_path(),
+    claimed(includes != 0),
+    paths(),
+    loaded(false)
+  {
+    if (const char* imp_path = sass_import_get_imp_path(prev)) prev_imp_path = imp_path;
+    if (const char* abs_path = sass_import_get_abs_path(prev)) prev_abs_path = abs_path;
+    for (Sass_Import_List it = includes; it && *it; ++it) {
+      const char* abs_path = sass_import_get_abs_path(*it);
+      paths.push_back(abs_path ? abs_path : "");
+      if (sass_import_get_source(*it) || sass_import_get_srcmap(*it) ||
+          sass_import_get_error_message(*it)) loaded = true;
+    }
+  }
+
+  bool Sheet_Cache::Request::operator==(const Request& rhs) const
+  {
+    return load_path == rhs.load_path
+        && prev_imp_path == rhs.prev_imp_path
+        && prev_abs_path == rhs.prev_abs_path
+        && claimed == rhs.claimed
+        && paths == rhs.paths
+        && loaded == rhs.loaded;
+  }
+
+  Sheet_Cache::Entry::Entry(const std::string& key, const std::string& abs_path)
+  : key(key),
+    abs_path(abs_path),
+    path(sass_copy_c_string(abs_path.c_str())),
+    contents(0),
+    mtime(0),
+    size(0),
+    hash(0),
+    file_id(std::string::npos),
+    root(),
+    imports(),
+    requests(),
+    owner(0),
+    restorable(true)
+  {
+    // must happen before the file is read
+    stat_file(abs_path, mtime, size);
+  }
+
+  void Sheet_Cache::Entry::load(char* buffer)
+  {
+    contents = buffer;
+    hash = hash_contents(buffer);
+  }
+
+  Sheet_Cache::Entry::~Entry()
+  {
+    // the tree points into both buffers
+    root = 0;
+    free(contents);
+    free(path);
+  }
+
+  Sheet_Cache::Sheet_Cache()
+  : mutex(), entries(), retired(), next_id(0), hits(0), misses(0),
+    extend_cache()
+  { }
+
+  Sheet_Cache::~Sheet_Cache()
+  {
+    // caller must ensure no compilation is running
+    for (auto entry : entries) delete entry.second;
+    for (auto entry : retired) delete entry;
+  }
+
+  Sheet_Cache::Entry* Sheet_Cache::acquire(const std::string& key, const std::string& abs_path, Context* owner)
+  {
+    time_t mtime = 0; size_t size = 0;
+    bool exists = stat_file(abs_path, mtime, size);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) { ++ misses; return 0; }
+    Entry* entry = it->second;
+    // lent to another compilation right now
+    if (entry->owner && entry->owner != owner) { ++ misses; return 0; }
+    // file was touched, see if the content really changed
+    if (exists && (entry->mtime != mtime || entry->size != size)) {
+      char* contents = File::read_file(abs_path);
+      exists = contents && hash_contents(contents) == entry->hash
+                        && std::strcmp(contents, entry->contents) == 0;
+      if (exists) { entry->mtime = mtime; entry->size = size; }
+      free(contents);
+    }
+    // invalidate the entry
+    if (!exists) {
+      entries.erase(it);
+      if (entry->owner) retired.push_back(entry);
+      else delete entry;
+      ++ misses; return 0;
+    }
+    entry->owner = owner;
+    ++ hits; return entry;
+  }
+
+  Sheet_Cache::Entry* Sheet_Cache::prepare(const std::string& key, const std::string& abs_path)
+  {
+    Entry* entry = new Entry(key, abs_path);
+    std::lock_guard<std::mutex> lock(mutex);
+    // must not collide with any resource index
+    entry->file_id = std::string::npos / 2 + (++ next_id);
+    return entry;
+  }
+
+  void Sheet_Cache::store(Entry* entry, Context* owner)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    entry->owner = owner;
+    auto it = entries.find(entry->key);
+    // newer entry replaces the old one
+    if (it != entries.end()) {
+      Entry* old = it->second;
+      if (old->owner) retired.push_back(old);
+      else delete old;
+    }
+    entries[entry->key] = entry;
+  }
+
+  void Sheet_Cache::reject()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    -- hits; ++ misses;
+  }
+
+  char* Sheet_Cache::discard(Entry* entry)
+  {
+    char* path = entry->path;
+    // contents belong to the caller
+    entry->contents = 0;
+    entry->path = 0;
+    delete entry;
+    return path;
+  }
+
+  void Sheet_Cache::release(Context* owner)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto entry : entries) {
+      if (entry.second->owner == owner) {
+        entry.second->owner = 0;
+      }
+    }
+    for (size_t i = 0; i < retired.size();) {
+      if (retired[i]->owner == owner) {
+        delete retired[i];
+        retired.erase(retired.begin() + i);
+      }
+      else ++ i;
+    }
+  }
+
+  void Sheet_Cache::invalidate(const std::string& abs_path)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = entries.begin(); it != entries.end();) {
+      Entry* entry = it->second;
+      if (entry->abs_path != abs_path) { ++ it; continue; }
+      if (entry->owner) retired.push_back(entry);
+      else delete entry;
+      it = entries.erase(it);
+    }
+  }
+
+  void Sheet_Cache::clear()
+  {
+    extend_cache.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto entry : entries) {
+      if (entry.second->owner) retired.push_back(entry.second);
+      else delete entry.second;
+    }
+    entries.clear();
+  }
+
+  size_t Sheet_Cache::get_hits()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+  }
+
+  size_t Sheet_Cache::get_misses()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+  }
+
+  size_t Sheet_Cache::get_size()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+  }
+
+}
+
+extern "C" {
+  using namespace Sass;
+
+  struct Sass_Sheet_Cache* ADDCALL sass_make_sheet_cache(void)
+  {
+    return new Sass_Sheet_Cache();
+  }
+
+  void ADDCALL sass_delete_sheet_cache(struct Sass_Sheet_Cache* cache)
+  {
+    delete cache;
+  }
+
+  void ADDCALL sass_sheet_cache_clear(struct Sass_Sheet_Cache* cache)
+  {
+    if (cache) cache->cpp_cache.clear();
+  }
+
+  void ADDCALL sass_sheet_cache_invalidate(struct Sass_Sheet_Cache* cache, const char* path)
+  {
+    if (cache && path) cache->cpp_cache.invalidate(File::rel2abs(path));
+  }
+
+  size_t ADDCALL sass_sheet_cache_get_hits(struct Sass_Sheet_Cache* cache) { return cache->cpp_cache.get_hits(); }
+  size_t ADDCALL sass_sheet_cache_get_misses(struct Sass_Sheet_Cache* cache) { return cache->cpp_cache.get_misses(); }
+  size_t ADDCALL sass_sheet_cache_get_size(struct Sass_Sheet_Cache* cache) { return cache->cpp_cache.get_size(); }
+  size_t ADDCALL sass_sheet_cache_get_extend_hits(struct Sass_Sheet_Cache* cache) { return cache->cpp_cache.extend_cache.get_hits(); }
+  size_t ADDCALL sass_sheet_cache_get_extend_misses(struct Sass_Sheet_Cache* cache) { return cache->cpp_cache.extend_cache.get_misses(); }
+  size_t ADDCALL sass_sheet_cache_get_extend_size(struct Sass_Sheet_Cache* cache) { return cache->cpp_cache.extend_cache.get_size(); }
+
+}
@@ -0,0 +1,146 @@
+#ifndef SASS_SHEET_CACHE_H
+#define SASS_SHEET_CACHE_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ctime>
+
+#include "ast_fwd_decl.hpp"
+#include "file.hpp"
+#include "sass/functions.h"
+#include "extend_cache.hpp"
+
+namespace Sass {
+
+  class Context;
+
+  // Keeps parsed stylesheets (partials loaded from the file system)
+  // alive between compilations. Entries are keyed by the absolute
+  // path plus the include paths that were used to resolve the imports
+  // of the sheet. They are validated by mtime/size and, if touched,
+  // by a hash of the content before they are reused.
+  // Our ref-counts are not atomic, therefore every entry is lent to
+  // one context at a time. Other contexts asking for the same sheet
+  // meanwhile simply parse it again (counted as a miss).
+  // The cache also keeps the extended selectors of the session.
+  class Sheet_Cache {
+  public:
+    // an import passed to the custom importers and their answer
+    class Request {
+    public:
+      // requested url
+      std::string load_path;
+      // last import when it was requested
+      std::string prev_imp_path;
+      std::string prev_abs_path;
+      // some importer returned a list
+      bool claimed;
+      // paths of the returned imports
+      std::vector<std::string> paths;
+      // some import came with its source (or an error)
+      bool loaded;
+    public:
+      Request(const std::string& load_path, Sass_Import_Entry prev, Sass_Import_List includes);
+      bool operator==(const Request& rhs) const;
+    };
+    class Entry {
+    public:
+      // cache lookup key
+      std::string key;
+      // resolved absolute path
+      std::string abs_path;
+      // path used by all parser states
+      char* path;
+      // the file contents
+      char* contents;
+      // fingerprint of the source file
+      time_t mtime;
+      size_t size;
+      size_t hash;
+      // source id used by all parser states
+      // translated back in the source map
+      size_t file_id;
+      // parsed root block
+      Block_Obj root;
+      // all imports resolved while parsing
+      std::vector<Include> imports;
+      // all imports passed to custom importers
+      std::vector<Request> requests;
+      // context currently using this sheet
+      Context* owner;
+      // imports are all restorable
+      bool restorable;
+    public:
+      Entry(const std::string& key, const std::string& abs_path);
+      ~Entry();
+      // take over the loaded file contents
+      void load(char* contents);
+    };
+
+  private:
+    std::mutex mutex;
+    std::map<std::string, Entry*> entries;
+    // stale entries still lent to a context
+    std::vector<Entry*> retired;
+    size_t next_id;
+    size_t hits;
+    size_t misses;
+
+  public:
+    // extended selectors shared between compilations
+    Extend_Cache extend_cache;
+
+  public:
+    Sheet_Cache();
+    ~Sheet_Cache();
+
+    // lend a valid cached sheet to the given context
+    // returns 0 if nothing usable is in the cache
+    Entry* acquire(const std::string& key, const std::string& abs_path, Context* owner);
+    // create a new entry for a sheet we are about to load
+    // the entry only owns its path until it is stored
+    Entry* prepare(const std::string& key, const std::string& abs_path);
+    // store the parsed entry (stays lent to the owner)
+    void store(Entry* entry, Context* owner);
+    // a lent entry could not be used, count it as a miss
+    void reject();
+    // delete the unused entry, but pass the path to the caller
+    char* discard(Entry* entry);
+    // give back all sheets lent to the given context
+    void release(Context* owner);
+    // drop all entries of the given file
+    void invalidate(const std::string& abs_path);
+    // drop all entries that are not lent right now
+    // and all extended selectors
+    void clear();
+
+    size_t get_hits();
+    size_t get_misses();
+    size_t get_size();
+
+  };
+
+  // returns sheets to the cache once a context is gone
+  // must be destroyed after any other ast of the context
+  class Sheet_Lease {
+  public:
+    Sheet_Cache* cache;
+    Context* owner;
+  public:
+    Sheet_Lease(Sheet_Cache* cache, Context* owner)
+    : cache(cache), owner(owner)
+    { }
+    ~Sheet_Lease()
+    { if (cache) cache->release(owner); }
+  };
+
+}
+
+// link c and cpp sheet cache
+struct Sass_Sheet_Cache {
+  Sass::Sheet_Cache cpp_cache;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "sass.hpp"
+
+#include "ast.hpp"
+#include "symbol.hpp"
+#include "slot_resolver.hpp"
+
+namespace Sass {
+
+  void Slot_Resolver::operator()(Block_Ptr b)
+  {
+    if (!b) return;
+    for (Statement_Obj stm : b->elements()) {
+      if (Definition_Ptr def = Cast<Definition>(stm)) {
+        resolve(def);
+        continue;
+      }
+      if (If_Ptr cond = Cast<If>(stm)) (*this)(cond->alternative());
+      if (Has_Block_Ptr parent = Cast<Has_Block>(stm)) (*this)(parent->block());
+    }
+  }
+
+  void Slot_Resolver::resolve(Definition_Ptr def)
+  {
+    slots.clear();
+    unstable.clear();
+    if (def->parameters()) {
+      for (Parameter_Obj param : def->parameters()->elements()) {
+        slots.push_back(param->name());
+      }
+    }
+    scan(def->block(), true);
+    std::vector<Symbol> symbols;
+    for (const std::string& name : slots) {
+      symbols.push_back(variable_symbol(name));
+    }
+    def->slots(symbols);
+    mark(def->block());
+    // nested definitions get their own frames
+    (*this)(def->block());
+  }
+
+  // the top of the body is expanded in the call frame,
+  // everything else may run in a scope of its own
+  void Slot_Resolver::scan(Block_Ptr b, bool top)
+  {
+    if (!b) return;
+    for (Statement_Obj stm : b->elements()) {
+      if (Cast<Definition>(stm)) continue;
+      if (Assignment_Ptr assignment = Cast<Assignment>(stm)) {
+        const std::string& name(assignment->variable());
+        if (!top || assignment->is_default() || assignment->is_global()) {
+          unstable.insert(name);
+        }
+        else if (std::find(slots.begin(), slots.end(), name) == slots.end()) {
+          slots.push_back(name);
+        }
+      }
+      if (Each_Ptr each = Cast<Each>(stm)) {
+        for (const std::string& variable : each->variables()) unstable.insert(variable);
+      }
+      if (For_Ptr loop = Cast<For>(stm)) {
+        unstable.insert(loop->variable());
+      }
+      if (If_Ptr cond = Cast<If>(stm)) scan(cond->alternative(), false);
+      if (Has_Block_Ptr parent = Cast<Has_Block>(stm)) scan(parent->block(), false);
+    }
+  }
+
+  void Slot_Resolver::mark(Block_Ptr b)
+  {
+    if (!b) return;
+    for (Statement_Obj stm : b->elements()) mark(stm);
+  }
+
+  void Slot_Resolver::mark(Statement_Ptr stm)
+  {
+    if (Cast<Definition>(stm)) return;
+    if (Assignment_Ptr assignment = Cast<Assignment>(stm)) mark(assignment->value());
+    else if (Declaration_Ptr dec = Cast<Declaration>(stm)) {
+      mark(dec->property());
+      mark(dec->value());
+    }
+    else if (Return_Ptr ret = Cast<Return>(stm)) mark(ret->value());
+    else if (Warning_Ptr warning = Cast<Warning>(stm)) mark(warning->message());
+    else if (Error_Ptr error = Cast<Error>(stm)) mark(error->message());
+    else if (Debug_Ptr debug = Cast<Debug>(stm)) mark(debug->value());
+    else if (If_Ptr cond = Cast<If>(stm)) {
+      mark(cond->predicate());
+      mark(cond->alternative());
+    }
+    else if (For_Ptr loop = Cast<For>(stm)) {
+      mark(loop->lower_bound());
+      mark(loop->upper_bound());
+    }
+    else if (Each_Ptr each = Cast<Each>(stm)) mark(each->list());
+    else if (While_Ptr loop = Cast<While>(stm)) mark(loop->predicate());
+    // the content block is expanded in a call frame of its own
+    else if (Mixin_Call_Ptr call = Cast<Mixin_Call>(stm)) {
+      mark(call->arguments());
+      return;
+    }
+    if (Has_Block_Ptr parent = Cast<Has_Block>(stm)) mark(parent->block());
+  }
+
+  void Slot_Resolver::mark(Expression_Ptr ex)
+  {
+    if (!ex) return;
+    if (Variable_Ptr var = Cast<Variable>(ex)) {
+      if (unstable.count(var->name())) return;
+      for (size_t i = 0, L = slots.size(); i < L; ++i) {
+        if (slots[i] == var->name()) var->slot(i + 1);
+      }
+    }
+    else if (Binary_Expression_Ptr binary = Cast<Binary_Expression>(ex)) {
+      mark(binary->left());
+      mark(binary->right());
+    }
+    else if (Unary_Expression_Ptr unary = Cast<Unary_Expression>(ex)) {
+      mark(unary->operand());
+    }
+    else if (Function_Call_Ptr call = Cast<Function_Call>(ex)) {
+      mark(call->arguments());
+    }
+    else if (Arguments_Ptr args = Cast<Arguments>(ex)) {
+      for (Argument_Obj arg : args->elements()) mark(arg);
+    }
+    else if (Argument_Ptr arg = Cast<Argument>(ex)) {
+      mark(arg->value());
+    }
+    else if (List_Ptr list = Cast<List>(ex)) {
+      for (Expression_Obj item : list->elements()) mark(item);
+    }
+    else if (Map_Ptr map = Cast<Map>(ex)) {
+      for (Expression_Obj key : map->keys()) {
+        mark(key);
+        mark(map->at(key));
+      }
+    }
+    else if (String_Schema_Ptr schema = Cast<String_Schema>(ex)) {
+      for (Expression_Obj item : schema->elements()) mark(item);
+    }
+  }
+
+}
@@ -0,0 +1,38 @@
+#ifndef SASS_SLOT_RESOLVER_H
+#define SASS_SLOT_RESOLVER_H
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ast_fwd_decl.hpp"
+
+namespace Sass {
+
+  // Resolves variables of mixin and function bodies to slots in the
+  // frame of the call. Parameters and plain assignments at the top of
+  // the body get fixed slots which every call frame declares up front.
+  // References to them are marked with the slot and looked up directly
+  // in the call frame, without walking the scopes in between. Names
+  // that may also be set in a nested scope (loop variables, assignments
+  // in control directives, !global or !default) are left to the
+  // dynamic lookup, as is everything else (globals, content blocks).
+  class Slot_Resolver {
+  private:
+    std::vector<std::string> slots;
+    std::set<std::string> unstable;
+    void resolve(Definition_Ptr def);
+    void scan(Block_Ptr b, bool top);
+    void mark(Block_Ptr b);
+    void mark(Statement_Ptr stm);
+    void mark(Expression_Ptr ex);
+
+  public:
+    // resolve all definitions in a parsed stylesheet
+    void operator()(Block_Ptr root);
+
+  };
+
+}
+
+#endif
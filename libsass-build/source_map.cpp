@@ -1,40 +1,99 @@
 #include "sass.hpp"
 #include <string>
-#include <sstream>
-#include <iostream>
-#include <iomanip>
+#include <cstring>
 
 #include "ast.hpp"
-#include "json.hpp"
+#include "utf8.h"
 #include "context.hpp"
 #include "position.hpp"
 #include "source_map.hpp"
 
 namespace Sass {
-  SourceMap::SourceMap() : current_position(0, 0, 0), file("stdin") { }
-  SourceMap::SourceMap(const std::string& file) : current_position(0, 0, 0), file(file) { }
+  SourceMap::SourceMap() : runs(1, Run(0, Offset(0, 0))), current_position(0, 0, 0), file("stdin") { }
+  SourceMap::SourceMap(const std::string& file) : runs(1, Run(0, Offset(0, 0))), current_position(0, 0, 0), file(file) { }
 
-  std::string SourceMap::render_srcmap(Context &ctx) {
+  // JSON is written straight into the buffer (with the escapes
+  // of `json_stringify`), the layout is the one `json_stringify`
+  // gives with tabs, or without any space for compressed output
 
-    const bool include_sources = ctx.c_options.source_map_contents;
-    const std::vector<std::string> links = ctx.srcmap_links;
-    const std::vector<Resource>& sources(ctx.resources);
+  static void srcmap_string(std::string& out, const char* str)
+  {
+    static const char* hex = "0123456789ABCDEF";
+    const char* end = str + std::strlen(str);
+    // make assertion catchable
+#ifndef NDEBUG
+    if (utf8::find_invalid(str, end) != end) {
+      throw utf8::invalid_utf8(0);
+    }
+#endif
+    out += '"';
+    // copy the text between escapes in one go
+    const char* text = str;
+    for (const char* it = str; it != end; ++it) {
+      unsigned char c = *it;
+      if (c >= 0x80) {
+        const char* next = it;
+        if (utf8::internal::validate_next(next, end) == utf8::internal::UTF8_OK) {
+          it = next - 1;
+          continue;
+        }
+        // like `json_stringify` write a replacement
+        // character (U+FFFD) for the invalid byte
+        out.append(text, it);
+        out += "\xEF\xBF\xBD";
+        text = it + 1;
+        continue;
+      }
+      if (c >= 0x1F && c != '"' && c != '\\') continue;
+      out.append(text, it);
+      text = it + 1;
+      switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+          out += "\\u00";
+          out += hex[c >> 4];
+          out += hex[c & 0xF];
+      }
+    }
+    out.append(text, end);
+    out += '"';
+  }
 
-    JsonNode* json_srcmap = json_mkobject();
+  static void srcmap_key(std::string& out, const char* key, bool compact)
+  {
+    out += compact ? "," : ",\n\t";
+    srcmap_string(out, key);
+    out += compact ? ":" : ": ";
+  }
 
-    json_append_member(json_srcmap, "version", json_mknumber(3));
+  // before the element at the given index
+  static void srcmap_item(std::string& out, size_t i, bool compact)
+  {
+    if (i == 0) out += compact ? "[" : "[\n\t\t";
+    else out += compact ? "," : ",\n\t\t";
+  }
 
-    const char *file_name = file.c_str();
-    JsonNode *json_file_name = json_mkstring(file_name);
-    json_append_member(json_srcmap, "file", json_file_name);
+  static void srcmap_close(std::string& out, size_t size, bool compact)
+  {
+    if (size == 0) out += "[]";
+    else out += compact ? "]" : "\n\t]";
+  }
 
-    // pass-through sourceRoot option
-    if (!ctx.source_map_root.empty()) {
-      JsonNode* root = json_mkstring(ctx.source_map_root.c_str());
-      json_append_member(json_srcmap, "sourceRoot", root);
-    }
+  std::string SourceMap::render_srcmap(Context &ctx) {
+
+    const bool include_sources = ctx.c_options.source_map_contents;
+    const bool compact = ctx.c_options.output_style == SASS_STYLE_COMPRESSED;
+    const std::vector<std::string>& links(ctx.srcmap_links);
+    const std::vector<Resource>& sources(ctx.resources);
 
-    JsonNode *json_sources = json_mkarray();
+    std::vector<std::string> names;
+    size_t size = mappings.size() * 6 + file.size() + 256;
     for (size_t i = 0; i < source_index.size(); ++i) {
       std::string source(links[source_index[i]]);
       if (ctx.c_options.source_map_file_urls) {
@@ -48,98 +107,183 @@ namespace Sass {
           source = "file:///" + source;
         }
       }
-      const char* source_name = source.c_str();
-      JsonNode *json_source_name = json_mkstring(source_name);
-      json_append_element(json_sources, json_source_name);
+      size += source.size() + 8;
+      if (include_sources) {
+        // some room for escapes
+        size_t length = std::strlen(sources[source_index[i]].contents);
+        size += length + length / 16 + 8;
+      }
+      names.push_back(source);
+    }
+
+    std::string result;
+    result.reserve(size);
+    result += compact ? "{\"version\":3" : "{\n\t\"version\": 3";
+
+    srcmap_key(result, "file", compact);
+    srcmap_string(result, file.c_str());
+
+    // pass-through sourceRoot option
+    if (!ctx.source_map_root.empty()) {
+      srcmap_key(result, "sourceRoot", compact);
+      srcmap_string(result, ctx.source_map_root.c_str());
+    }
+
+    srcmap_key(result, "sources", compact);
+    for (size_t i = 0; i < names.size(); ++i) {
+      srcmap_item(result, i, compact);
+      srcmap_string(result, names[i].c_str());
     }
-    json_append_member(json_srcmap, "sources", json_sources);
+    srcmap_close(result, names.size(), compact);
 
     if (include_sources && source_index.size()) {
-      JsonNode *json_contents = json_mkarray();
+      srcmap_key(result, "sourcesContent", compact);
       for (size_t i = 0; i < source_index.size(); ++i) {
-        const Resource& resource(sources[source_index[i]]);
-        JsonNode *json_content = json_mkstring(resource.contents);
-        json_append_element(json_contents, json_content);
+        srcmap_item(result, i, compact);
+        srcmap_string(result, sources[source_index[i]].contents);
       }
-      json_append_member(json_srcmap, "sourcesContent", json_contents);
+      srcmap_close(result, source_index.size(), compact);
     }
 
-    JsonNode *json_names = json_mkarray();
     // so far we have no implementation for names
     // no problem as we do not alter any identifiers
-    json_append_member(json_srcmap, "names", json_names);
+    srcmap_key(result, "names", compact);
+    result += "[]";
 
-    std::string mappings = serialize_mappings();
-    JsonNode *json_mappings = json_mkstring(mappings.c_str());
-    json_append_member(json_srcmap, "mappings", json_mappings);
+    // only base64 chars and delimiters, nothing to escape
+    srcmap_key(result, "mappings", compact);
+    result += '"';
+    serialize_mappings(result);
+    result += '"';
 
-    char *str = json_stringify(json_srcmap, "\t");
-    std::string result = std::string(str);
-    free(str);
-    json_delete(json_srcmap);
+    result += compact ? "}" : "\n}";
     return result;
   }
 
-  std::string SourceMap::serialize_mappings() {
-    std::string result = "";
+  void SourceMap::serialize_mappings(std::string& result) {
 
     size_t previous_generated_line = 0;
     size_t previous_generated_column = 0;
     size_t previous_original_line = 0;
     size_t previous_original_column = 0;
     size_t previous_original_file = 0;
-    for (size_t i = 0; i < mappings.size(); ++i) {
-      const size_t generated_line = mappings[i].generated_position.line;
-      const size_t generated_column = mappings[i].generated_position.column;
-      const size_t original_line = mappings[i].original_position.line;
-      const size_t original_column = mappings[i].original_position.column;
-      const size_t original_file = mappings[i].original_position.file;
-
-      if (generated_line != previous_generated_line) {
-        previous_generated_column = 0;
-        if (generated_line > previous_generated_line) {
-          result += std::string(generated_line - previous_generated_line, ';');
-          previous_generated_line = generated_line;
+    bool first = true;
+    for (size_t r = 0; r < runs.size(); ++r) {
+      for (size_t i = runs[r].begin, L = run_end(r); i < L; ++i) {
+        const Mapping mapping(moved(runs[r], i));
+        const size_t generated_line = mapping.generated_position.line;
+        const size_t generated_column = mapping.generated_position.column;
+        const size_t original_line = mapping.original_position.line;
+        const size_t original_column = mapping.original_position.column;
+        const size_t original_file = source_id(mapping.original_position.file);
+
+        if (generated_line != previous_generated_line) {
+          previous_generated_column = 0;
+          if (generated_line > previous_generated_line) {
+            result.append(generated_line - previous_generated_line, ';');
+            previous_generated_line = generated_line;
+          }
         }
+        else if (!first) {
+          result += ',';
+        }
+        first = false;
+
+        // generated column
+        base64vlq.encode(result, static_cast<int>(generated_column) - static_cast<int>(previous_generated_column));
+        previous_generated_column = generated_column;
+        // file
+        base64vlq.encode(result, static_cast<int>(original_file) - static_cast<int>(previous_original_file));
+        previous_original_file = original_file;
+        // source line
+        base64vlq.encode(result, static_cast<int>(original_line) - static_cast<int>(previous_original_line));
+        previous_original_line = original_line;
+        // source column
+        base64vlq.encode(result, static_cast<int>(original_column) - static_cast<int>(previous_original_column));
+        previous_original_column = original_column;
       }
-      else if (i > 0) {
-        result += ",";
-      }
+    }
+  }
+
+  size_t SourceMap::run_end(size_t r) const
+  {
+    return r + 1 == runs.size() ? mappings.size() : runs[r].end;
+  }
 
-      // generated column
-      result += base64vlq.encode(static_cast<int>(generated_column) - static_cast<int>(previous_generated_column));
-      previous_generated_column = generated_column;
-      // file
-      result += base64vlq.encode(static_cast<int>(original_file) - static_cast<int>(previous_original_file));
-      previous_original_file = original_file;
-      // source line
-      result += base64vlq.encode(static_cast<int>(original_line) - static_cast<int>(previous_original_line));
-      previous_original_line = original_line;
-      // source column
-      result += base64vlq.encode(static_cast<int>(original_column) - static_cast<int>(previous_original_column));
-      previous_original_column = original_column;
+  Mapping SourceMap::moved(const Run& run, size_t i) const
+  {
+    Mapping mapping(mappings[i]);
+    Position& position(mapping.generated_position);
+    // move stuff on the first old line
+    if (position.line == 0) position.column += run.offset.column;
+    // make place for the new lines
+    position.line += run.offset.line;
+    return mapping;
+  }
+
+  size_t SourceMap::search(size_t r, const Offset& position, bool after) const
+  {
+    size_t lo = runs[r].begin, hi = run_end(r);
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      const Position generated(moved(runs[r], mid).generated_position);
+      bool before = generated.line < position.line || (generated.line == position.line &&
+        (after ? generated.column <= position.column : generated.column < position.column));
+      if (before) lo = mid + 1;
+      else hi = mid;
     }
+    return lo;
+  }
 
-    return result;
+  size_t SourceMap::source_id(size_t file) const
+  {
+    auto source_id = source_ids.find(file);
+    return source_id == source_ids.end() ? file : source_id->second;
+  }
+
+  void SourceMap::close_run()
+  {
+    Run& open = runs.back();
+    if (open.begin == mappings.size()) {
+      open.offset = Offset(0, 0);
+      return;
+    }
+    open.end = mappings.size();
+    runs.push_back(Run(mappings.size(), Offset(0, 0)));
   }
 
   void SourceMap::prepend(const OutputBuffer& out)
   {
-    Offset size(out.smap.current_position);
-    for (Mapping mapping : out.smap.mappings) {
-      if (mapping.generated_position.line > size.line) {
-        throw(std::runtime_error("prepend sourcemap has illegal line"));
-      }
-      if (mapping.generated_position.line == size.line) {
-        if (mapping.generated_position.column > size.column) {
-          throw(std::runtime_error("prepend sourcemap has illegal column"));
+    const SourceMap& smap(out.smap);
+    Offset size(smap.current_position);
+    for (size_t r = 0; r < smap.runs.size(); ++r) {
+      for (size_t i = smap.runs[r].begin, L = smap.run_end(r); i < L; ++i) {
+        Mapping mapping(smap.moved(smap.runs[r], i));
+        if (mapping.generated_position.line > size.line) {
+          throw(std::runtime_error("prepend sourcemap has illegal line"));
+        }
+        if (mapping.generated_position.line == size.line) {
+          if (mapping.generated_position.column > size.column) {
+            throw(std::runtime_error("prepend sourcemap has illegal column"));
+          }
         }
       }
     }
     // adjust the buffer offset
     prepend(Offset(out.buffer));
-    // now add the new mappings
-    VECTOR_UNSHIFT(mappings, out.smap.mappings);
+    // now add the new mappings as the first run
+    close_run();
+    Run head(mappings.size(), Offset(0, 0));
+    for (size_t r = 0; r < smap.runs.size(); ++r) {
+      for (size_t i = smap.runs[r].begin, L = smap.run_end(r); i < L; ++i) {
+        mappings.push_back(smap.moved(smap.runs[r], i));
+      }
+    }
+    head.end = mappings.size();
+    if (head.end == head.begin) return;
+    // the open run is still empty
+    runs.back().begin = mappings.size();
+    runs.insert(runs.begin(), head);
   }
 
   void SourceMap::append(const OutputBuffer& out)
@@ -150,14 +294,10 @@ namespace Sass {
   void SourceMap::prepend(const Offset& offset)
   {
     if (offset.line != 0 || offset.column != 0) {
-      for (Mapping& mapping : mappings) {
-        // move stuff on the first old line
-        if (mapping.generated_position.line == 0) {
-          mapping.generated_position.column += offset.column;
-        }
-        // make place for the new lines
-        mapping.generated_position.line += offset.line;
-      }
+      // text in front of earlier prepends moves them as well
+      for (Run& run : runs) run.offset = offset + run.offset;
+      // mappings added later are at their final position
+      close_run();
     }
     if (current_position.line == 0) {
       current_position.column += offset.column;
@@ -170,6 +310,11 @@ namespace Sass {
     current_position += offset;
   }
 
+  void SourceMap::append(const char* begin, const char* end)
+  {
+    current_position.add(begin, end);
+  }
+
   void SourceMap::add_open_mapping(const AST_Node_Ptr node)
   {
     mappings.push_back(Mapping(node->pstate(), current_position));
@@ -181,15 +326,52 @@ namespace Sass {
   }
 
   ParserState SourceMap::remap(const ParserState& pstate) {
-    for (size_t i = 0; i < mappings.size(); ++i) {
-      if (
-        mappings[i].generated_position.file == pstate.file &&
-        mappings[i].generated_position.line == pstate.line &&
-        mappings[i].generated_position.column == pstate.column
-      ) return ParserState(pstate.path, pstate.src, mappings[i].original_position, pstate.offset);
+    for (size_t r = 0; r < runs.size(); ++r) {
+      size_t i = search(r, pstate, false), L = run_end(r);
+      for (; i < L; ++i) {
+        Mapping mapping(moved(runs[r], i));
+        if (
+          mapping.generated_position.line != pstate.line ||
+          mapping.generated_position.column != pstate.column
+        ) break;
+        if (mapping.generated_position.file == pstate.file)
+          return ParserState(pstate.path, pstate.src, mapping.original_position, pstate.offset);
+      }
+      // later runs are behind this one
+      if (i < L) break;
     }
     return ParserState(pstate.path, pstate.src, Position(-1, -1, -1), Offset(0, 0));
 
   }
 
+  bool SourceMap::find(const Offset& generated, Mapping& mapping) const
+  {
+    for (size_t r = runs.size(); r > 0; --r) {
+      size_t i = search(r - 1, generated, true);
+      // all of the run is behind the position
+      if (i == runs[r - 1].begin) continue;
+      mapping = moved(runs[r - 1], i - 1);
+      if (mapping.generated_position.line != generated.line) return false;
+      mapping.original_position.file = source_id(mapping.original_position.file);
+      return true;
+    }
+    return false;
+  }
+
+  size_t SourceMap::copy_mappings(struct Sass_Source_Mapping* out, size_t size) const
+  {
+    size_t n = 0;
+    for (size_t r = 0; r < runs.size(); ++r) {
+      for (size_t i = runs[r].begin, L = run_end(r); i < L && n < size; ++i, ++n) {
+        const Mapping mapping(moved(runs[r], i));
+        out[n].generated_line = mapping.generated_position.line;
+        out[n].generated_column = mapping.generated_position.column;
+        out[n].source = source_id(mapping.original_position.file);
+        out[n].source_line = mapping.original_position.line;
+        out[n].source_column = mapping.original_position.column;
+      }
+    }
+    return mappings.size();
+  }
+
 }
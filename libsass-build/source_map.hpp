@@ -1,16 +1,17 @@
 #ifndef SASS_SOURCE_MAP_H
 #define SASS_SOURCE_MAP_H
 
+#include <map>
 #include <string>
 #include <vector>
 
+#include "sass/context.h"
 #include "ast_fwd_decl.hpp"
 #include "base64vlq.hpp"
 #include "position.hpp"
 #include "mapping.hpp"
 
 #define VECTOR_PUSH(vec, ins) vec.insert(vec.end(), ins.begin(), ins.end())
-#define VECTOR_UNSHIFT(vec, ins) vec.insert(vec.begin(), ins.begin(), ins.end())
 
 namespace Sass {
 
@@ -21,10 +22,17 @@ namespace Sass {
 
   public:
     std::vector<size_t> source_index;
+    // sheets from the cache have their own source ids
+    std::map<size_t, size_t> source_ids;
+    // links of the sources, only set on maps
+    // handed out to outlive their context
+    std::vector<std::string> sources;
     SourceMap();
     SourceMap(const std::string& file);
 
     void append(const Offset& offset);
+    // account for the text between begin and end
+    void append(const char* begin, const char* end);
     void prepend(const Offset& offset);
     void append(const OutputBuffer& out);
     void prepend(const OutputBuffer& out);
@@ -33,12 +41,44 @@ namespace Sass {
 
     std::string render_srcmap(Context &ctx);
     ParserState remap(const ParserState& pstate);
+    // closest mapping at or before the generated position
+    // on the same line (with the source index resolved)
+    bool find(const Offset& generated, Mapping& mapping) const;
+    // copy at most `size` mappings in order, returns the count
+    size_t copy_mappings(struct Sass_Source_Mapping* out, size_t size) const;
 
   private:
 
-    std::string serialize_mappings();
+    // append the VLQ segments of all mappings
+    void serialize_mappings(std::string& out);
+
+    // Mappings are added in the order of the generated code, so
+    // runs are sorted by generated position and can be searched.
+    // Text prepended to the output moves all mappings behind it.
+    // Instead of moving them one by one, mappings are kept in runs
+    // with the offset still to be applied to them. Runs are in the
+    // order of the generated code, the last one is still open and
+    // gets all mappings added from now on.
+    struct Run {
+      size_t begin;
+      size_t end;
+      Offset offset;
+      Run(size_t begin, const Offset& offset)
+      : begin(begin), end(begin), offset(offset) { }
+    };
+    // end of the run at the given position
+    size_t run_end(size_t r) const;
+    // mapping at index `i` moved by the offset of its run
+    Mapping moved(const Run& run, size_t i) const;
+    // stop adding to the open run
+    void close_run();
+    // first mapping of the run generated at (or
+    // behind if `after` is set) the given position
+    size_t search(size_t r, const Offset& position, bool after) const;
+    size_t source_id(size_t file) const;
 
     std::vector<Mapping> mappings;
+    std::vector<Run> runs;
     Position current_position;
 public:
     std::string file;
@@ -4,45 +4,103 @@
 
 namespace Sass {
 
+  uint64_t Subset_Map::signature(Symbol symbol)
+  {
+    // symbols are aligned heap pointers
+    return uint64_t(1) << ((reinterpret_cast<uintptr_t>(symbol) >> 4) & 63);
+  }
+
+  // the rendering is owned by the index (pointers stay valid)
+  Symbol Subset_Map::key_symbol(const Simple_Selector_Obj& simple)
+  {
+    if (Symbol symbol = simple->symbol()) return symbol;
+    return &*renderings_.insert(simple->to_string()).first;
+  }
+
+  // 0 if no key contains the selector
+  Symbol Subset_Map::query_symbol(const Simple_Selector_Obj& simple)
+  {
+    if (Symbol symbol = simple->symbol()) return symbol;
+    auto it = renderings_.find(simple->to_string());
+    return it == renderings_.end() ? 0 : &*it;
+  }
+
   void Subset_Map::put(const Compound_Selector_Obj& sel, const SubSetMapPair& value)
   {
     if (sel->empty()) throw std::runtime_error("internal error: subset map keys may not be empty");
-    size_t index = values_.size();
     values_.push_back(value);
-    for (size_t i = 0, S = sel->length(); i < S; ++i)
-    {
-      hash_[(*sel)[i]].push_back(std::make_pair(sel, index));
+    keys_.push_back(sel);
+    dirty_ = true;
+  }
+
+  void Subset_Map::clear()
+  {
+    values_.clear();
+    keys_.clear();
+    index_.clear();
+    symbols_.clear();
+    buckets_.clear();
+    renderings_.clear();
+    dirty_ = false;
+  }
+
+  void Subset_Map::build()
+  {
+    index_.clear();
+    symbols_.clear();
+    buckets_.clear();
+    renderings_.clear();
+    for (size_t i = 0, S = keys_.size(); i < S; ++i) {
+      Key key = { 0, symbols_.size(), 0, i };
+      for (const Simple_Selector_Obj& simple : keys_[i]->elements()) {
+        symbols_.push_back(key_symbol(simple));
+      }
+      std::sort(symbols_.begin() + key.begin, symbols_.end());
+      symbols_.erase(std::unique(symbols_.begin() + key.begin, symbols_.end()), symbols_.end());
+      key.end = symbols_.size();
+      for (size_t n = key.begin; n < key.end; ++n) key.signature |= signature(symbols_[n]);
+      // a superset of the key contains any of its symbols
+      buckets_[symbols_[key.begin]].push_back(index_.size());
+      index_.push_back(key);
     }
+    dirty_ = false;
   }
 
   std::vector<SubSetMapPair> Subset_Map::get_kv(const Compound_Selector_Obj& sel)
   {
-    SimpleSelectorDict dict(sel->begin(), sel->end()); // XXX Set
-    std::vector<size_t> indices;
-    for (size_t i = 0, S = sel->length(); i < S; ++i) {
-      if (!hash_.count((*sel)[i])) {
-        continue;
-      }
-      const std::vector<std::pair<Compound_Selector_Obj, size_t> >& subsets = hash_[(*sel)[i]];
-      for (const std::pair<Compound_Selector_Obj, size_t>& item : subsets) {
-        bool include = true;
-        for (const Simple_Selector_Obj& it : item.first->elements()) {
-          auto found = dict.find(it);
-          if (found == dict.end()) {
-            include = false;
-            break;
-          }
+    if (dirty_) build();
+    uint64_t mask = 0;
+    query_.clear();
+    for (const Simple_Selector_Obj& simple : sel->elements()) {
+      // not part of any key, so it can not make a difference
+      Symbol symbol = query_symbol(simple);
+      if (symbol == 0) continue;
+      query_.push_back(symbol);
+      mask |= signature(symbol);
+    }
+    std::sort(query_.begin(), query_.end());
+    query_.erase(std::unique(query_.begin(), query_.end()), query_.end());
+
+    found_.clear();
+    for (Symbol symbol : query_) {
+      auto bucket = buckets_.find(symbol);
+      if (bucket == buckets_.end()) continue;
+      for (size_t i : bucket->second) {
+        const Key& key = index_[i];
+        if (key.signature & ~mask) continue;
+        if (std::includes(query_.begin(), query_.end(),
+                          symbols_.begin() + key.begin,
+                          symbols_.begin() + key.end)) {
+          found_.push_back(key.index);
         }
-        if (include) indices.push_back(item.second);
       }
     }
-    sort(indices.begin(), indices.end());
-    std::vector<size_t>::iterator indices_end = unique(indices.begin(), indices.end());
-    indices.resize(distance(indices.begin(), indices_end));
+    std::sort(found_.begin(), found_.end());
 
     std::vector<SubSetMapPair> results;
-    for (size_t i = 0, S = indices.size(); i < S; ++i) {
-      results.push_back(values_[indices[i]]);
+    results.reserve(found_.size());
+    for (size_t index : found_) {
+      results.push_back(values_[index]);
     }
     return results;
   }
@@ -52,4 +110,4 @@ namespace Sass {
     return get_kv(sel);
   }
 
-}
\ No newline at end of file
+}
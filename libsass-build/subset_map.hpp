@@ -6,7 +6,11 @@
 #include <vector>
 #include <algorithm>
 #include <iterator>
+#include <stdint.h>
+#include <unordered_map>
+#include <unordered_set>
 
+#include "symbol.hpp"
 #include "ast_fwd_decl.hpp"
 
 
@@ -58,17 +62,45 @@
 
 namespace Sass {
 
+  // Maps compound selectors to the extensions registered for them. A
+  // lookup returns every value whose key is a subset of the given
+  // compound. Simple selectors are compared by their interned symbol
+  // and each key carries a 64 bit signature of its symbols, so most
+  // keys are rejected by a mask check. The index is built once, on the
+  // first lookup after a put, and each key is filed under one of its
+  // symbols only, so no result has to be deduplicated. Selectors
+  // with arguments are not interned, the index gives them symbols
+  // of its own instead (see `Simple_Selector::symbol`).
   class Subset_Map {
   private:
+    struct Key {
+      uint64_t signature;
+      size_t begin, end; // range in symbols_
+      size_t index; // of the value
+    };
     std::vector<SubSetMapPair> values_;
-    std::map<Simple_Selector_Obj, std::vector<std::pair<Compound_Selector_Obj, size_t> >, OrderNodes > hash_;
+    std::vector<Compound_Selector_Obj> keys_;
+    // index built from the keys
+    bool dirty_;
+    std::vector<Key> index_;
+    std::vector<Symbol> symbols_;
+    std::unordered_map<Symbol, std::vector<size_t>> buckets_;
+    std::unordered_set<std::string> renderings_;
+    // scratch space of lookups
+    std::vector<Symbol> query_;
+    std::vector<size_t> found_;
+    void build();
+    Symbol key_symbol(const Simple_Selector_Obj& simple);
+    Symbol query_symbol(const Simple_Selector_Obj& simple);
+    static uint64_t signature(Symbol symbol);
   public:
+    Subset_Map() : dirty_(false) { }
     void put(const Compound_Selector_Obj& sel, const SubSetMapPair& value);
     std::vector<SubSetMapPair> get_kv(const Compound_Selector_Obj& s);
     std::vector<SubSetMapPair> get_v(const Compound_Selector_Obj& s);
     bool empty() { return values_.empty(); }
-    void clear() { values_.clear(); hash_.clear(); }
-    const std::vector<SubSetMapPair> values(void) { return values_; }
+    void clear();
+    const std::vector<SubSetMapPair>& values(void) { return values_; }
   };
 
 }
@@ -0,0 +1,138 @@
+#include "sass.hpp"
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <functional>
+
+#include "symbol.hpp"
+
+namespace Sass {
+
+  // Open addressing table of interned names. Slots are only ever
+  // filled, never cleared, and a grown table replaces the old one
+  // which is kept alive for readers that are still probing it. A
+  // miss in an old table is retried under the lock. A table with a
+  // limit interns no more names once it holds that many.
+  class Symbol_Table {
+  private:
+    struct Slots {
+      size_t mask;
+      std::atomic<Symbol>* slots;
+    };
+    std::atomic<Slots*> current;
+    std::mutex mutex;
+    size_t count;
+    size_t limit;
+    std::vector<Slots*> retired;
+
+    static Slots* make_slots(size_t capacity)
+    {
+      Slots* table = new Slots();
+      table->mask = capacity - 1;
+      table->slots = new std::atomic<Symbol>[capacity];
+      for (size_t i = 0; i < capacity; ++i) table->slots[i].store(0);
+      return table;
+    }
+
+    static Symbol probe(Slots* table, const std::string& name, size_t hash)
+    {
+      for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+        Symbol symbol = table->slots[i].load(std::memory_order_acquire);
+        if (symbol == 0 || *symbol == name) return symbol;
+      }
+    }
+
+    static void insert(Slots* table, Symbol symbol, size_t hash)
+    {
+      size_t i = hash & table->mask;
+      while (table->slots[i].load(std::memory_order_relaxed)) i = (i + 1) & table->mask;
+      table->slots[i].store(symbol, std::memory_order_release);
+    }
+
+  public:
+    Symbol_Table(size_t limit = 0)
+    : current(make_slots(256)), mutex(), count(0), limit(limit), retired()
+    { }
+
+    // a bound name was interned before, so it is in the current table
+    Symbol find(const std::string& name)
+    {
+      size_t hash = std::hash<std::string>()(name);
+      return probe(current.load(std::memory_order_acquire), name, hash);
+    }
+
+    Symbol intern(const std::string& name)
+    {
+      size_t hash = std::hash<std::string>()(name);
+      Symbol symbol = probe(current.load(std::memory_order_acquire), name, hash);
+      if (symbol) return symbol;
+      std::lock_guard<std::mutex> lock(mutex);
+      Slots* table = current.load(std::memory_order_relaxed);
+      symbol = probe(table, name, hash);
+      if (symbol) return symbol;
+      if (limit && count >= limit) return 0;
+      // keep the load factor below one half
+      if ((count + 1) * 2 > table->mask + 1) {
+        Slots* grown = make_slots((table->mask + 1) * 2);
+        for (size_t i = 0; i <= table->mask; ++i) {
+          Symbol old = table->slots[i].load(std::memory_order_relaxed);
+          if (old) insert(grown, old, std::hash<std::string>()(*old));
+        }
+        current.store(grown, std::memory_order_release);
+        retired.push_back(table);
+        table = grown;
+      }
+      // names live as long as the process
+      symbol = new std::string(name);
+      insert(table, symbol, hash);
+      ++ count;
+      return symbol;
+    }
+
+  };
+
+  static Symbol_Table& symbol_table(size_t ns)
+  {
+    static Symbol_Table tables[3];
+    return tables[ns];
+  }
+
+  Symbol variable_symbol(const std::string& name)
+  {
+    return symbol_table(0).intern(name);
+  }
+
+  Symbol function_symbol(const std::string& name)
+  {
+    return symbol_table(1).intern(name);
+  }
+
+  Symbol mixin_symbol(const std::string& name)
+  {
+    return symbol_table(2).intern(name);
+  }
+
+  // generated class names (`.col-#{$i}`) are endless
+  // in a long running process, so their table is bounded
+  Symbol selector_symbol(const std::string& name)
+  {
+    static Symbol_Table table(1 << 16);
+    return table.intern(name);
+  }
+
+  Symbol find_variable_symbol(const std::string& name)
+  {
+    return symbol_table(0).find(name);
+  }
+
+  Symbol find_function_symbol(const std::string& name)
+  {
+    return symbol_table(1).find(name);
+  }
+
+  Symbol find_mixin_symbol(const std::string& name)
+  {
+    return symbol_table(2).find(name);
+  }
+
+}
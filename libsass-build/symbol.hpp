@@ -0,0 +1,33 @@
+#ifndef SASS_SYMBOL_H
+#define SASS_SYMBOL_H
+
+#include <string>
+
+namespace Sass {
+
+  // An interned name. Equal names of the same namespace share the
+  // same address, so symbols are compared and hashed by pointer.
+  // Variables, functions and mixins are interned in separate tables,
+  // `foo` the function and `foo` the mixin are different symbols.
+  // Tables are process wide since the frame of built-in functions is
+  // shared by all contexts. Known names are found without locking.
+  typedef const std::string* Symbol;
+
+  // variables and any other plain environment key
+  Symbol variable_symbol(const std::string& name);
+  // functions (and resolved overloads of them)
+  Symbol function_symbol(const std::string& name);
+  Symbol mixin_symbol(const std::string& name);
+  // rendered selectors, see Simple_Selector::symbol, 0 once
+  // the table is full and the name was not interned before
+  Symbol selector_symbol(const std::string& name);
+
+  // the same without interning, 0 if the name is not known yet
+  // (nothing can be bound to it), for lookups of user strings
+  Symbol find_variable_symbol(const std::string& name);
+  Symbol find_function_symbol(const std::string& name);
+  Symbol find_mixin_symbol(const std::string& name);
+
+}
+
+#endif
@@ -1,5 +1,9 @@
 #include "sass.hpp"
+#include <deque>
+#include <mutex>
 #include <stdexcept>
+#include <algorithm>
+#include <unordered_map>
 #include "units.hpp"
 #include "error_handling.hpp"
 
@@ -174,6 +178,134 @@ namespace Sass {
     return "CUSTOM:" + s;
   }
 
+  // all units we have seen so far
+  class Unit_Table {
+  public:
+    // filled once, read without locking
+    std::unordered_map<std::string, Unit_Id> known_ids;
+    std::vector<std::string> known_names;
+    std::vector<UnitType> known_types;
+    // custom units, never removed
+    std::mutex mutex;
+    std::unordered_map<std::string, Unit_Id> ids;
+    std::deque<std::string> names;
+  public:
+    Unit_Table()
+    {
+      static const char* const common[] = {
+        "px", "pt", "pc", "mm", "cm", "in",
+        "deg", "grad", "rad", "turn",
+        "s", "ms", "Hz", "kHz",
+        "dpi", "dpcm", "dppx",
+        "%", "em", "rem", "ex", "ch",
+        "vw", "vh", "vmin", "vmax", "fr"
+      };
+      for (const char* unit : common) {
+        known_ids[unit] = static_cast<Unit_Id>(known_names.size());
+        known_names.push_back(unit);
+        known_types.push_back(string_to_unit(unit));
+      }
+    }
+  };
+
+  static Unit_Table& unit_table()
+  {
+    static Unit_Table table;
+    return table;
+  }
+
+  Unit_Id unit_to_id(const std::string& unit)
+  {
+    Unit_Table& table = unit_table();
+    auto known = table.known_ids.find(unit);
+    if (known != table.known_ids.end()) return known->second;
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.ids.find(unit);
+    if (it != table.ids.end()) return it->second;
+    Unit_Id id = static_cast<Unit_Id>(table.known_names.size() + table.names.size());
+    table.names.push_back(unit);
+    table.ids[unit] = id;
+    return id;
+  }
+
+  const std::string& id_to_unit(Unit_Id id)
+  {
+    Unit_Table& table = unit_table();
+    if (id < table.known_names.size()) return table.known_names[id];
+    // deque never moves its items
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.names[id - table.known_names.size()];
+  }
+
+  UnitType id_to_type(Unit_Id id)
+  {
+    Unit_Table& table = unit_table();
+    if (id < table.known_types.size()) return table.known_types[id];
+    return UnitType::UNKNOWN;
+  }
+
+  Unit_List& Unit_List::operator= (const Unit_List& units)
+  {
+    if (this == &units) return *this;
+    size_ = units.size_;
+    first_ = units.first_;
+    if (size_ > 1 && !rest_) rest_ = new std::vector<Unit_Id>();
+    if (size_ > 1) *rest_ = *units.rest_;
+    else if (rest_) rest_->clear();
+    return *this;
+  }
+
+  void Unit_List::push_back(Unit_Id id)
+  {
+    if (size_ ++ == 0) { first_ = id; return; }
+    if (!rest_) rest_ = new std::vector<Unit_Id>();
+    rest_->push_back(id);
+  }
+
+  void Unit_List::erase(size_t i)
+  {
+    if (i == 0 && size_ > 1) first_ = rest_->front();
+    if (size_ > 1) rest_->erase(rest_->begin() + (i ? i - 1 : 0));
+    -- size_;
+  }
+
+  void Unit_List::append(const Unit_List& units)
+  {
+    for (size_t i = 0, L = units.size(); i < L; ++i) push_back(units[i]);
+  }
+
+  static bool unit_name_less(Unit_Id lhs, Unit_Id rhs)
+  {
+    return id_to_unit(lhs) < id_to_unit(rhs);
+  }
+
+  void Unit_List::sort()
+  {
+    if (size_ < 2) return;
+    rest_->insert(rest_->begin(), first_);
+    std::sort(rest_->begin(), rest_->end(), unit_name_less);
+    first_ = rest_->front();
+    rest_->erase(rest_->begin());
+  }
+
+  bool Unit_List::operator== (const Unit_List& rhs) const
+  {
+    if (size_ != rhs.size_) return false;
+    for (size_t i = 0; i < size_; ++i) {
+      if ((*this)[i] != rhs[i]) return false;
+    }
+    return true;
+  }
+
+  bool Unit_List::operator< (const Unit_List& rhs) const
+  {
+    for (size_t i = 0; i < size_ && i < rhs.size_; ++i) {
+      if (name(i) < rhs.name(i)) return true;
+      if (rhs.name(i) < name(i)) return false;
+    }
+    return size_ < rhs.size_;
+  }
+
   // throws incompatibleUnits exceptions
   double conversion_factor(const std::string& s1, const std::string& s2)
   {
@@ -189,6 +321,21 @@ namespace Sass {
     return conversion_factor(u1, u2, t1, t2);
   }
 
+  // throws incompatibleUnits exceptions
+  double conversion_factor(Unit_Id id1, Unit_Id id2)
+  {
+    // assert for same units
+    if (id1 == id2) return 1;
+    // get unit enum from id
+    UnitType u1 = id_to_type(id1);
+    UnitType u2 = id_to_type(id2);
+    // query unit group types
+    UnitClass t1 = get_unit_type(u1);
+    UnitClass t2 = get_unit_type(u2);
+    // return the conversion factor
+    return conversion_factor(u1, u2, t1, t2);
+  }
+
   // throws incompatibleUnits exceptions
   double conversion_factor(UnitType u1, UnitType u2, UnitClass t1, UnitClass t2)
   {
@@ -217,7 +364,7 @@ namespace Sass {
     return 0;
   }
 
-  double convert_units(const std::string& lhs, const std::string& rhs, int& lhsexp, int& rhsexp)
+  double convert_units(Unit_Id lhs, Unit_Id rhs, int& lhsexp, int& rhsexp)
   {
     double f = 0;
     // do not convert same ones
@@ -226,8 +373,8 @@ namespace Sass {
     if (lhsexp == 0) return 0;
     if (rhsexp == 0) return 0;
     // check if it can be converted
-    UnitType ulhs = string_to_unit(lhs);
-    UnitType urhs = string_to_unit(rhs);
+    UnitType ulhs = id_to_type(lhs);
+    UnitType urhs = id_to_type(rhs);
     // skip units we cannot convert
     if (ulhs == UNKNOWN) return 0;
     if (urhs == UNKNOWN) return 0;
@@ -277,33 +424,31 @@ namespace Sass {
     double factor = 1;
 
     for (size_t i = 0; i < iL; i++) {
-      std::string &lhs = numerators[i];
-      UnitType ulhs = string_to_unit(lhs);
+      UnitType ulhs = id_to_type(numerators[i]);
       if (ulhs == UNKNOWN) continue;
       UnitClass clhs = get_unit_type(ulhs);
       UnitType umain = get_main_unit(clhs);
       if (ulhs == umain) continue;
       double f(conversion_factor(umain, ulhs, clhs, clhs));
       if (f == 0) throw std::runtime_error("INVALID");
-      numerators[i] = unit_to_string(umain);
+      numerators.set(i, unit_to_id(unit_to_string(umain)));
       factor /= f;
     }
 
     for (size_t n = 0; n < nL; n++) {
-      std::string &rhs = denominators[n];
-      UnitType urhs = string_to_unit(rhs);
+      UnitType urhs = id_to_type(denominators[n]);
       if (urhs == UNKNOWN) continue;
       UnitClass crhs = get_unit_type(urhs);
       UnitType umain = get_main_unit(crhs);
       if (urhs == umain) continue;
       double f(conversion_factor(umain, urhs, crhs, crhs));
       if (f == 0) throw std::runtime_error("INVALID");
-      denominators[n] = unit_to_string(umain);
+      denominators.set(n, unit_to_id(unit_to_string(umain)));
       factor /= f;
     }
 
-    std::sort (numerators.begin(), numerators.end());
-    std::sort (denominators.begin(), denominators.end());
+    numerators.sort();
+    denominators.sort();
 
     // return for conversion
     return factor;
@@ -319,24 +464,35 @@ namespace Sass {
     if (iL + nL < 2) return 1;
 
     // first make sure same units cancel each other out
-    // it seems that a map table will fit nicely to do this
     // we basically construct exponents for each unit
-    // has the advantage that they will be pre-sorted
-    std::map<std::string, int> exponents;
+    // and sort them by name once we are done
+    std::vector<std::pair<Unit_Id, int>> exponents;
 
     // initialize by summing up occurences in unit vectors
     // this will already cancel out equivalent units (e.q. px/px)
-    for (size_t i = 0; i < iL; i ++) exponents[numerators[i]] += 1;
-    for (size_t n = 0; n < nL; n ++) exponents[denominators[n]] -= 1;
+    for (size_t i = 0; i < iL + nL; i ++) {
+      Unit_Id id = i < iL ? numerators[i] : denominators[i - iL];
+      size_t e = 0;
+      while (e < exponents.size() && exponents[e].first != id) ++ e;
+      if (e == exponents.size()) exponents.push_back(std::make_pair(id, 0));
+      exponents[e].second += i < iL ? 1 : -1;
+    }
 
     // the final conversion factor
     double factor = 1;
 
+    // exponent of a unit we have already seen
+    auto exponent_of = [&exponents](Unit_Id id) -> int& {
+      size_t e = 0;
+      while (exponents[e].first != id) ++ e;
+      return exponents[e].second;
+    };
+
     // convert between compatible units
     for (size_t i = 0; i < iL; i++) {
       for (size_t n = 0; n < nL; n++) {
-        std::string &lhs = numerators[i], &rhs = denominators[n];
-        int &lhsexp = exponents[lhs], &rhsexp = exponents[rhs];
+        Unit_Id lhs = numerators[i], rhs = denominators[n];
+        int &lhsexp = exponent_of(lhs), &rhsexp = exponent_of(rhs);
         double f(convert_units(lhs, rhs, lhsexp, rhsexp));
         if (f == 0) continue;
         factor /= f;
@@ -348,6 +504,10 @@ namespace Sass {
     denominators.clear();
 
     // recreate sorted units vectors
+    std::sort(exponents.begin(), exponents.end(),
+      [](const std::pair<Unit_Id, int>& lhs, const std::pair<Unit_Id, int>& rhs) {
+        return unit_name_less(lhs.first, rhs.first);
+      });
     for (auto exp : exponents) {
       int &exponent = exp.second;
       while (exponent > 0 && exponent --)
@@ -368,12 +528,12 @@ namespace Sass {
     size_t nL = denominators.size();
     for (size_t i = 0; i < iL; i += 1) {
       if (i) u += '*';
-      u += numerators[i];
+      u += numerators.name(i);
     }
     if (nL != 0) u += '/';
     for (size_t n = 0; n < nL; n += 1) {
       if (n) u += '*';
-      u += denominators[n];
+      u += denominators.name(n);
     }
     return u;
   }
@@ -394,14 +554,14 @@ namespace Sass {
   double Units::convert_factor(const Units& r) const
   {
 
-    std::vector<std::string> miss_nums(0);
-    std::vector<std::string> miss_dens(0);
+    size_t miss_nums = 0;
+    size_t miss_dens = 0;
     // create copy since we need these for state keeping
-    std::vector<std::string> r_nums(r.numerators);
-    std::vector<std::string> r_dens(r.denominators);
+    Unit_List r_nums(r.numerators);
+    Unit_List r_dens(r.denominators);
 
-    auto l_num_it = numerators.begin();
-    auto l_num_end = numerators.end();
+    size_t l_num_it = 0;
+    size_t l_num_end = numerators.size();
 
     bool l_unitless = is_unitless();
     auto r_unitless = r.is_unitless();
@@ -413,16 +573,16 @@ namespace Sass {
     while (l_num_it != l_num_end)
     {
       // get and increment afterwards
-      const std::string l_num = *(l_num_it ++);
+      const Unit_Id l_num = numerators[l_num_it ++];
 
-      auto r_num_it = r_nums.begin(), r_num_end = r_nums.end();
+      size_t r_num_it = 0, r_num_end = r_nums.size();
 
       bool found = false;
       // search for compatible numerator
       while (r_num_it != r_num_end)
       {
         // get and increment afterwards
-        const std::string r_num = *(r_num_it);
+        const Unit_Id r_num = r_nums[r_num_it];
         // get possible conversion factor for units
         double conversion = conversion_factor(l_num, r_num);
         // skip incompatible numerator
@@ -440,27 +600,27 @@ namespace Sass {
       }
       // maybe we did not find any
       // left numerator is leftover
-      if (!found) miss_nums.push_back(l_num);
+      if (!found) ++ miss_nums;
     }
 
-    auto l_den_it = denominators.begin();
-    auto l_den_end = denominators.end();
+    size_t l_den_it = 0;
+    size_t l_den_end = denominators.size();
 
     // process all left denominators
     while (l_den_it != l_den_end)
     {
       // get and increment afterwards
-      const std::string l_den = *(l_den_it ++);
+      const Unit_Id l_den = denominators[l_den_it ++];
 
-      auto r_den_it = r_dens.begin();
-      auto r_den_end = r_dens.end();
+      size_t r_den_it = 0;
+      size_t r_den_end = r_dens.size();
 
       bool found = false;
       // search for compatible denominator
       while (r_den_it != r_den_end)
       {
         // get and increment afterwards
-        const std::string r_den = *(r_den_it);
+        const Unit_Id r_den = r_dens[r_den_it];
         // get possible converstion factor for units
         double conversion = conversion_factor(l_den, r_den);
         // skip incompatible denominator
@@ -478,14 +638,14 @@ namespace Sass {
       }
       // maybe we did not find any
       // left denominator is leftover
-      if (!found) miss_dens.push_back(l_den);
+      if (!found) ++ miss_dens;
     }
 
     // check left-overs (ToDo: might cancel out?)
-    if (miss_nums.size() > 0 && !r_unitless) {
+    if (miss_nums > 0 && !r_unitless) {
       throw Exception::IncompatibleUnits(r, *this);
     }
-    else if (miss_dens.size() > 0 && !r_unitless) {
+    else if (miss_dens > 0 && !r_unitless) {
       throw Exception::IncompatibleUnits(r, *this);
     }
     else if (r_nums.size() > 0 && !l_unitless) {
@@ -53,10 +53,54 @@ namespace Sass {
 
   };
 
+  // units are interned process wide, ids never change
+  typedef unsigned int Unit_Id;
+
+  // intern the unit (known and common css units never lock)
+  Unit_Id unit_to_id(const std::string& unit);
+  // name of an interned unit
+  const std::string& id_to_unit(Unit_Id id);
+  // known unit type of an interned unit
+  UnitType id_to_type(Unit_Id id);
+
+  // unit ids of a number, the first one is stored inline
+  // so numbers with a single unit (or none) never allocate
+  class Unit_List {
+  private:
+    unsigned int size_;
+    Unit_Id first_;
+    // all units after the first one
+    std::vector<Unit_Id>* rest_;
+  public:
+    Unit_List() : size_(0), first_(0), rest_(0) { }
+    Unit_List(const Unit_List& units)
+    : size_(units.size_), first_(units.first_),
+      rest_(units.size_ > 1 ? new std::vector<Unit_Id>(*units.rest_) : 0)
+    { }
+    Unit_List& operator= (const Unit_List& units);
+    ~Unit_List() { delete rest_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    void clear() { size_ = 0; if (rest_) rest_->clear(); }
+    Unit_Id operator[](size_t i) const { return i ? (*rest_)[i - 1] : first_; }
+    const std::string& name(size_t i) const { return id_to_unit((*this)[i]); }
+    void set(size_t i, Unit_Id id) { if (i) (*rest_)[i - 1] = id; else first_ = id; }
+    void push_back(Unit_Id id);
+    void push_back(const std::string& unit) { push_back(unit_to_id(unit)); }
+    void erase(size_t i);
+    void append(const Unit_List& units);
+    // sort by name
+    void sort();
+    // compares ids, names are unique
+    bool operator== (const Unit_List& rhs) const;
+    // compares names
+    bool operator< (const Unit_List& rhs) const;
+  };
+
   class Units {
   public:
-    std::vector<std::string> numerators;
-    std::vector<std::string> denominators;
+    Unit_List numerators;
+    Unit_List denominators;
   public:
     // default constructor
     Units() :
@@ -101,8 +145,9 @@ namespace Sass {
   std::string unit_to_class(const std::string&);
   // throws incompatibleUnits exceptions
   double conversion_factor(const std::string&, const std::string&);
+  double conversion_factor(Unit_Id, Unit_Id);
   double conversion_factor(UnitType, UnitType, UnitClass, UnitClass);
-  double convert_units(const std::string&, const std::string&, int&, int&);
+  double convert_units(Unit_Id, Unit_Id, int&, int&);
 
 }
 
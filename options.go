@@ -166,6 +166,34 @@ func Payload(load context.Context) FuncOpt {
 	}
 }
 
+// WithSheetCache reuses the Sass files parsed by earlier compiles
+// sharing the same cache
+func WithSheetCache(cache *SheetCache) FuncOpt {
+	return func(c *sass) error {
+		c.ctx.SheetCache = cache
+		return nil
+	}
+}
+
+// ImportThreads parses the files imported by the main file on n worker
+// threads. The output is the same as without, 0 disables it.
+func ImportThreads(n int) FuncOpt {
+	return func(c *sass) error {
+		c.ctx.ImportThreads = n
+		return nil
+	}
+}
+
+// StreamOutput writes the css to the output in chunks while libsass
+// renders it, instead of building the whole string in memory first.
+// The output is the same, rendering takes a bit longer.
+func StreamOutput(stream bool) FuncOpt {
+	return func(c *sass) error {
+		c.ctx.StreamOutput = stream
+		return nil
+	}
+}
+
 // Syntax lists that available syntaxes for the compiler
 type Syntax int
 